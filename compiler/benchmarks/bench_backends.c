@@ -0,0 +1,143 @@
+/**
+ * Benchmark of the backends of the generator (see emit.h).
+ *
+ * bench_assembly.lang is generated at build time (`add_generated_scanner`) as a transition table and as
+ * direct-coded C, both scan the corpus into a small token buffer. The runtime cursor
+ * (without line and col counting) is the baseline. The tokens are checked to be the same.
+ *
+ * usage: bench_backends [corpus file] [repetitions]
+ *  without a corpus file, 64 MB of synthetic assembly is scanned
+ */
+
+#include "bench_utils.h"
+
+#include <scanner_utils/runtime.h>
+
+#include "asm_direct.h"
+#include "asm_table.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_CORPUS_SIZE (64 * 1024 * 1024)
+#define BENCH_BUFFER 4096
+
+/**
+ * The generated scanners have the same interface with different prefixes.
+ */
+typedef unsigned int (*bench_scan_fn)(const char *text, unsigned int text_n, unsigned int *text_i,
+                                      void *tokens, unsigned int capacity);
+
+static unsigned int _bench_table_scan(const char *text, unsigned int text_n, unsigned int *text_i,
+                                      void *tokens, unsigned int capacity) {
+    return asm_table_scan(text, text_n, text_i, tokens, capacity);
+}
+
+static unsigned int _bench_direct_scan(const char *text, unsigned int text_n, unsigned int *text_i,
+                                       void *tokens, unsigned int capacity) {
+    return asm_direct_scan(text, text_n, text_i, tokens, capacity);
+}
+
+/**
+ * Scans the whole corpus. If `expected` is not NULL, the tokens are compared with it.
+ * Returns the number of tokens, or 0 if they are different.
+ */
+static unsigned int _bench_generated(const bench_scan_fn scan,
+                                     const char * const corpus,
+                                     const unsigned int n,
+                                     const struct scanner_token_stream * const expected) {
+    struct asm_table_token buffer[BENCH_BUFFER];
+    unsigned int text_i = 0;
+    unsigned int n_tokens = 0;
+
+    while (text_i < n) {
+        const unsigned int n_buffer = scan(corpus, n, &text_i, buffer, BENCH_BUFFER);
+
+        if (expected != NULL) {
+            for (unsigned int i = 0; i < n_buffer; i++) {
+                if (n_tokens + i >= expected->n ||
+                    buffer[i].start != expected->start[n_tokens + i] ||
+                    buffer[i].length != expected->length[n_tokens + i] ||
+                    buffer[i].token != expected->token[n_tokens + i]) {
+                    return 0;
+                }
+            }
+        }
+
+        n_tokens += n_buffer;
+    }
+
+    return n_tokens;
+}
+
+int main(int argc, char **argv) {
+    unsigned int n;
+    char *corpus;
+
+    if (argc > 1) {
+        corpus = bench_read_file(argv[1], &n);
+        if (corpus == NULL) {
+            printf("ERROR: can't read corpus file `%s`\n", argv[1]);
+            return EXIT_FAILURE;
+        }
+    } else {
+        n = BENCH_CORPUS_SIZE;
+        corpus = bench_generate_corpus(n);
+    }
+
+    unsigned int repetitions = argc > 2 ? (unsigned int)atoi(argv[2]) : 3;
+
+    struct scanner_rules *rules = bench_rules_assembly();
+    struct scanner *scanner = scanner_create_from_rules(rules);
+    scanner_rules_destroy(rules);
+
+    struct scanner_cursor *cursor = scanner_cursor_create(scanner);
+    struct scanner_token_stream *expected = scanner_token_stream_create(corpus, n);
+    expected->lazy_positions = 1;
+
+    double baseline = 1e30;
+    for (unsigned int r = 0; r < repetitions; r++) {
+        scanner_token_stream_reset(expected, corpus, n);
+
+        double start = bench_now();
+        scanner_cursor_scan(cursor, corpus, n, expected);
+        double elapsed = bench_now() - start;
+
+        if (elapsed < baseline) {
+            baseline = elapsed;
+        }
+    }
+
+    printf("corpus: %u bytes\n", n);
+    printf("%-16s %8.1f MB/s  %10u tokens\n", "runtime cursor", n / baseline / 1e6, expected->n);
+
+    const char *names[] = {"table backend", "direct backend"};
+    const bench_scan_fn scans[] = {_bench_table_scan, _bench_direct_scan};
+
+    for (unsigned int b = 0; b < 2; b++) {
+        const unsigned char same = _bench_generated(scans[b], corpus, n, expected) == expected->n;
+
+        double best = 1e30;
+        unsigned int n_tokens = 0;
+        for (unsigned int r = 0; r < repetitions; r++) {
+            double start = bench_now();
+            n_tokens = _bench_generated(scans[b], corpus, n, NULL);
+            double elapsed = bench_now() - start;
+
+            if (elapsed < best) {
+                best = elapsed;
+            }
+        }
+
+        printf("%-16s %8.1f MB/s  %10u tokens  x%.2f%s\n",
+               names[b], n / best / 1e6, n_tokens, baseline / best, same ? "" : "  (DIFFERENT TOKENS)");
+    }
+
+    scanner_token_stream_destroy(expected);
+    scanner_cursor_destroy(cursor);
+    scanner_destroy(scanner);
+    free(corpus);
+
+    return 0;
+}
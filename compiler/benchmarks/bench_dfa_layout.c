@@ -0,0 +1,164 @@
+/**
+ * Benchmark of the state numbering of the compiled DFA (see scanner_dfa_renumber_* in dfa.h).
+ * 
+ * Two languages: the assembly language (its table fits in the L1 cache) and a language of
+ * BENCH_N_KEYWORDS keywords spelled out in the DFA (a table of a few MB, bigger than L2).
+ * The same DFA is scanned over the same corpus with four different numberings:
+ *  - construction: the numbering that the rule compilation gives
+ *  - shuffled: a random permutation, the worst case for locality
+ *  - bfs: breadth-first order from the initial state
+ *  - profile: by visit frequency on the first part of the corpus
+ * 
+ * usage: bench_dfa_layout [corpus file] [repetitions]
+ *  without a corpus file, 16 MB of synthetic assembly is scanned,
+ *  the keyword language always scans 16 MB of its synthetic corpus
+ */
+
+#include "bench_utils.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_CORPUS_SIZE (16 * 1024 * 1024)
+#define BENCH_PROFILE_SIZE (256 * 1024)
+#define BENCH_N_KEYWORDS 1024
+
+/**
+ * Maximal munch over the whole corpus, returns the number of tokens.
+ */
+static unsigned int _bench_scan(const struct scanner_dfa * const dfa, const char * const corpus, const unsigned int n) {
+    unsigned int n_tokens = 0;
+    unsigned int start = 0;
+
+    while (start < n) {
+        unsigned short state = dfa->initial_state;
+        unsigned int last_accept_end = start;
+
+        for (unsigned int i = start; i < n; i++) {
+            state = dfa->transition[(unsigned int)state * 256 + (unsigned char)corpus[i]];
+
+            if (state == SCANNER_DFA_STATE_ERROR) {
+                break;
+            }
+            if (dfa->token[state] != 0) {
+                last_accept_end = i + 1;
+            }
+        }
+
+        start = last_accept_end > start ? last_accept_end : start + 1;
+        n_tokens++;
+    }
+
+    return n_tokens;
+}
+
+static void _bench_run(const char * const name,
+                       const struct scanner_dfa * const dfa,
+                       const char * const corpus,
+                       const unsigned int n,
+                       const unsigned int repetitions) {
+    struct bench_counters counters;
+    bench_counters_open(&counters);
+
+    double best = 1e30;
+    unsigned int n_tokens = 0;
+
+    bench_counters_start(&counters);
+    for (unsigned int r = 0; r < repetitions; r++) {
+        double start = bench_now();
+        n_tokens = _bench_scan(dfa, corpus, n);
+        double elapsed = bench_now() - start;
+
+        if (elapsed < best) {
+            best = elapsed;
+        }
+    }
+    bench_counters_stop(&counters);
+
+    printf("%-14s %8.1f MB/s  %10u tokens", name, n / best / 1e6, n_tokens);
+    if (counters.available) {
+        printf("  %12llu cache misses / %llu references",
+               counters.cache_misses / repetitions, counters.cache_references / repetitions);
+    }
+    printf("\n");
+
+    bench_counters_close(&counters);
+}
+
+/**
+ * Scans the corpus with the construction, shuffled, bfs and profile numbering of the DFA.
+ */
+static void _bench_layouts(struct scanner_dfa * const dfa,
+                           const char * const corpus,
+                           const unsigned int n,
+                           const unsigned int repetitions) {
+    printf("corpus: %u bytes, DFA: %d states (%d KB transition table)\n",
+           n, dfa->n_states, dfa->n_states * 256 * (int)sizeof(unsigned short) / 1024);
+
+    _bench_run("construction", dfa, corpus, n, repetitions);
+
+    // random permutation of the non-error states
+    unsigned short *order = malloc(dfa->n_states * sizeof(unsigned short));
+    unsigned int seed = 12345;
+    for (unsigned short i = 0; i < dfa->n_states; i++) {
+        order[i] = i;
+    }
+    for (unsigned short i = dfa->n_states - 1; i > 1; i--) {
+        seed = seed * 1103515245u + 12345u;
+        unsigned short j = 1 + (seed >> 16) % i;
+        unsigned short tmp = order[i];
+        order[i] = order[j];
+        order[j] = tmp;
+    }
+    scanner_dfa_renumber(dfa, order);
+    _bench_run("shuffled", dfa, corpus, n, repetitions);
+
+    scanner_dfa_renumber_bfs(dfa);
+    _bench_run("bfs", dfa, corpus, n, repetitions);
+
+    scanner_dfa_renumber_profile(dfa, corpus, n < BENCH_PROFILE_SIZE ? n : BENCH_PROFILE_SIZE);
+    _bench_run("profile", dfa, corpus, n, repetitions);
+
+    free(order);
+}
+
+int main(int argc, char **argv) {
+    unsigned int n;
+    char *corpus;
+
+    if (argc > 1) {
+        corpus = bench_read_file(argv[1], &n);
+        if (corpus == NULL) {
+            printf("ERROR: can't read corpus file `%s`\n", argv[1]);
+            return EXIT_FAILURE;
+        }
+    } else {
+        n = BENCH_CORPUS_SIZE;
+        corpus = bench_generate_corpus(n);
+    }
+
+    unsigned int repetitions = argc > 2 ? (unsigned int)atoi(argv[2]) : 5;
+
+    printf("assembly\n");
+    struct scanner_rules *rules = bench_rules_assembly();
+    struct scanner_dfa *dfa = scanner_rules_compile(rules, NULL);
+    _bench_layouts(dfa, corpus, n, repetitions);
+
+    scanner_dfa_destroy(dfa);
+    scanner_rules_destroy(rules);
+    free(corpus);
+
+    printf("\n%u keywords\n", BENCH_N_KEYWORDS);
+    n = BENCH_CORPUS_SIZE;
+    corpus = bench_generate_keyword_corpus(n, BENCH_N_KEYWORDS);
+    rules = bench_rules_keywords(BENCH_N_KEYWORDS);
+    dfa = scanner_rules_compile(rules, NULL);
+    _bench_layouts(dfa, corpus, n, repetitions);
+
+    scanner_dfa_destroy(dfa);
+    scanner_rules_destroy(rules);
+    free(corpus);
+
+    return 0;
+}
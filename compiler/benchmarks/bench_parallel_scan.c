@@ -0,0 +1,101 @@
+/**
+ * Benchmark of the parallel scanner (see parallel.h).
+ * 
+ * The corpus is scanned with 1, 2, 4, ... threads up to the number of cores,
+ * the single cursor scan is the baseline. The token streams are checked to be the same.
+ * 
+ * usage: bench_parallel_scan [corpus file] [repetitions]
+ *  without a corpus file, 128 MB of synthetic assembly is scanned
+ */
+
+#include "bench_utils.h"
+
+#include <scanner_utils/parallel.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define BENCH_CORPUS_SIZE (128 * 1024 * 1024)
+
+static double _bench_best(struct scanner_parallel * const parallel,
+                          struct scanner_cursor * const cursor,
+                          const char * const corpus,
+                          const unsigned int n,
+                          struct scanner_token_stream * const stream,
+                          const unsigned int repetitions) {
+    double best = 1e30;
+
+    for (unsigned int r = 0; r < repetitions; r++) {
+        scanner_token_stream_reset(stream, corpus, n);
+
+        double start = bench_now();
+        if (parallel != NULL) {
+            scanner_parallel_scan(parallel, corpus, n, stream);
+        } else {
+            scanner_cursor_scan(cursor, corpus, n, stream);
+        }
+        double elapsed = bench_now() - start;
+
+        if (elapsed < best) {
+            best = elapsed;
+        }
+    }
+
+    return best;
+}
+
+int main(int argc, char **argv) {
+    unsigned int n;
+    char *corpus;
+
+    if (argc > 1) {
+        corpus = bench_read_file(argv[1], &n);
+        if (corpus == NULL) {
+            printf("ERROR: can't read corpus file `%s`\n", argv[1]);
+            return EXIT_FAILURE;
+        }
+    } else {
+        n = BENCH_CORPUS_SIZE;
+        corpus = bench_generate_corpus(n);
+    }
+
+    unsigned int repetitions = argc > 2 ? (unsigned int)atoi(argv[2]) : 3;
+    unsigned int n_cores = (unsigned int)sysconf(_SC_NPROCESSORS_ONLN);
+
+    struct scanner_rules *rules = bench_rules_assembly();
+    struct scanner *scanner = scanner_create_from_rules(rules);
+    scanner_rules_destroy(rules);
+
+    struct scanner_cursor *cursor = scanner_cursor_create(scanner);
+    struct scanner_token_stream *expected = scanner_token_stream_create(corpus, n);
+    struct scanner_token_stream *stream = scanner_token_stream_create(corpus, n);
+
+    double baseline = _bench_best(NULL, cursor, corpus, n, expected, repetitions);
+
+    printf("corpus: %u bytes, %u cores\n", n, n_cores);
+    printf("%-14s %8.1f MB/s  %10u tokens\n", "cursor", n / baseline / 1e6, expected->n);
+
+    for (unsigned int n_threads = 1; n_threads <= n_cores; n_threads *= 2) {
+        struct scanner_parallel *parallel = scanner_parallel_create(scanner, n_threads);
+        double best = _bench_best(parallel, NULL, corpus, n, stream, repetitions);
+
+        unsigned char same = stream->n == expected->n &&
+                             memcmp(stream->start, expected->start, expected->n * sizeof(unsigned int)) == 0 &&
+                             memcmp(stream->position, expected->position, expected->n * sizeof(unsigned long long)) == 0;
+
+        printf("%2u threads     %8.1f MB/s  %10u tokens  x%.2f%s\n",
+               n_threads, n / best / 1e6, stream->n, baseline / best, same ? "" : "  (DIFFERENT TOKENS)");
+
+        scanner_parallel_destroy(parallel);
+    }
+
+    scanner_token_stream_destroy(stream);
+    scanner_token_stream_destroy(expected);
+    scanner_cursor_destroy(cursor);
+    scanner_destroy(scanner);
+    free(corpus);
+
+    return 0;
+}
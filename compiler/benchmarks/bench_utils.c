@@ -0,0 +1,231 @@
+#include "bench_utils.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef __linux__
+    #include <linux/perf_event.h>
+    #include <sys/ioctl.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+char *bench_read_file(const char * const path, unsigned int * const n) {
+    FILE *file = fopen(path, "rb");
+
+    if (file == NULL) {
+        return NULL;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    char *content = malloc(size + 1);
+    *n = fread(content, 1, size, file);
+    content[*n] = '\0';
+
+    fclose(file);
+    return content;
+}
+
+// xorshift32, the corpus has to be the same on every platform
+static unsigned int _bench_random(unsigned int * const seed) {
+    unsigned int x = *seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *seed = x;
+}
+
+char *bench_generate_corpus(const unsigned int n) {
+    static const char * const mnemonics[] = {"mov", "add", "sub", "mul", "ldr", "str", "cmp", "b", "bl", "bx", "push", "pop"};
+    static const char * const labels[] = {"loop", "end", "main", "exit", "fibonacci", "L0", "L1", "print_value"};
+
+    char *corpus = malloc(n + 64);
+    unsigned int seed = 0x2545F491u;
+    unsigned int i = 0;
+
+    while (i < n) {
+        unsigned int kind = _bench_random(&seed) % 16;
+
+        if (kind == 0) {
+            i += sprintf(corpus + i, "%s:\n", labels[_bench_random(&seed) % 8]);
+        } else if (kind == 1) {
+            i += sprintf(corpus + i, "    // %s the value of r%u\n", labels[_bench_random(&seed) % 8], _bench_random(&seed) % 16);
+        } else {
+            const char *mnemonic = mnemonics[_bench_random(&seed) % 12];
+            unsigned int operand = _bench_random(&seed) % 3;
+
+            if (operand == 0) {
+                i += sprintf(corpus + i, "    %s r%u, r%u, r%u\n", mnemonic,
+                             _bench_random(&seed) % 16, _bench_random(&seed) % 16, _bench_random(&seed) % 16);
+            } else if (operand == 1) {
+                i += sprintf(corpus + i, "    %s r%u, #%u\n", mnemonic, _bench_random(&seed) % 16, _bench_random(&seed) % 100000);
+            } else {
+                i += sprintf(corpus + i, "    %s %s\n", mnemonic, labels[_bench_random(&seed) % 8]);
+            }
+        }
+    }
+
+    corpus[n] = '\0';
+    return corpus;
+}
+
+struct scanner_rules *bench_rules_assembly() {
+    struct scanner_rules *rules = scanner_rules_create();
+
+    scanner_rules_add(rules, "REGISTER", "r[0-9]+");
+    scanner_rules_add(rules, "MOV", "mov");
+    scanner_rules_add(rules, "ADD", "add");
+    scanner_rules_add(rules, "SUB", "sub");
+    scanner_rules_add(rules, "MUL", "mul");
+    scanner_rules_add(rules, "LDR", "ldr");
+    scanner_rules_add(rules, "STR", "str");
+    scanner_rules_add(rules, "CMP", "cmp");
+    scanner_rules_add(rules, "B", "b");
+    scanner_rules_add(rules, "BL", "bl");
+    scanner_rules_add(rules, "BX", "bx");
+    scanner_rules_add(rules, "PUSH", "push");
+    scanner_rules_add(rules, "POP", "pop");
+    scanner_rules_add(rules, "IDENTIFIER", "([a-z]|[A-Z]|_)([a-z]|[A-Z]|[0-9]|_)*");
+    scanner_rules_add(rules, "IMMEDIATE", "#[0-9]+");
+    scanner_rules_add(rules, "COMMA", ",");
+    scanner_rules_add(rules, "COLON", ":");
+    scanner_rules_add(rules, "COMMENT", "\"//\"([a-z]|[A-Z]|[0-9]|_| |\t|,|#|/|:)*\n");
+    scanner_rules_add(rules, "WHITESPACE", "( |\t|\n)+");
+
+    return rules;
+}
+
+/**
+ * The i-th keyword of `bench_rules_keywords`: 4-11 letters, at most `BENCH_KEYWORD_MAX` bytes with the terminating zero.
+ */
+#define BENCH_KEYWORD_MAX 12
+
+static void _bench_keyword(const unsigned int i, char * const keyword) {
+    unsigned int seed = 0x9E3779B9u ^ (i * 2654435761u + 1);
+    const unsigned int n = 4 + _bench_random(&seed) % 8;
+
+    for (unsigned int c = 0; c < n; c++) {
+        keyword[c] = 'a' + _bench_random(&seed) % 26;
+    }
+    keyword[n] = '\0';
+}
+
+struct scanner_rules *bench_rules_keywords(const unsigned int n_keywords) {
+    struct scanner_rules *rules = scanner_rules_create();
+    char keyword[BENCH_KEYWORD_MAX];
+    char name[32];
+
+    for (unsigned int i = 0; i < n_keywords; i++) {
+        _bench_keyword(i, keyword);
+        snprintf(name, sizeof(name), "KEYWORD_%u", i);
+        scanner_rules_add(rules, name, keyword);
+    }
+
+    scanner_rules_add(rules, "IDENTIFIER", "([a-z]|[A-Z]|_)([a-z]|[A-Z]|[0-9]|_)*");
+    scanner_rules_add(rules, "NUMBER", "[0-9]+");
+    scanner_rules_add(rules, "WHITESPACE", "( |\t|\n)+");
+
+    return rules;
+}
+
+char *bench_generate_keyword_corpus(const unsigned int n, const unsigned int n_keywords) {
+    char *corpus = malloc(n + 64);
+    char keyword[BENCH_KEYWORD_MAX];
+    unsigned int seed = 0x2545F491u;
+    unsigned int i = 0;
+
+    while (i < n) {
+        const unsigned int kind = _bench_random(&seed) % 8;
+        const char separator = _bench_random(&seed) % 8 == 0 ? '\n' : ' ';
+
+        if (kind == 0) {
+            i += sprintf(corpus + i, "x%u%c", _bench_random(&seed) % 1000, separator);
+        } else if (kind == 1) {
+            i += sprintf(corpus + i, "%u%c", _bench_random(&seed) % 100000, separator);
+        } else {
+            // the cube of a uniform number in [0, 1): the first keywords are the most frequent
+            const double u = (_bench_random(&seed) >> 8) / (double)(1u << 24);
+            _bench_keyword((unsigned int)(u * u * u * n_keywords), keyword);
+            i += sprintf(corpus + i, "%s%c", keyword, separator);
+        }
+    }
+
+    corpus[n] = '\0';
+    return corpus;
+}
+
+double bench_now() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+#ifdef __linux__
+static int _bench_perf_open(const unsigned long long config) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+#endif
+
+void bench_counters_open(struct bench_counters * const counters) {
+    memset(counters, 0, sizeof(*counters));
+    counters->_fd_cache_misses = -1;
+    counters->_fd_cache_references = -1;
+
+#ifdef __linux__
+    counters->_fd_cache_misses = _bench_perf_open(PERF_COUNT_HW_CACHE_MISSES);
+    counters->_fd_cache_references = _bench_perf_open(PERF_COUNT_HW_CACHE_REFERENCES);
+    counters->available = counters->_fd_cache_misses >= 0 && counters->_fd_cache_references >= 0;
+#endif
+}
+
+void bench_counters_start(struct bench_counters * const counters) {
+#ifdef __linux__
+    if (counters->available) {
+        ioctl(counters->_fd_cache_misses, PERF_EVENT_IOC_RESET, 0);
+        ioctl(counters->_fd_cache_references, PERF_EVENT_IOC_RESET, 0);
+        ioctl(counters->_fd_cache_misses, PERF_EVENT_IOC_ENABLE, 0);
+        ioctl(counters->_fd_cache_references, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+}
+
+void bench_counters_stop(struct bench_counters * const counters) {
+#ifdef __linux__
+    if (counters->available) {
+        ioctl(counters->_fd_cache_misses, PERF_EVENT_IOC_DISABLE, 0);
+        ioctl(counters->_fd_cache_references, PERF_EVENT_IOC_DISABLE, 0);
+
+        if (read(counters->_fd_cache_misses, &counters->cache_misses, sizeof(unsigned long long)) != sizeof(unsigned long long) ||
+            read(counters->_fd_cache_references, &counters->cache_references, sizeof(unsigned long long)) != sizeof(unsigned long long)) {
+            counters->available = 0;
+        }
+    }
+#endif
+}
+
+void bench_counters_close(struct bench_counters * const counters) {
+#ifdef __linux__
+    if (counters->_fd_cache_misses >= 0) {
+        close(counters->_fd_cache_misses);
+    }
+    if (counters->_fd_cache_references >= 0) {
+        close(counters->_fd_cache_references);
+    }
+#endif
+    counters->available = 0;
+}
@@ -0,0 +1,60 @@
+// shared helpers of the benchmarks: corpora, timing and hardware counters
+
+#ifndef BENCH_UTILS_H
+#define BENCH_UTILS_H
+
+#include <scanner_utils/rules.h>
+
+/**
+ * Reads a whole file into memory. `*n` is set to its size.
+ * Returns NULL if the file can't be read.
+ */
+char *bench_read_file(const char * const path, unsigned int * const n);
+
+/**
+ * Generates `n` bytes of ARM-like assembly (mnemonics, registers, immediates,
+ * labels and comments) with a fixed-seed PRNG, so every run scans the same text.
+ */
+char *bench_generate_corpus(const unsigned int n);
+
+/**
+ * Token rules of the assembly language the synthetic corpus is written in.
+ */
+struct scanner_rules *bench_rules_assembly();
+
+/**
+ * A language with a big transition table: `n_keywords` random lowercase keywords
+ * (fixed seed) spelled out in the DFA next to an identifier and a number rule.
+ */
+struct scanner_rules *bench_rules_keywords(const unsigned int n_keywords);
+
+/**
+ * Generates `n` bytes of the keywords of `bench_rules_keywords(n_keywords)`, identifiers and numbers.
+ * The keywords are skewed like the words of a natural text: a few of them are most of the corpus.
+ */
+char *bench_generate_keyword_corpus(const unsigned int n, const unsigned int n_keywords);
+
+/**
+ * Monotonic clock in seconds.
+ */
+double bench_now();
+
+/**
+ * Hardware counters of the calling thread (perf_event_open on Linux).
+ * If the counters are not available (other OS, no permission, virtual machine)
+ * `available` is 0 and the benchmarks only report time.
+ */
+struct bench_counters {
+    unsigned char available;
+    int _fd_cache_misses;
+    int _fd_cache_references;
+    unsigned long long cache_misses;
+    unsigned long long cache_references;
+};
+
+void bench_counters_open(struct bench_counters * const counters);
+void bench_counters_start(struct bench_counters * const counters);
+void bench_counters_stop(struct bench_counters * const counters);
+void bench_counters_close(struct bench_counters * const counters);
+
+#endif // BENCH_UTILS_H
@@ -0,0 +1,79 @@
+# add_generated_scanner(<target> <file.lang> [NAME <name>] [BACKEND table|direct|comb])
+#
+# Compiles a .lang file into a C scanner with the `generator` at build time and adds it to
+# the sources of <target>. The scanner is regenerated when the .lang file (or the generator)
+# changes. Its header `<name>.h` is on the include path of <target> (see emit.h for the API).
+#
+#   NAME     the prefix of the generated identifiers and the name of the files,
+#            the name of the .lang file by default
+#   BACKEND  overrides the `%backend` option of the .lang file
+#
+# The scanner is compiled with full optimization in every build type, and <target> is linked
+# with LTO (if the toolchain supports it), so the tables are folded into the scan loop of the callers.
+#
+# The compiled DFAs are cached in SCANNER_DFA_CACHE_DIR (see dfa_cache.h), so a .lang file that is
+# shared by many targets (or build trees, with a shared directory) is compiled once.
+# The keys have a hash of the sources of the generator, so the DFAs of an older generator are not loaded.
+# The `prune_dfa_cache` target removes the DFAs that weren't used for SCANNER_DFA_CACHE_MAX_AGE days.
+#
+# The generator compiles the rules on SCANNER_GENERATOR_THREADS threads (one per core with 0).
+
+include(CheckIPOSupported)
+check_ipo_supported(RESULT SCANNER_GENERATED_LTO OUTPUT SCANNER_GENERATED_LTO_ERROR LANGUAGES C)
+
+option(SCANNER_DFA_CACHE "Cache the compiled DFAs of the generated scanners on disk." ON)
+set(SCANNER_DFA_CACHE_DIR ${CMAKE_BINARY_DIR}/dfa_cache CACHE PATH "Directory of the DFA cache of the generator.")
+set(SCANNER_DFA_CACHE_MAX_AGE 30 CACHE STRING "Days after the unused DFAs are removed by `prune_dfa_cache`.")
+set(SCANNER_GENERATOR_THREADS 0 CACHE STRING "Threads of the generator, 0 for one per core.")
+
+add_custom_target(prune_dfa_cache
+                  COMMAND generator --prune-cache ${SCANNER_DFA_CACHE_DIR} ${SCANNER_DFA_CACHE_MAX_AGE}
+                  COMMENT "Pruning the DFA cache ${SCANNER_DFA_CACHE_DIR}"
+                  VERBATIM)
+
+function(add_generated_scanner TARGET LANG_FILE)
+    cmake_parse_arguments(ARG "" "NAME;BACKEND" "" ${ARGN})
+
+    get_filename_component(LANG_PATH ${LANG_FILE} ABSOLUTE)
+
+    if(ARG_NAME)
+        set(NAME ${ARG_NAME})
+    else()
+        get_filename_component(NAME ${LANG_FILE} NAME_WE)
+        string(MAKE_C_IDENTIFIER ${NAME} NAME)
+    endif()
+
+    set(OUTPUT_DIR ${CMAKE_CURRENT_BINARY_DIR}/generated_scanners)
+    set(OUTPUT ${OUTPUT_DIR}/${NAME})
+
+    set(CACHE_ARGS)
+    if(SCANNER_DFA_CACHE)
+        set(CACHE_ARGS --cache ${SCANNER_DFA_CACHE_DIR})
+    endif()
+
+    set(THREADS_ARGS)
+    if(SCANNER_GENERATOR_THREADS GREATER 0)
+        set(THREADS_ARGS --threads ${SCANNER_GENERATOR_THREADS})
+    endif()
+
+    add_custom_command(OUTPUT ${OUTPUT}.c ${OUTPUT}.h
+                       COMMAND ${CMAKE_COMMAND} -E make_directory ${OUTPUT_DIR}
+                       COMMAND generator ${CACHE_ARGS} ${THREADS_ARGS} ${LANG_PATH} ${NAME} ${OUTPUT} ${ARG_BACKEND}
+                       MAIN_DEPENDENCY ${LANG_PATH}
+                       DEPENDS generator
+                       COMMENT "Generating the scanner ${NAME} from ${LANG_FILE}"
+                       VERBATIM)
+
+    target_sources(${TARGET} PRIVATE ${OUTPUT}.c ${OUTPUT}.h)
+    target_include_directories(${TARGET} PRIVATE ${OUTPUT_DIR})
+
+    if(CMAKE_C_COMPILER_ID MATCHES "GNU|Clang")
+        set_source_files_properties(${OUTPUT}.c PROPERTIES COMPILE_OPTIONS "-O3")
+    elseif(MSVC)
+        set_source_files_properties(${OUTPUT}.c PROPERTIES COMPILE_OPTIONS "/O2")
+    endif()
+
+    if(SCANNER_GENERATED_LTO)
+        set_property(TARGET ${TARGET} PROPERTY INTERPROCEDURAL_OPTIMIZATION TRUE)
+    endif()
+endfunction()
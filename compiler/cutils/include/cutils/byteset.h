@@ -0,0 +1,74 @@
+// bit vector implementation of sets of bytes (0 <= x <= 255)
+// with vectorized search functions over byte strings
+
+#ifndef CUTILS_BYTESET_H
+#define CUTILS_BYTESET_H
+
+#include "../include/cutils/common.h"
+
+/**
+ * Maximum number of contiguous ranges for which the search functions
+ * can use vectorized range compares. Sets with more ranges fall back
+ * to a scalar bit-vector lookup.
+ */
+#define CUTILS_BYTESET_MAX_RANGES 4
+
+struct cutils_byteset {
+    unsigned int _bitvector[8];
+
+    // The set described as a list of contiguous ranges [from, to].
+    // Kept up to date by every function that creates a set.
+    // `_n_ranges` > CUTILS_BYTESET_MAX_RANGES means that the set is too
+    // fragmented and the ranges are not stored.
+    unsigned char _n_ranges;
+    unsigned char _range_from[CUTILS_BYTESET_MAX_RANGES];
+    unsigned char _range_to[CUTILS_BYTESET_MAX_RANGES];
+};
+
+struct cutils_byteset cutils_byteset_create(const unsigned char element);
+struct cutils_byteset cutils_byteset_create_range(const unsigned char from, const unsigned char to);
+struct cutils_byteset cutils_byteset_empty();
+
+struct cutils_byteset cutils_byteset_union(const struct cutils_byteset A, const struct cutils_byteset B);
+struct cutils_byteset cutils_byteset_intersection(const struct cutils_byteset A, const struct cutils_byteset B);
+struct cutils_byteset cutils_byteset_negate(const struct cutils_byteset A);
+
+unsigned char cutils_byteset_isempty(const struct cutils_byteset A);
+unsigned char cutils_byteset_has_element(const struct cutils_byteset A, const unsigned char element);
+
+unsigned short cutils_byteset_size(const struct cutils_byteset A);
+
+/**
+ * Returns the smallest element that the set contains, -1 if the set is empty
+ */
+short cutils_byteset_smallest(const struct cutils_byteset A);
+
+/**
+ * Finds the first byte of `s` that is an element of `A`.
+ *
+ * A single element set is searched with `memchr`, sets of at most
+ * CUTILS_BYTESET_MAX_RANGES ranges with SSE2/AVX2 range compares
+ * (when the target supports them), everything else byte by byte.
+ *
+ * @return index of the first matching byte, or `n` if there is none
+ */
+unsigned int cutils_byteset_find(const struct cutils_byteset * const A, const char * const s, const unsigned int n);
+
+/**
+ * Length of the longest prefix of `s` whose bytes are all elements of `A`.
+ * Uses the same vectorized range compares as `cutils_byteset_find`.
+ */
+unsigned int cutils_byteset_span(const struct cutils_byteset * const A, const char * const s, const unsigned int n);
+
+/**
+ * Number of bytes of `s` that are elements of `A` (e.g. counting newlines).
+ * Counts the bits of the vectorized range compare masks.
+ */
+unsigned int cutils_byteset_count(const struct cutils_byteset * const A, const char * const s, const unsigned int n);
+
+/**
+ * Recalculates the range list of the set from the bit vector.
+ */
+void _cutils_byteset_update_ranges(struct cutils_byteset * const A);
+
+#endif // CUTILS_BYTESET_H
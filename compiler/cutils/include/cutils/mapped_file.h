@@ -0,0 +1,35 @@
+// read-only view of a whole file: memory-mapped if possible,
+// read into a heap buffer otherwise (pipes, terminals, empty files)
+
+#ifndef CUTILS_MAPPED_FILE_H
+#define CUTILS_MAPPED_FILE_H
+
+#include "../include/cutils/common.h"
+
+struct cutils_mapped_file {
+    const char *data;
+    unsigned long long size;
+    unsigned char _is_mapped; // 0: `data` is a heap buffer
+};
+
+/**
+ * Opens a file for reading it from the beginning to the end.
+ *
+ * Regular files are mapped (with MAP_POPULATE where available) and advised
+ * for sequential access, so the pages are read ahead of the scanner and
+ * nothing is copied. `path` "-" is the standard input.
+ *
+ * @return NULL if the file couldn't be opened or read
+ */
+struct cutils_mapped_file *cutils_mapped_file_open(const char * const path);
+
+/**
+ * Same as `cutils_mapped_file_open` with an already opened file descriptor.
+ * Anything that can't be mapped is read with `read()` until the end of the file.
+ * The file descriptor is not closed.
+ */
+struct cutils_mapped_file *cutils_mapped_file_open_fd(const int fd);
+
+void cutils_mapped_file_close(struct cutils_mapped_file *file);
+
+#endif // CUTILS_MAPPED_FILE_H
@@ -30,6 +30,12 @@ struct cutils_string *cutils_string_create();
  */
 struct cutils_string *cutils_string_create_from(const char *const src);
 
+/**
+ * Creates a pointer to a cutils_string from the first `n` chars of `src` by COPY.
+ * (`src` doesn't need to be terminated, e.g. a slice of a bigger text)
+ */
+struct cutils_string *cutils_string_create_from_n(const char *const src, const unsigned int n);
+
 void cutils_string_destroy(struct cutils_string *str);
 
 struct cutils_string *_cutils_string_create_allocate(const unsigned int str_size);
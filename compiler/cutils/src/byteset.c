@@ -0,0 +1,245 @@
+#include "../include/cutils/byteset.h"
+
+#include <string.h>
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+#elif defined(__SSE2__)
+    #include <emmintrin.h>
+#endif
+
+#ifdef UNIT_TESTING
+    #include <cutils/cutils_unittest.h>
+#endif // UNIT_TESTING
+
+static inline unsigned char _cutils_byteset_has(const struct cutils_byteset * const A, const unsigned char element) {
+    return (A->_bitvector[element >> 5] >> (element & 31)) & 1;
+}
+
+void _cutils_byteset_update_ranges(struct cutils_byteset * const A) {
+    A->_n_ranges = 0;
+
+    unsigned int element = 0;
+    while (element < 256) {
+        // skip bytes that are not in the set
+        for (; element < 256 && !_cutils_byteset_has(A, element); element++);
+
+        if (element == 256) {
+            break;
+        }
+
+        unsigned int from = element;
+        for (; element < 256 && _cutils_byteset_has(A, element); element++);
+
+        if (A->_n_ranges < CUTILS_BYTESET_MAX_RANGES) {
+            A->_range_from[A->_n_ranges] = from;
+            A->_range_to[A->_n_ranges] = element - 1;
+        }
+
+        A->_n_ranges++;
+
+        // no need to go on, the set is too fragmented to store its ranges
+        if (A->_n_ranges > CUTILS_BYTESET_MAX_RANGES) {
+            break;
+        }
+    }
+}
+
+struct cutils_byteset cutils_byteset_empty() {
+    struct cutils_byteset A;
+    memset(&A, 0, sizeof(A));
+    return A;
+}
+
+struct cutils_byteset cutils_byteset_create(const unsigned char element) {
+    return cutils_byteset_create_range(element, element);
+}
+
+struct cutils_byteset cutils_byteset_create_range(const unsigned char from, const unsigned char to) {
+    struct cutils_byteset A = cutils_byteset_empty();
+
+    for (unsigned int element = from; element <= to; element++) {
+        A._bitvector[element >> 5] |= 1u << (element & 31);
+    }
+
+    _cutils_byteset_update_ranges(&A);
+    return A;
+}
+
+struct cutils_byteset cutils_byteset_union(const struct cutils_byteset A, const struct cutils_byteset B) {
+    struct cutils_byteset C;
+
+    for (unsigned char i = 0; i < 8; i++) {
+        C._bitvector[i] = A._bitvector[i] | B._bitvector[i];
+    }
+
+    _cutils_byteset_update_ranges(&C);
+    return C;
+}
+
+struct cutils_byteset cutils_byteset_intersection(const struct cutils_byteset A, const struct cutils_byteset B) {
+    struct cutils_byteset C;
+
+    for (unsigned char i = 0; i < 8; i++) {
+        C._bitvector[i] = A._bitvector[i] & B._bitvector[i];
+    }
+
+    _cutils_byteset_update_ranges(&C);
+    return C;
+}
+
+struct cutils_byteset cutils_byteset_negate(const struct cutils_byteset A) {
+    struct cutils_byteset C;
+
+    for (unsigned char i = 0; i < 8; i++) {
+        C._bitvector[i] = ~A._bitvector[i];
+    }
+
+    _cutils_byteset_update_ranges(&C);
+    return C;
+}
+
+unsigned char cutils_byteset_isempty(const struct cutils_byteset A) {
+    return A._n_ranges == 0;
+}
+
+unsigned char cutils_byteset_has_element(const struct cutils_byteset A, const unsigned char element) {
+    return _cutils_byteset_has(&A, element);
+}
+
+unsigned short cutils_byteset_size(const struct cutils_byteset A) {
+    unsigned short total = 0;
+    for (unsigned int i = 0; i < 8; i++) {
+        total += __builtin_popcount(A._bitvector[i]);
+    }
+    return total;
+}
+
+short cutils_byteset_smallest(const struct cutils_byteset A) {
+    for (unsigned int i = 0; i < 8; i++) {
+        if (A._bitvector[i] != 0) {
+            return __builtin_ctz(A._bitvector[i]) + 32*i;
+        }
+    }
+
+    return -1;
+}
+
+// --------------------------------------
+// VECTORIZED SEARCH
+//
+// Every block of bytes is tested against each range of the set:
+//   from <= x <= to  <=>  (x - from) <= (to - from)  (unsigned)
+// and the unsigned compare is done with min_epu8 + cmpeq.
+// The result is a bit mask with the nth bit set if the nth byte is in the set.
+// --------------------------------------
+
+#if defined(__AVX2__)
+    #define _CUTILS_BYTESET_BLOCK 32
+
+static inline unsigned int _cutils_byteset_match_block(const struct cutils_byteset * const A, const char * const s) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)s);
+    __m256i m = _mm256_setzero_si256();
+
+    for (unsigned char r = 0; r < A->_n_ranges; r++) {
+        __m256i t = _mm256_sub_epi8(v, _mm256_set1_epi8((char)A->_range_from[r]));
+        __m256i w = _mm256_set1_epi8((char)(A->_range_to[r] - A->_range_from[r]));
+        m = _mm256_or_si256(m, _mm256_cmpeq_epi8(_mm256_min_epu8(t, w), t));
+    }
+
+    return (unsigned int)_mm256_movemask_epi8(m);
+}
+#elif defined(__SSE2__)
+    #define _CUTILS_BYTESET_BLOCK 16
+
+static inline unsigned int _cutils_byteset_match_block(const struct cutils_byteset * const A, const char * const s) {
+    __m128i v = _mm_loadu_si128((const __m128i *)s);
+    __m128i m = _mm_setzero_si128();
+
+    for (unsigned char r = 0; r < A->_n_ranges; r++) {
+        __m128i t = _mm_sub_epi8(v, _mm_set1_epi8((char)A->_range_from[r]));
+        __m128i w = _mm_set1_epi8((char)(A->_range_to[r] - A->_range_from[r]));
+        m = _mm_or_si128(m, _mm_cmpeq_epi8(_mm_min_epu8(t, w), t));
+    }
+
+    return (unsigned int)_mm_movemask_epi8(m);
+}
+#endif
+
+unsigned int cutils_byteset_find(const struct cutils_byteset * const A, const char * const s, const unsigned int n) {
+    if (A->_n_ranges == 0) {
+        return n;
+    }
+
+    if (A->_n_ranges == 1 && A->_range_from[0] == A->_range_to[0]) {
+        const char *found = memchr(s, A->_range_from[0], n);
+        return found == NULL ? n : (unsigned int)(found - s);
+    }
+
+    unsigned int i = 0;
+
+#ifdef _CUTILS_BYTESET_BLOCK
+    if (A->_n_ranges <= CUTILS_BYTESET_MAX_RANGES) {
+        for (; i + _CUTILS_BYTESET_BLOCK <= n; i += _CUTILS_BYTESET_BLOCK) {
+            unsigned int mask = _cutils_byteset_match_block(A, s + i);
+
+            if (mask != 0) {
+                return i + __builtin_ctz(mask);
+            }
+        }
+    }
+#endif
+
+    for (; i < n && !_cutils_byteset_has(A, s[i]); i++);
+
+    return i;
+}
+
+unsigned int cutils_byteset_span(const struct cutils_byteset * const A, const char * const s, const unsigned int n) {
+    if (A->_n_ranges == 0) {
+        return 0;
+    }
+
+    unsigned int i = 0;
+
+#ifdef _CUTILS_BYTESET_BLOCK
+    if (A->_n_ranges <= CUTILS_BYTESET_MAX_RANGES) {
+        #if _CUTILS_BYTESET_BLOCK == 32
+            const unsigned int all = 0xFFFFFFFFu;
+        #else
+            const unsigned int all = 0xFFFFu;
+        #endif
+
+        for (; i + _CUTILS_BYTESET_BLOCK <= n; i += _CUTILS_BYTESET_BLOCK) {
+            unsigned int mask = _cutils_byteset_match_block(A, s + i);
+
+            if (mask != all) {
+                return i + __builtin_ctz(~mask);
+            }
+        }
+    }
+#endif
+
+    for (; i < n && _cutils_byteset_has(A, s[i]); i++);
+
+    return i;
+}
+
+unsigned int cutils_byteset_count(const struct cutils_byteset * const A, const char * const s, const unsigned int n) {
+    unsigned int count = 0;
+    unsigned int i = 0;
+
+#ifdef _CUTILS_BYTESET_BLOCK
+    if (A->_n_ranges <= CUTILS_BYTESET_MAX_RANGES) {
+        for (; i + _CUTILS_BYTESET_BLOCK <= n; i += _CUTILS_BYTESET_BLOCK) {
+            count += __builtin_popcount(_cutils_byteset_match_block(A, s + i));
+        }
+    }
+#endif
+
+    for (; i < n; i++) {
+        count += _cutils_byteset_has(A, s[i]);
+    }
+
+    return count;
+}
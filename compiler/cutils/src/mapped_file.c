@@ -0,0 +1,155 @@
+#include "../include/cutils/mapped_file.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef UNIT_TESTING
+    #include <cutils/cutils_unittest.h>
+#endif // UNIT_TESTING
+
+#define _CUTILS_MAPPED_FILE_READ_CHUNK 65536
+
+#ifdef MAP_POPULATE
+    #define _CUTILS_MAPPED_FILE_FLAGS (MAP_PRIVATE | MAP_POPULATE)
+#else
+    #define _CUTILS_MAPPED_FILE_FLAGS MAP_PRIVATE
+#endif
+
+/**
+ * Maps a regular file. Returns 0 if the file can't be mapped.
+ */
+static unsigned char _cutils_mapped_file_map(struct cutils_mapped_file * const file, const int fd,
+                                             const unsigned long long size) {
+    void *data = mmap(NULL, size, PROT_READ, _CUTILS_MAPPED_FILE_FLAGS, fd, 0);
+
+    if (data == MAP_FAILED) {
+        return 0;
+    }
+
+    // only a hint, the mapping works without it
+    madvise(data, size, MADV_SEQUENTIAL);
+
+    file->data = data;
+    file->size = size;
+    file->_is_mapped = 1;
+
+    return 1;
+}
+
+/**
+ * Reads everything until the end of the file into a heap buffer.
+ */
+static unsigned char _cutils_mapped_file_read(struct cutils_mapped_file * const file, const int fd) {
+    unsigned long long capacity = _CUTILS_MAPPED_FILE_READ_CHUNK;
+    unsigned long long size = 0;
+    char *data = malloc(capacity);
+
+    if (data == NULL) {
+        printf("[cutils/mapped_file.c -> _cutils_mapped_file_read()] MALLOC ERROR: Couldn't allocate the buffer.\n");
+        return 0;
+    }
+
+    while (1) {
+        if (size == capacity) {
+            capacity *= 2;
+            char *new_data = realloc(data, capacity);
+
+            if (new_data == NULL) {
+                printf("[cutils/mapped_file.c -> _cutils_mapped_file_read()] REALLOC ERROR: Couldn't grow the buffer.\n");
+                free(data);
+                return 0;
+            }
+
+            data = new_data;
+        }
+
+        ssize_t n = read(fd, data + size, capacity - size);
+
+        if (n == 0) {
+            break;
+        }
+
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            printf("[cutils/mapped_file.c -> _cutils_mapped_file_read()] READ ERROR: %s\n", strerror(errno));
+            free(data);
+            return 0;
+        }
+
+        size += n;
+    }
+
+    file->data = data;
+    file->size = size;
+    file->_is_mapped = 0;
+
+    return 1;
+}
+
+struct cutils_mapped_file *cutils_mapped_file_open_fd(const int fd) {
+    struct cutils_mapped_file *file = malloc(sizeof(struct cutils_mapped_file));
+
+    if (file == NULL) {
+        return NULL;
+    }
+
+    struct stat st;
+    unsigned char success = 0;
+
+    // an empty mapping is invalid, and the size of pipes is unknown
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        success = _cutils_mapped_file_map(file, fd, st.st_size);
+    }
+
+    if (!success) {
+        success = _cutils_mapped_file_read(file, fd);
+    }
+
+    if (!success) {
+        free(file);
+        return NULL;
+    }
+
+    return file;
+}
+
+struct cutils_mapped_file *cutils_mapped_file_open(const char * const path) {
+    if (strcmp(path, "-") == 0) {
+        return cutils_mapped_file_open_fd(STDIN_FILENO);
+    }
+
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0) {
+        printf("ERROR: couldn't open file '%s': %s\n", path, strerror(errno));
+        return NULL;
+    }
+
+    struct cutils_mapped_file *file = cutils_mapped_file_open_fd(fd);
+
+    // the mapping stays valid after closing
+    close(fd);
+
+    return file;
+}
+
+void cutils_mapped_file_close(struct cutils_mapped_file *file) {
+    if (file != NULL) {
+        if (file->_is_mapped) {
+            munmap((void *)file->data, file->size);
+        } else {
+            free((void *)file->data);
+        }
+
+        free(file);
+    }
+}
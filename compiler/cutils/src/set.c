@@ -1,5 +1,8 @@
 #include "../include/cutils/set.h"
 
+#include <stdio.h>
+#include <stdlib.h>
+
 #ifdef UNIT_TESTING
     #include <cutils/cutils_unittest.h>
 #endif // UNIT_TESTING
@@ -25,6 +25,18 @@ struct cutils_string *cutils_string_create_from(const char *const src) {
     return str;
 }
 
+struct cutils_string *cutils_string_create_from_n(const char *const src, const unsigned int n) {
+    struct cutils_string* str = _cutils_string_create_allocate(n);
+
+    if (str != NULL) {
+        memcpy(str->_s, src, n);
+        str->_s[n] = '\0';
+        str->size = n;
+    }
+
+    return str;
+}
+
 struct cutils_string *_cutils_string_create_allocate(const unsigned int str_size) {
     struct cutils_string *str = malloc(sizeof(struct cutils_string));
 
@@ -0,0 +1,142 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <string.h>
+
+#include <cutils/byteset.h>
+
+static void test_cutils_byteset_create(void **state) {
+    const struct cutils_byteset A = cutils_byteset_create(5);
+    const struct cutils_byteset B = cutils_byteset_create(200);
+
+    assert_int_equal(A._bitvector[0], 1 << 5);
+    assert_int_equal(A._n_ranges, 1);
+    assert_int_equal(A._range_from[0], 5);
+    assert_int_equal(A._range_to[0], 5);
+
+    assert_int_equal(B._bitvector[6], 1 << (200 - 192));
+    assert_true(cutils_byteset_has_element(B, 200));
+    assert_false(cutils_byteset_has_element(B, 199));
+}
+
+static void test_cutils_byteset_ranges(void **state) {
+    struct cutils_byteset A = cutils_byteset_union(cutils_byteset_create_range('a', 'z'),
+                                                   cutils_byteset_create_range('A', 'Z'));
+    A = cutils_byteset_union(A, cutils_byteset_create_range('0', '9'));
+
+    assert_int_equal(cutils_byteset_size(A), 62);
+    assert_int_equal(cutils_byteset_smallest(A), '0');
+    assert_int_equal(A._n_ranges, 3);
+    assert_int_equal(A._range_from[0], '0');
+    assert_int_equal(A._range_to[0], '9');
+    assert_int_equal(A._range_from[2], 'a');
+    assert_int_equal(A._range_to[2], 'z');
+
+    // adjacent ranges are merged
+    struct cutils_byteset B = cutils_byteset_union(cutils_byteset_create_range(0, 9),
+                                                   cutils_byteset_create_range(10, 20));
+    assert_int_equal(B._n_ranges, 1);
+
+    // too fragmented set
+    struct cutils_byteset C = cutils_byteset_empty();
+    for (int i = 0; i < 20; i += 2) {
+        C = cutils_byteset_union(C, cutils_byteset_create(i));
+    }
+    assert_true(C._n_ranges > CUTILS_BYTESET_MAX_RANGES);
+    assert_int_equal(cutils_byteset_size(C), 10);
+}
+
+static void test_cutils_byteset_negate(void **state) {
+    struct cutils_byteset A = cutils_byteset_negate(cutils_byteset_create('*'));
+
+    assert_int_equal(cutils_byteset_size(A), 255);
+    assert_false(cutils_byteset_has_element(A, '*'));
+    assert_int_equal(A._n_ranges, 2);
+
+    assert_true(cutils_byteset_isempty(cutils_byteset_empty()));
+    assert_true(cutils_byteset_isempty(cutils_byteset_intersection(A, cutils_byteset_create('*'))));
+    assert_int_equal(cutils_byteset_smallest(cutils_byteset_empty()), -1);
+}
+
+static void test_cutils_byteset_find(void **state) {
+    const char *text = "the quick brown fox jumps over the lazy dog, 0123456789 THE END";
+    const unsigned int n = strlen(text);
+
+    struct cutils_byteset single = cutils_byteset_create('j');
+    assert_int_equal(cutils_byteset_find(&single, text, n), 20);
+
+    struct cutils_byteset digits = cutils_byteset_create_range('0', '9');
+    assert_int_equal(cutils_byteset_find(&digits, text, n), 45);
+
+    struct cutils_byteset upper_or_comma = cutils_byteset_union(cutils_byteset_create_range('A', 'Z'),
+                                                                cutils_byteset_create(','));
+    assert_int_equal(cutils_byteset_find(&upper_or_comma, text, n), 43);
+
+    struct cutils_byteset none = cutils_byteset_create('#');
+    assert_int_equal(cutils_byteset_find(&none, text, n), n);
+    assert_int_equal(cutils_byteset_find(&digits, text, 10), 10);
+
+    // fragmented sets use the scalar search
+    struct cutils_byteset fragmented = cutils_byteset_empty();
+    const char *letters = "xwvE";
+    for (int i = 0; i < 4; i++) {
+        fragmented = cutils_byteset_union(fragmented, cutils_byteset_create(letters[i]));
+        fragmented = cutils_byteset_union(fragmented, cutils_byteset_create(letters[i] + 2));
+    }
+    assert_int_equal(cutils_byteset_find(&fragmented, text, n), 13);
+}
+
+static void test_cutils_byteset_span(void **state) {
+    char text[100];
+    memset(text, 'a', sizeof(text));
+    text[77] = '!';
+
+    struct cutils_byteset letters = cutils_byteset_create_range('a', 'z');
+    assert_int_equal(cutils_byteset_span(&letters, text, sizeof(text)), 77);
+    assert_int_equal(cutils_byteset_span(&letters, text, 50), 50);
+    assert_int_equal(cutils_byteset_span(&letters, text + 77, 23), 0);
+
+    struct cutils_byteset empty = cutils_byteset_empty();
+    assert_int_equal(cutils_byteset_span(&empty, text, sizeof(text)), 0);
+
+    // bytes outside of the ASCII range
+    unsigned char high[40];
+    memset(high, 0xC3, sizeof(high));
+    high[33] = 0x7F;
+    struct cutils_byteset upper_half = cutils_byteset_create_range(0x80, 0xFF);
+    assert_int_equal(cutils_byteset_span(&upper_half, (const char *)high, sizeof(high)), 33);
+}
+
+static void test_cutils_byteset_count(void **state) {
+    const struct cutils_byteset newline = cutils_byteset_create('\n');
+    const struct cutils_byteset digits = cutils_byteset_create_range('0', '9');
+
+    char text[200];
+    memset(text, 'a', sizeof(text));
+    text[0] = '\n';
+    text[31] = '\n';
+    text[32] = '\n';
+    text[150] = '\n';
+    text[199] = '\n';
+    text[100] = '7';
+
+    assert_int_equal(cutils_byteset_count(&newline, text, sizeof(text)), 5);
+    assert_int_equal(cutils_byteset_count(&newline, text, 32), 2);
+    assert_int_equal(cutils_byteset_count(&newline, text + 1, 5), 0);
+    assert_int_equal(cutils_byteset_count(&digits, text, sizeof(text)), 1);
+    assert_int_equal(cutils_byteset_count(&newline, text, 0), 0);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_cutils_byteset_create),
+        cmocka_unit_test(test_cutils_byteset_ranges),
+        cmocka_unit_test(test_cutils_byteset_negate),
+        cmocka_unit_test(test_cutils_byteset_find),
+        cmocka_unit_test(test_cutils_byteset_span),
+        cmocka_unit_test(test_cutils_byteset_count),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,77 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <cutils/mapped_file.h>
+
+static void test_cutils_mapped_file_regular(void **state) {
+    char path[] = "/tmp/cutils_mapped_file_XXXXXX";
+    int fd = mkstemp(path);
+    assert_true(fd >= 0);
+
+    const char *content = "REGISTER : r[0-9]+\nIDENTIFIER : [a-z]+\n";
+    assert_int_equal(write(fd, content, strlen(content)), strlen(content));
+    close(fd);
+
+    struct cutils_mapped_file *file = cutils_mapped_file_open(path);
+    assert_non_null(file);
+    assert_true(file->_is_mapped);
+    assert_int_equal(file->size, strlen(content));
+    assert_memory_equal(file->data, content, file->size);
+    cutils_mapped_file_close(file);
+
+    unlink(path);
+}
+
+static void test_cutils_mapped_file_empty(void **state) {
+    char path[] = "/tmp/cutils_mapped_file_XXXXXX";
+    int fd = mkstemp(path);
+    close(fd);
+
+    // an empty file can't be mapped, it falls back to reading
+    struct cutils_mapped_file *file = cutils_mapped_file_open(path);
+    assert_non_null(file);
+    assert_false(file->_is_mapped);
+    assert_int_equal(file->size, 0);
+    cutils_mapped_file_close(file);
+
+    unlink(path);
+}
+
+static void test_cutils_mapped_file_pipe(void **state) {
+    int fds[2];
+    assert_int_equal(pipe(fds), 0);
+
+    const char *content = "mov r1, #42\n";
+    assert_int_equal(write(fds[1], content, strlen(content)), strlen(content));
+    close(fds[1]);
+
+    struct cutils_mapped_file *file = cutils_mapped_file_open_fd(fds[0]);
+    assert_non_null(file);
+    assert_false(file->_is_mapped);
+    assert_int_equal(file->size, strlen(content));
+    assert_memory_equal(file->data, content, file->size);
+    cutils_mapped_file_close(file);
+
+    close(fds[0]);
+}
+
+static void test_cutils_mapped_file_missing(void **state) {
+    assert_null(cutils_mapped_file_open("/tmp/cutils_mapped_file_does_not_exist"));
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_cutils_mapped_file_regular),
+        cmocka_unit_test(test_cutils_mapped_file_empty),
+        cmocka_unit_test(test_cutils_mapped_file_pipe),
+        cmocka_unit_test(test_cutils_mapped_file_missing),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
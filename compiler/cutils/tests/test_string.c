@@ -36,6 +36,23 @@ static void test_api_cutils_string_create_from(void **state) {
     cutils_string_destroy(str);
 }
 
+static void test_api_cutils_string_create_from_n(void **state) {
+    const char *text = "mov r1, r2";
+    struct cutils_string* str = cutils_string_create_from_n(text + 4, 2);
+
+    assert_int_equal(str->size, 2);
+    assert_int_equal(str->_capacity, CUTILS_STRING_INITIAL_CAPACITY);
+    assert_string_equal(str->_s, "r1");
+
+    cutils_string_destroy(str);
+
+    str = cutils_string_create_from_n(text, 0);
+    assert_int_equal(str->size, 0);
+    assert_string_equal(str->_s, "");
+
+    cutils_string_destroy(str);
+}
+
 static void test_api_cutils_string_destroy(void **state) {
     // at this point cutils_string_create has been already tested
     struct cutils_string* str = cutils_string_create();
@@ -260,6 +277,7 @@ int main(void) {
         cmocka_unit_test(test_internal_calc_capacity),
         cmocka_unit_test(test_api_cutils_string_create),
         cmocka_unit_test(test_api_cutils_string_create_from),
+        cmocka_unit_test(test_api_cutils_string_create_from_n),
         cmocka_unit_test(test_api_cutils_string_destroy),
         cmocka_unit_test(test_internal_cutils_string_create_allocate),
         cmocka_unit_test_setup_teardown(test_internal_cutils_string_realloc, setup_cutils_string_empty, teardown_cutils_string_destroy),
@@ -0,0 +1,92 @@
+#ifndef SCANNER_COMB_H
+#define SCANNER_COMB_H
+
+#include <scanner_utils/dfa.h>
+
+#define SCANNER_COMB_NO_DEFAULT 0xFFFF
+#define SCANNER_COMB_FREE 0xFFFF
+
+/**
+ * Row displacement (comb-vector) compression of a `scanner_dfa` transition table,
+ * as in the table packing of lex and yacc.
+ *
+ * Most entries of the dense table lead to the error state. Here only the entries
+ * that matter are stored, and the rows are overlaid on each other in a single array
+ * like the teeth of combs: row `state` starts at `base[state]` and an entry belongs
+ * to it only if `check` says so.
+ *
+ *      index = base[state] + byte
+ *      if check[index] == state:        next_state = next[index]
+ *      else if default_state[state]:    the same with the row of default_state[state]
+ *      else:                            next_state = error state
+ *
+ * Default rows: a state that has almost the same transitions as another state only stores
+ * the bytes where it differs from it (even if it differs by going to the error state).
+ * Default rows are never chained (a default row doesn't have a default row itself),
+ * so a transition is at most two lookups.
+ *
+ * The footprint is roughly the number of non-error transitions instead of 256 per state.
+ */
+struct scanner_comb {
+    unsigned short n_states;
+    unsigned short initial_state;
+
+    unsigned int *base;             // indexed by state -> start of the row in `next` and `check`
+    unsigned short *default_state;  // indexed by state -> state of the default row, SCANNER_COMB_NO_DEFAULT if none
+
+    unsigned int n_entries;         // size of `next` and `check`, padded so base + byte never overflows
+    unsigned short *next;           // indexed by base + byte -> next state
+    unsigned short *check;          // indexed by base + byte -> owner state of the entry, SCANNER_COMB_FREE if unused
+
+    unsigned short *token;          // indexed by state -> same as `scanner_dfa.token`
+};
+
+/**
+ * Packs the transition table of the DFA. The DFA is not modified.
+ */
+struct scanner_comb *scanner_comb_create_from_dfa(const struct scanner_dfa * const dfa);
+void scanner_comb_destroy(struct scanner_comb *comb);
+
+static inline unsigned short scanner_comb_get_transition(const struct scanner_comb * const comb,
+                                                         const unsigned short state,
+                                                         const unsigned char byte) {
+    unsigned int index = comb->base[state] + byte;
+    if (comb->check[index] == state) {
+        return comb->next[index];
+    }
+
+    unsigned short default_state = comb->default_state[state];
+    if (default_state != SCANNER_COMB_NO_DEFAULT) {
+        index = comb->base[default_state] + byte;
+        if (comb->check[index] == default_state) {
+            return comb->next[index];
+        }
+    }
+
+    return SCANNER_DFA_STATE_ERROR;
+}
+
+/**
+ * Size of the transition table in bytes (token arrays are not included).
+ */
+unsigned int scanner_comb_size(const struct scanner_comb * const comb);
+unsigned int scanner_dfa_table_size(const struct scanner_dfa * const dfa);
+
+enum SCANNER_TABLE_LAYOUT {
+    SCANNER_TABLE_LAYOUT_DENSE = 0,
+    SCANNER_TABLE_LAYOUT_COMB
+};
+
+/**
+ * Chooses the layout of the emitted transition table.
+ *
+ * The dense table is one load per byte and it is the faster one while it fits in the cache,
+ * so the comb is only chosen if the dense table is bigger than SCANNER_COMB_DENSE_LIMIT
+ * and the comb is at most half of its size.
+ */
+#define SCANNER_COMB_DENSE_LIMIT (16 * 1024)
+
+enum SCANNER_TABLE_LAYOUT scanner_comb_choose_layout(const struct scanner_dfa * const dfa,
+                                                     const struct scanner_comb * const comb);
+
+#endif // SCANNER_COMB_H
@@ -0,0 +1,116 @@
+#ifndef SCANNER_DFA_H
+#define SCANNER_DFA_H
+
+#include <cutils/byteset.h>
+#include <scanner_utils/fa.h>
+
+#define SCANNER_DFA_STATE_ERROR 0
+
+/**
+ * scanner_dfa is the compiled, table-driven form of a DFA that the scanner runs.
+ *
+ * While `scanner_fa_128` is compact and convenient to build, looking up a
+ * transition in it means searching the transitions of the state.
+ * Here every state has a full row of 256 next states, so a transition is a single load:
+ *
+ *      next_state = transition[state * 256 + byte]
+ *
+ * Conventions are the same as in `scanner_fa_128`:
+ *   - state_0 is ALWAYS the error state, every transition of it leads to itself
+ *   - a state is accepting if it recognizes a token (`token[state] != 0`)
+ */
+struct scanner_dfa {
+    unsigned short n_states;      // number of states including the error state
+    unsigned short initial_state;
+
+    unsigned short *transition;   // indexed by state * 256 + byte -> returns the next state
+    unsigned short *token;        // indexed by state -> returns the index of the recognized token, 0 if not accepting
+
+    // Acceleration of self-loop states (e.g. identifier bodies, whitespace runs, comments)
+    // A state is accelerated if most of its transitions lead back to itself. The scanner
+    // can then consume the whole run of `self_loop` bytes with a vectorized byte-set span
+    // instead of a table lookup per byte.
+    unsigned char *accelerated;         // indexed by state -> 1 if the state is accelerated
+    struct cutils_byteset *self_loop;   // indexed by state -> bytes on which the state loops on itself
+};
+
+/**
+ * Creates a DFA with `n_states` states (including the error state) where every transition leads to the error state.
+ */
+struct scanner_dfa *scanner_dfa_create(const unsigned short n_states);
+
+/**
+ * Compiles a deterministic `scanner_fa_128` (e.g. the output of `scanner_fa_nfa_to_dfa`).
+ * Every accepting state of the FA recognizes `token`.
+ * The states keep their numbering.
+ */
+struct scanner_dfa *scanner_dfa_create_from_fa(const struct scanner_fa_128 * const fa, const unsigned short token);
+
+void scanner_dfa_destroy(struct scanner_dfa *dfa);
+
+void scanner_dfa_set_transition(struct scanner_dfa * const dfa, const unsigned short state, const unsigned char byte, const unsigned short next_state);
+unsigned short scanner_dfa_get_transition(const struct scanner_dfa * const dfa, const unsigned short state, const unsigned char byte);
+
+/**
+ * Minimizes the DFA by merging equivalent states (Moore's partition refinement).
+ *
+ * Two states are equivalent if they recognize the same token and, for every byte,
+ * their next states are equivalent. States that can't reach any accepting state are
+ * merged into the error state. The states are renumbered in the order of their
+ * first original state, and the accelerated states are detected again.
+ */
+void scanner_dfa_minimize(struct scanner_dfa * const dfa);
+
+/**
+ * Detects the states with a dominant self-loop and marks them accelerated.
+ *
+ * A state is accelerated if
+ *   - at least half of its non-error transitions lead back to itself, and
+ *   - its self-loop bytes can be tested with vectorized range compares
+ *     (at most CUTILS_BYTESET_MAX_RANGES ranges, see cutils/byteset.h)
+ *
+ * Has to be called again if the transitions change.
+ */
+void scanner_dfa_find_accelerated(struct scanner_dfa * const dfa);
+
+/**
+ * Renumbers the states of the DFA: the new state `i` is the old state `order[i]`.
+ * `order` has to be a permutation of the states with `order[0]` being the error state.
+ */
+void scanner_dfa_renumber(struct scanner_dfa * const dfa, const unsigned short * const order);
+
+// --------------------------------------
+// CACHE-LOCALITY RENUMBERING
+//
+// The state numbers that the construction gives (Thompson merge order, subset order)
+// have nothing to do with which states are hot while scanning. The rows of the
+// transition table are 512 bytes each, so the states that are visited the most
+// should sit next to each other at the beginning of the table.
+// --------------------------------------
+
+/**
+ * Renumbers the states in breadth-first order from the initial state
+ * (bytes are visited in increasing order, unreachable states go to the end).
+ * The states close to the initial state, that are visited by every token, end up next to each other.
+ */
+void scanner_dfa_renumber_bfs(struct scanner_dfa * const dfa);
+
+/**
+ * Counts how many times each state is entered while scanning the corpus
+ * with maximal munch (rollbacks included). `visits` has `n_states` elements.
+ */
+void scanner_dfa_profile(const struct scanner_dfa * const dfa,
+                         const char * const corpus,
+                         const unsigned int corpus_n,
+                         unsigned int * const visits);
+
+/**
+ * Profile guided renumbering: the states are renumbered by decreasing visit
+ * frequency on a sample corpus (see `scanner_dfa_profile`),
+ * ties are broken by breadth-first order.
+ */
+void scanner_dfa_renumber_profile(struct scanner_dfa * const dfa,
+                                  const char * const corpus,
+                                  const unsigned int corpus_n);
+
+#endif // SCANNER_DFA_H
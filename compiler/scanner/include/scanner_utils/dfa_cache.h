@@ -0,0 +1,75 @@
+#ifndef SCANNER_DFA_CACHE_H
+#define SCANNER_DFA_CACHE_H
+
+#include <scanner_utils/dfa.h>
+#include <scanner_utils/rules.h>
+
+/**
+ * On-disk cache of compiled DFAs.
+ *
+ * The DFA of a rule list only depends on the definitions (names, regexes and order)
+ * and on the construction (the code of the library), so the result of `scanner_rules_compile(rules, NULL)` can be
+ * stored under a hash of them and loaded instead of going through
+ * parse -> Thompson -> subset construction -> minimization again.
+ * Comments, options and `skip` of the .lang file don't change the key.
+ * The DFAs of the single rules and their combinations have their own keys, they are cached
+ * by `scanner_rules_compile` (`dfa_cache` of the rules).
+ *
+ * Every DFA is a file `<key>.dfa` in the cache directory. The files are written to a temporary
+ * file and renamed, so concurrent generators (and threads) can share the directory. A hit updates the
+ * modification time of the file, `scanner_dfa_cache_prune` removes the files that weren't
+ * used for a while.
+ */
+
+// the version of the file format, part of the keys
+#define SCANNER_DFA_CACHE_VERSION 2
+
+/**
+ * The build of the construction, part of the keys: a hash of the sources of scanner_utils and cutils
+ * that the build computes at configure time (see scanner/src/CMakeLists.txt), so the DFAs of an
+ * older generator are never loaded after a change of the code. 0 if the build doesn't set it.
+ */
+unsigned long long scanner_dfa_cache_build();
+
+/**
+ * The key of the DFA of `rules`: a 64-bit hash of the definitions, SCANNER_DFA_CACHE_VERSION
+ * and `scanner_dfa_cache_build()`.
+ */
+unsigned long long scanner_dfa_cache_key(const struct scanner_rules * const rules);
+
+/**
+ * The key of the DFA of a single regex: its text and the definitions that it references (recursively).
+ * The name of the definition is not part of it.
+ */
+unsigned long long scanner_dfa_cache_regex_key(const struct scanner_regex_definition * const definition);
+
+/**
+ * The key of the combination of two DFAs (see `scanner_rules_compile`), in priority order.
+ */
+unsigned long long scanner_dfa_cache_combine_key(const unsigned long long a, const unsigned long long b);
+
+/**
+ * Loads the DFA of `key` from the cache directory.
+ *
+ * @return NULL on a miss (or if the cached file is invalid)
+ */
+struct scanner_dfa *scanner_dfa_cache_load(const char * const directory, const unsigned long long key);
+
+/**
+ * Stores the DFA under `key`, the directory is created if it doesn't exist.
+ * A failure is only a warning, the cache is best effort.
+ *
+ * @return 1 if the DFA was stored
+ */
+unsigned char scanner_dfa_cache_store(const char * const directory, const unsigned long long key,
+                                      const struct scanner_dfa * const dfa);
+
+/**
+ * Removes the cached DFAs that were not stored or loaded in the last `max_age` seconds
+ * (all of them with 0).
+ *
+ * @return the number of removed DFAs
+ */
+unsigned int scanner_dfa_cache_prune(const char * const directory, const unsigned long long max_age);
+
+#endif // SCANNER_DFA_CACHE_H
@@ -0,0 +1,67 @@
+#ifndef SCANNER_EMIT_H
+#define SCANNER_EMIT_H
+
+#include <stdio.h>
+
+#include <scanner_utils/dfa.h>
+#include <scanner_utils/rules.h>
+
+/**
+ * Emission of a compiled scanner as a self-contained C source/header pair.
+ *
+ * Every identifier of the generated code starts with `name` (macros with its upper case form),
+ * so more scanners can be linked into the same program. The header declares:
+ *
+ *      #define NAME_TOKEN_ERROR 0
+ *      #define NAME_TOKEN_<RULE> i + 1             one for every rule of the .lang file
+ *      #define NAME_N_TOKENS
+ *
+ *      struct name_token { unsigned int start; unsigned int length; unsigned short token; };
+ *
+ *      extern const char * const name_token_names[NAME_N_TOKENS];
+ *      extern const unsigned char name_token_skip[NAME_N_TOKENS];
+ *
+ *      unsigned int name_next_token(text, text_n, text_i, &token);     the longest token at text_i
+ *      unsigned int name_scan(text, text_n, &text_i, tokens, capacity); the tokens until `capacity`
+ *
+ * The generated scanner has the same tokens as `scanner_cursor_scan` (with the default options
+ * of the runtime), except that there is no failed memo: the rollbacks of a
+ * pathological language can take quadratic time, like in most generated scanners.
+ * The keywords are reclassified like in the runtime: the keyword table of the post-pass
+ * (see keywords.h) is emitted with its seed, and the lexemes of the shadowing tokens are
+ * looked up in it after the DFA.
+ *
+ * The backend of the DFA (`backend` of the rules, see lang.h):
+ *  - SCANNER_BACKEND_TABLE: a transition table and a loop that looks up the next state.
+ *    The table is `static const` (read-only pages that are shared between the processes),
+ *    aligned to the cache lines and typed to the smallest unsigned integer that fits.
+ *    The token of the next state is packed into the high bits of its entry,
+ *    so the loop makes a single load per byte.
+ *    If `scanner_comb_choose_layout` picks the comb (a big and sparse table), it is emitted as
+ *    with SCANNER_BACKEND_COMB.
+ *  - SCANNER_BACKEND_COMB: the row displacement table of comb.h as base/default/next/check arrays,
+ *    the entries of `next` are packed like the dense ones. A byte is one or two probes
+ *    (the row of the state, then its default row).
+ *  - SCANNER_BACKEND_DIRECT: one label per state, the byte is tested with range compares
+ *    (or a switch if the state has many ranges) and the next state is a goto, so the C compiler
+ *    can optimize the branches and inline the character class tests
+ */
+
+/**
+ * Writes the header of the scanner.
+ */
+void scanner_emit_header(FILE * const out, const char * const name, const struct scanner_rules * const rules);
+
+/**
+ * Writes the source of the scanner with the backend of `rules`, it includes `header_name`.
+ * `dfa` and `keywords` are the results of `scanner_rules_compile(rules, &keywords)`,
+ * `keywords` can be NULL (the keywords are in the DFA then).
+ */
+void scanner_emit_source(FILE * const out,
+                         const char * const name,
+                         const char * const header_name,
+                         const struct scanner_rules * const rules,
+                         const struct scanner_dfa * const dfa,
+                         const struct scanner_keywords * const keywords);
+
+#endif // SCANNER_EMIT_H
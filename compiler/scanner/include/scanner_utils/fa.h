@@ -3,6 +3,7 @@
 
 #include <cutils/arrayi.h>
 #include <cutils/set.h>
+#include <scanner_utils/regex_tree.h>
 
 /**
  * Helper struct for a more efficient implementation of table-lookup
@@ -135,6 +136,24 @@ void scanner_fa_set_accepting(struct scanner_fa_128 * const fa, unsigned char st
  */
 struct scanner_fa_128 *scanner_fa_thompson_create_char(unsigned char character);
 
+/**
+ * Creates a copy of the FA with the same state numbering.
+ */
+struct scanner_fa_128 *scanner_fa_copy(const struct scanner_fa_128 * const fa);
+
+/**
+ * Constructs a simple 2 state FA with a transition from the first to the second on every character of the set.
+ * This is how ranges, wildcards and whitespaces are built, instead of alterations of single characters.
+ */
+struct scanner_fa_128 *scanner_fa_thompson_create_set(const struct cutils_set128 characters);
+
+/**
+ * Constructs the NFA of a regex tree created by `scanner_regex_parse`.
+ * The function implements a recursive post-order traversal of the tree.
+ * A reference (`{NAME}`) is a copy of the NFA of its definition.
+ */
+struct scanner_fa_128 *scanner_fa_thompson_from_regex(const struct scanner_regex_tree_node * const root);
+
 /**
  * Construct an NFA equivalent to regex alteration between two FAs.
  * The result will be written into `fa0`.
@@ -168,6 +187,19 @@ void scanner_fa_merge(struct scanner_fa_128 * const fa0, const struct scanner_fa
  */
 void scanner_fa_nfa_to_dfa(struct scanner_fa_128 * const fa0);
 
+/**
+ * Same as `scanner_fa_nfa_to_dfa` but also outputs the NFA states that every DFA state represents.
+ * `(*dfa_subsets)[i]` is the subset of the (i+1)-th DFA state (state_0 is the error state).
+ * The caller owns the array.
+ */
+void scanner_fa_nfa_to_dfa_subsets(struct scanner_fa_128 * const fa0, struct cutils_set128 ** const dfa_subsets);
+
+/**
+ * Computes the epsilon closure (states reachable with empty transitions) of `input_states`.
+ * The closure includes the `input_states`.
+ */
+struct cutils_set128 scanner_fa_nfa_eclosure(const struct scanner_fa_128 * const nfa, struct cutils_set128 input_states);
+
 // ---------------------------------
 
 // -----------
@@ -0,0 +1,63 @@
+#ifndef SCANNER_KEYWORDS_H
+#define SCANNER_KEYWORDS_H
+
+/**
+ * Perfect hash table of keywords.
+ *
+ * Keywords (token rules that are pure literals, e.g. `while`) are usually shadowed by a
+ * general identifier rule that matches them too. Spelling every keyword out in the DFA
+ * multiplies the states, so instead the identifier is recognized by the DFA and its lexeme
+ * is reclassified with a single lookup in this table afterwards.
+ *
+ * The hash function is FNV-1a with a seed that was searched for to make the table
+ * collision-free, so a lookup is one hash, one slot and one comparison.
+ */
+struct scanner_keywords {
+    unsigned int seed;
+    unsigned int n_slots;        // power of 2
+    unsigned short n_keywords;
+
+    unsigned short *token;        // indexed by slot -> keyword token, 0 if the slot is empty
+    unsigned short *shadow_token; // indexed by slot -> only lexemes of this token are reclassified
+    unsigned int *literal_offset; // indexed by slot -> offset of the keyword in `literals`
+    unsigned char *literal_n;     // indexed by slot -> length of the keyword
+
+    unsigned char min_n;          // shortest keyword, to reject lexemes without hashing
+    unsigned char max_n;          // longest keyword
+
+    char *literals;
+    unsigned int _literals_size;
+};
+
+struct scanner_keywords *scanner_keywords_create();
+void scanner_keywords_destroy(struct scanner_keywords *keywords);
+
+/**
+ * Adds a keyword. When the DFA recognizes `literal` as `shadow_token`, it is reclassified as `token`.
+ * The table has to be rebuilt with `scanner_keywords_build` after adding keywords.
+ */
+void scanner_keywords_add(struct scanner_keywords * const keywords,
+                          const char * const literal,
+                          const unsigned char literal_n,
+                          const unsigned short token,
+                          const unsigned short shadow_token);
+
+/**
+ * Searches for a seed that places every keyword into a different slot.
+ * The keywords have to be different, the build fails on a keyword that was added twice.
+ */
+void scanner_keywords_build(struct scanner_keywords * const keywords);
+
+/**
+ * Returns the token of the lexeme after reclassification:
+ * the keyword token if the lexeme is a keyword shadowed by `token`, `token` otherwise.
+ * `keywords` can be NULL if there are no keywords.
+ */
+unsigned short scanner_keywords_classify(const struct scanner_keywords * const keywords,
+                                         const unsigned short token,
+                                         const char * const lexeme,
+                                         const unsigned int lexeme_n);
+
+unsigned int _scanner_keywords_hash(const unsigned int seed, const char * const s, const unsigned int n);
+
+#endif // SCANNER_KEYWORDS_H
@@ -0,0 +1,48 @@
+#ifndef SCANNER_LANG_H
+#define SCANNER_LANG_H
+
+#include <scanner_utils/rules.h>
+
+/**
+ * Reader of the language syntax description files (.lang, see scanner/test_syntax_file.lang).
+ * 
+ * Every non-empty line that doesn't start with `#` is a token definition:
+ * 
+ *      NAME : regex
+ * 
+ * The regex goes until the end of the line (trailing whitespace is ignored).
+ * Definitions that start with `skip` (e.g. `skip WHITESPACE : ( |\t|\n)+`) are recognized
+ * by the scanner, but their tokens are never emitted.
+ * The definitions are added in order, higher definitions get more priority.
+ * 
+ * The names are C identifiers (letters, digits and `_`, not starting with a digit),
+ * they are unique among the rules and the definitions.
+ * 
+ * A regex can reference any definition above it with `{NAME}` (e.g. `REGISTER : r{DIGIT}+`).
+ * Definitions that start with `define` (e.g. `define LETTER : [a-z]|[A-Z]`) are only
+ * for the references, they are not tokens. The regex of a definition is parsed and compiled
+ * once, however many times it is referenced.
+ * 
+ * Lines that start with `%` are options of the generator:
+ * 
+ *      %backend table      the scanner is emitted as a transition table (default),
+ *                          row displacement packed if the dense table is big and sparse
+ *      %backend direct     the scanner is emitted as direct-coded C (see emit.h)
+ *      %backend comb       the scanner is emitted as a row displacement packed table
+ */
+
+/**
+ * Adds the token definitions of `source` to `rules`.
+ * 
+ * @return 0 on success, otherwise the (1-based) line of the first invalid definition
+ */
+unsigned int scanner_lang_parse(struct scanner_rules * const rules, const char * const source, const unsigned int n);
+
+/**
+ * Reads a .lang file (mapped, see cutils/mapped_file.h) into a new rule list.
+ * 
+ * @return NULL if the file can't be read or it has an invalid definition (the error is printed)
+ */
+struct scanner_rules *scanner_lang_load(const char * const path);
+
+#endif // SCANNER_LANG_H
@@ -0,0 +1,23 @@
+#ifndef SCANNER_LINE_INDEX_H
+#define SCANNER_LINE_INDEX_H
+
+/**
+ * Offsets of the line starts of a source text, for calculating positions on demand.
+ *
+ * Building the index is a single vectorized newline search over the text (memchr),
+ * a position is a binary search over the line starts.
+ */
+struct scanner_line_index {
+    unsigned int n_lines;
+    unsigned int *line_start; // indexed by line - 1 -> offset of the first char of the line
+};
+
+struct scanner_line_index *scanner_line_index_create(const char * const source, const unsigned int source_n);
+void scanner_line_index_destroy(struct scanner_line_index *index);
+
+/**
+ * Line (starts from 1) of the char at `offset`.
+ */
+unsigned int scanner_line_index_line(const struct scanner_line_index * const index, const unsigned int offset);
+
+#endif // SCANNER_LINE_INDEX_H
@@ -0,0 +1,50 @@
+#ifndef SCANNER_PARALLEL_H
+#define SCANNER_PARALLEL_H
+
+#include <scanner_utils/runtime.h>
+#include <scanner_utils/token_stream.h>
+
+/**
+ * Inputs smaller than this per thread are not split any further.
+ */
+#define SCANNER_PARALLEL_MIN_CHUNK (256 * 1024)
+
+/**
+ * Parallel scanning of big inputs with speculative chunks.
+ * 
+ * The text is split into equal chunks, and every chunk is scanned on its own thread
+ * as if a token started at its first char. The speculation is right for most of the chunk:
+ * the tokens from a position only depend on the position, so as soon as the real tokens
+ * (coming from the chunk before) reach a token start of the speculative scan, the two
+ * scans are the same from there on.
+ * 
+ * The chunks are stitched in order: the end of the last real token is looked up among the
+ * token starts of the next chunk. If it is not there (e.g. the chunk started inside a comment),
+ * the real tokens are scanned one by one until they reach a speculative token start
+ * (re-synchronization), which usually takes a few tokens.
+ * Positions of the chunks are counted in parallel from the start of the chunk and shifted
+ * when they are appended (see `scanner_token_stream_append`).
+ * 
+ * The cursors and the chunk streams are kept between scans.
+ */
+struct scanner_parallel {
+    const struct scanner *scanner;
+    unsigned int n_threads;
+
+    struct scanner_cursor **_cursors;         // one per thread
+    struct scanner_token_stream **_chunks;    // speculative tokens of the chunks
+};
+
+struct scanner_parallel *scanner_parallel_create(const struct scanner * const scanner, const unsigned int n_threads);
+void scanner_parallel_destroy(struct scanner_parallel *parallel);
+
+/**
+ * Splits the whole text into tokens, the same tokens as `scanner_cursor_scan`.
+ * The stream has to be created on (or reset to) the same text.
+ */
+void scanner_parallel_scan(struct scanner_parallel * const parallel,
+                           const char * const text,
+                           const unsigned int text_n,
+                           struct scanner_token_stream * const stream);
+
+#endif // SCANNER_PARALLEL_H
@@ -9,7 +9,8 @@ enum SCANNER_REGEX_ERROR {
     SCANNER_REGEX_ERROR_BACKSLASH,
     SCANNER_REGEX_ERROR_RANGE,
     SCANNER_REGEX_ERROR_OPENINGP,
-    SCANNER_REGEX_ERROR_CLOSINGP
+    SCANNER_REGEX_ERROR_CLOSINGP,
+    SCANNER_REGEX_ERROR_REFERENCE
 };
 
 struct SCANNER_REGEX_STATUS {
@@ -18,6 +19,22 @@ struct SCANNER_REGEX_STATUS {
     char* error_msg;
 };
 
+struct scanner_fa_128;
+
+/**
+ * A named regex that other regexes can reference with `{NAME}`.
+ * 
+ * The regex is parsed and compiled to its Thompson NFA once, the references
+ * are REFERENCE nodes of the tree (they don't own the definition), and the NFA
+ * of the definition is copied into the NFA of the referencing regex.
+ */
+struct scanner_regex_definition {
+    struct cutils_string *name;
+    struct cutils_string *regex;
+    struct scanner_regex_tree_node *tree;
+    struct scanner_fa_128 *nfa;
+};
+
 /**
  * Parses a regex from a .lang file into an execution tree.
  * 
@@ -34,4 +51,17 @@ struct SCANNER_REGEX_STATUS {
 struct SCANNER_REGEX_STATUS scanner_regex_parse(const struct cutils_string * const rgx,
                                                 struct scanner_regex_tree_node ** root);
 
+/**
+ * Same as `scanner_regex_parse`, `{NAME}` is a reference to the definition called NAME
+ * (the last one if there are more). NAME is made of letters, digits and `_`,
+ * a `{` that doesn't start such a reference is a literal.
+ * A reference to an unknown name is an error.
+ * 
+ * With `definitions == NULL` every `{` is a literal.
+ */
+struct SCANNER_REGEX_STATUS scanner_regex_parse_with_definitions(const struct cutils_string * const rgx,
+                                                                 struct scanner_regex_definition * const * const definitions,
+                                                                 const unsigned int n_definitions,
+                                                                 struct scanner_regex_tree_node ** root);
+
 #endif // SCANNER_REGEX_PARSER_H_
\ No newline at end of file
@@ -0,0 +1,41 @@
+#ifndef SCANNER_REGEX_PREFIX_H_
+#define SCANNER_REGEX_PREFIX_H_
+
+#include <scanner_utils/regex_tree.h>
+#include <cutils/byteset.h>
+
+#define SCANNER_REGEX_PREFIX_MAX_LITERAL 32
+
+/**
+ * Facts about how the matches of a regex begin.
+ *
+ * The scanner can use them to skip ahead in the text to the next position
+ * where a match can start, before it enters the automaton:
+ *  - `first_bytes`: a match can only start with one of these bytes
+ *  - `literal`: every match starts with this literal
+ *    (e.g. `r[0-9]+` -> "r", `"//"(.)*\n` -> "//")
+ */
+struct scanner_regex_prefix {
+    struct cutils_byteset first_bytes;
+    unsigned char nullable;   // the regex matches the empty string (first_bytes is not exhaustive)
+    unsigned char exact;      // the regex matches `literal` and nothing else (e.g. keywords)
+    unsigned char literal_n;  // length of the required literal prefix
+    char literal[SCANNER_REGEX_PREFIX_MAX_LITERAL];
+};
+
+/**
+ * Analyzes a regex tree created by `scanner_regex_parse`.
+ *
+ * Implements a single recursive post-order traversal of the tree.
+ */
+void scanner_regex_prefix_analyze(const struct scanner_regex_tree_node * const root,
+                                  struct scanner_regex_prefix * const prefix);
+
+/**
+ * Combines the prefix of two alternatives (e.g. two token rules) into `a`:
+ * the first bytes are united and the literal is cut to the common prefix.
+ */
+void scanner_regex_prefix_alter(struct scanner_regex_prefix * const a,
+                                const struct scanner_regex_prefix * const b);
+
+#endif // SCANNER_REGEX_PREFIX_H_
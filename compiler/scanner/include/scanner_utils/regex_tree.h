@@ -11,9 +11,12 @@ enum SCANNER_REGEX_TREE_NODE_TYPE {
     SCANNER_REGEX_TREE_NODE_RANGE,    // `[0-9]`: range
     SCANNER_REGEX_TREE_NODE_WILDCARD, // `.`: any character
     SCANNER_REGEX_TREE_NODE_EMPTYLIT, // `\e`: empty literal
-    SCANNER_REGEX_TREE_NODE_ANYWHITE  // `\s`: any whitespace character
+    SCANNER_REGEX_TREE_NODE_ANYWHITE, // `\s`: any whitespace character
+    SCANNER_REGEX_TREE_NODE_REFERENCE // `{NAME}`: a named definition (see regex_parser.h)
 };
 
+struct scanner_regex_definition;
+
 struct scanner_regex_tree_node {
     enum SCANNER_REGEX_TREE_NODE_TYPE type;
     char literal;
@@ -21,6 +24,7 @@ struct scanner_regex_tree_node {
     unsigned short children_n;
     unsigned short _children_capacity;
     struct scanner_regex_tree_node **children; // TODO it would be nice to have a void* dynamic array
+    const struct scanner_regex_definition *definition; // REFERENCE: the referenced definition (not owned)
 };
 
 /**
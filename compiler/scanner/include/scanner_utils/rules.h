@@ -0,0 +1,121 @@
+#ifndef SCANNER_RULES_H
+#define SCANNER_RULES_H
+
+#include <cutils/string.h>
+#include <scanner_utils/dfa.h>
+#include <scanner_utils/keywords.h>
+#include <scanner_utils/regex_parser.h>
+#include <scanner_utils/regex_prefix.h>
+
+/**
+ * A token definition of a .lang file:
+ * 
+ *      NAME : regex
+ *      skip NAME : regex
+ * 
+ * `name`, `regex` and `tree` belong to `definition`, so other rules can reference the rule with `{NAME}`.
+ */
+struct scanner_rule {
+    struct cutils_string *name;
+    struct cutils_string *regex;
+    struct scanner_regex_tree_node *tree;
+    struct scanner_regex_prefix prefix;
+    unsigned char skip;     // recognized, but never emitted (whitespace, comments)
+
+    const struct scanner_regex_definition *definition;
+};
+
+// the C code that the generator emits for the rules (see emit.h)
+#define SCANNER_BACKEND_TABLE 0     // transition table and a loop
+#define SCANNER_BACKEND_DIRECT 1    // direct-coded states with gotos
+#define SCANNER_BACKEND_COMB 2      // row displacement table, `table` picks it for big and sparse tables
+
+/**
+ * Ordered list of token definitions, higher definitions get more priority.
+ * 
+ * The token of the i-th rule is i+1.
+ * Token 0 is always the category for ERROR (uncategorized), it is not defined by the user.
+ * 
+ * The regexes can reference the definitions before them with `{NAME}`: the rules, and the
+ * named regexes that are not tokens (`scanner_rules_define`). Every definition is parsed
+ * and compiled to an NFA once, the references reuse its NFA.
+ */
+struct scanner_rules {
+    unsigned short n;
+    unsigned short _capacity;
+    struct scanner_rule *rules;
+
+    unsigned short n_definitions;
+    unsigned short _capacity_definitions;
+    struct scanner_regex_definition **definitions;  // in order, the rules and the other definitions
+
+    unsigned char backend;  // SCANNER_BACKEND_*, `%backend` option of a .lang file
+
+    // directory of the on-disk cache of the rule DFAs and their combinations (see dfa_cache.h),
+    // NULL without cache
+    const char *dfa_cache;
+
+    // the threads that compile the rule DFAs and their combinations, 1 by default
+    unsigned int n_threads;
+};
+
+struct scanner_rules *scanner_rules_create();
+void scanner_rules_destroy(struct scanner_rules *rules);
+
+/**
+ * Parses the regex and appends the rule to the end of the list (lowest priority).
+ * On error the rule is not added.
+ */
+struct SCANNER_REGEX_STATUS scanner_rules_add(struct scanner_rules * const rules,
+                                              const char * const name,
+                                              const char * const regex);
+
+/**
+ * Adds a named regex that is not a token, only the regexes after it can reference it with `{NAME}`.
+ * On error the definition is not added.
+ */
+struct SCANNER_REGEX_STATUS scanner_rules_define(struct scanner_rules * const rules,
+                                                 const char * const name,
+                                                 const char * const regex);
+
+/**
+ * Same as `scanner_rules_add`, the tokens of the rule are skipped by the scanner.
+ */
+struct SCANNER_REGEX_STATUS scanner_rules_add_skip(struct scanner_rules * const rules,
+                                                   const char * const name,
+                                                   const char * const regex);
+
+/**
+ * Compiles the rules into a single minimal DFA.
+ * 
+ * Every rule is compiled separately (regex -> NFA -> DFA) and the rule DFAs are combined
+ * pairwise by product constructions in a binary tree over the rules, every combination is
+ * minimized. So the 127 state limit of `scanner_fa_128` holds per rule instead of for
+ * the whole language. An accepting state recognizes the token of the highest priority rule
+ * that accepts there.
+ * 
+ * With `dfa_cache`, the rule DFAs and the nodes of the tree are cached on disk:
+ * after a change of a rule only its DFA and the combinations above it are compiled again.
+ * 
+ * With `n_threads` > 1, the rule DFAs and the independent combinations are compiled in parallel.
+ * The tree doesn't depend on the threads, the DFA is the same with any number of them.
+ * 
+ * Keyword post-pass (only if `keywords` is not NULL):
+ *  Rules that are pure literals (e.g. `while`) and are matched by another rule as well
+ *  (e.g. by an identifier rule) are left out of the DFA and put into a perfect hash table.
+ *  The scanner reclassifies the lexemes of the shadowing rule with `scanner_keywords_classify`,
+ *  so the priorities stay intact while the DFA gets much smaller.
+ *  Literals shadowed by a higher priority rule can never be recognized, they are dropped.
+ *  `*keywords` is NULL if there are no keywords.
+ */
+struct scanner_dfa *scanner_rules_compile(const struct scanner_rules * const rules,
+                                          struct scanner_keywords ** const keywords);
+
+/**
+ * Compiles only the rules with `included[i] != 0` (without keyword post-pass).
+ * The tokens keep their numbering.
+ */
+struct scanner_dfa *scanner_rules_compile_included(const struct scanner_rules * const rules,
+                                                   const unsigned char * const included);
+
+#endif // SCANNER_RULES_H
@@ -0,0 +1,372 @@
+#ifndef SCANNER_RUNTIME_H
+#define SCANNER_RUNTIME_H
+
+#include <cutils/byteset.h>
+#include <cutils/mapped_file.h>
+#include <cutils/string.h>
+#include <scanner_utils/dfa.h>
+#include <scanner_utils/keywords.h>
+#include <scanner_utils/regex_prefix.h>
+#include <scanner_utils/rules.h>
+#include <scanner_utils/token_stream.h>
+
+/**
+ * A compiled scanner: the DFA, the keyword table and the token names.
+ *
+ * It is immutable after creation, so one scanner can be shared by any number of threads
+ * without locks. Everything that changes while scanning lives in a `scanner_cursor`,
+ * every thread has to use its own cursor.
+ *
+ *      struct scanner *scanner = scanner_create_from_rules(rules);
+ *
+ *      // on every thread
+ *      struct scanner_cursor *cursor = scanner_cursor_create(scanner);
+ *      scanner_cursor_scan(cursor, text, text_n, stream);
+ */
+struct scanner {
+    struct scanner_dfa *dfa;
+    struct scanner_keywords *keywords;     // NULL if there are no keywords
+
+    // token names, TOKEN[0] is always the category for ERROR (uncategorized)
+    unsigned short n_tokens;
+    struct cutils_string **token_names;
+
+    // candidate positions of search mode (derived from the DFA)
+    struct cutils_byteset first_bytes;     // a token can only start with one of these bytes
+    unsigned char required_prefix_n;       // every token starts with this literal
+    char required_prefix[SCANNER_REGEX_PREFIX_MAX_LITERAL];
+
+    // skip tokens (whitespace, comments) are consumed without emitting them
+    unsigned char *skip;                   // indexed by token -> 1 if the token is skipped
+    struct cutils_byteset skip_run_bytes;  // these bytes start a skip token that is a single run of bytes
+
+    // error recovery: a run of chars where no token starts (e.g. a binary blob) becomes a single
+    // uncategorized token until the next byte of `first_bytes`, instead of one token per char
+    // (off by default, has to be set before scanning)
+    unsigned char coalesce_errors;
+};
+
+/**
+ * Creates a scanner that takes the ownership of `dfa` and `keywords`.
+ * `token_names` has `n_tokens` names (without the uncategorized token) and is copied.
+ * `skip` marks the skipped tokens in the same order (NULL if nothing is skipped).
+ */
+struct scanner *scanner_create(struct scanner_dfa *dfa,
+                               struct scanner_keywords *keywords,
+                               const char * const * const token_names,
+                               const unsigned char * const skip,
+                               const unsigned short n_tokens);
+
+/**
+ * Compiles the rules (with keyword post-pass) and creates a scanner from them.
+ */
+struct scanner *scanner_create_from_rules(const struct scanner_rules * const rules);
+
+void scanner_destroy(struct scanner *scanner);
+
+/**
+ * Initial number of positions that the failed (state, position) memo of a cursor covers.
+ * Power of 2.
+ */
+#define SCANNER_CURSOR_WINDOW 1024
+
+/**
+ * Number of chars after the last accept that a token attempt walks without the failed memo.
+ */
+#define SCANNER_CURSOR_LOOKAHEAD 64
+
+/**
+ * Per-thread state of scanning with a shared `scanner`.
+ * 
+ * The cursor runs the linear time maximal munch: only the last accepting position is remembered,
+ * and the (state, position) pairs from where no accepting state could be reached are marked failed,
+ * so they are never walked again. Most attempts end a few chars after their last accept, so the memo
+ * is only used past SCANNER_CURSOR_LOOKAHEAD chars of lookahead, which keeps the time linear
+ * while the common case is a plain DFA loop. The failed marks are kept in a sliding window of positions
+ * after the start of the current token (position-major bit rows, one bit per state).
+ * The window only grows if a token attempt looks further ahead than the window,
+ * so the memory depends on the longest lookahead and not on the size of the text.
+ */
+struct scanner_cursor {
+    const struct scanner *scanner;
+
+    unsigned int _row_bytes;          // size of the failed bits of a position
+    unsigned char *_failed;           // `_window` rows, indexed by position % `_window`
+    unsigned int _window;             // number of positions in the window, power of 2
+    unsigned int _window_base;        // first position of the window
+    unsigned int _marked_end;         // position after the last failed mark, the rows from there are clear
+    unsigned int _offset;             // position of the first char of the current text in the whole input
+    const char *_text;                // text of the failed marks for `scanner_cursor_scan_range`
+    unsigned int _reach;              // end of the examined text, see `scanner_token_stream.reach`
+
+    unsigned short *_path;            // states after the last accepting state
+    unsigned int _path_capacity;
+};
+
+/**
+ * Match of a token in progress (internal, see `scanner_push`).
+ */
+struct _scanner_match {
+    unsigned int token_start;
+    unsigned int token_end;       // position after the last accepted token
+    unsigned short state;
+    unsigned short last_token;    // 0 if nothing was accepted yet
+    unsigned int text_i;
+    unsigned int path_start;      // the path is stored in the cursor, path[k] is the state before text[path_start + k]
+    unsigned int path_n;          // 0 while the lookahead is short (no path, see SCANNER_CURSOR_LOOKAHEAD)
+};
+
+struct scanner_cursor *scanner_cursor_create(const struct scanner * const scanner);
+void scanner_cursor_destroy(struct scanner_cursor *cursor);
+
+/**
+ * Splits the whole text into tokens and appends them to `stream`.
+ * A char that doesn't start any token becomes an uncategorized token of length 1
+ * (or the run of such chars becomes one token, see `coalesce_errors`).
+ * The stream has to be created on (or reset to) the same text.
+ */
+void scanner_cursor_scan(struct scanner_cursor * const cursor,
+                         const char * const text,
+                         const unsigned int text_n,
+                         struct scanner_token_stream * const stream);
+
+/**
+ * Scans the tokens that start in [from, to) of the text (the last token can end after `to`,
+ * it is still the longest match in the whole text) and appends them to `stream`.
+ * Consecutive ranges of the same text share the failed marks of the cursor.
+ * 
+ * @return the position after the last token
+ */
+unsigned int scanner_cursor_scan_range(struct scanner_cursor * const cursor,
+                                       const char * const text,
+                                       const unsigned int text_n,
+                                       const unsigned int from,
+                                       const unsigned int to,
+                                       struct scanner_token_stream * const stream);
+
+/**
+ * Updates `stream` after an edit of its text, by re-scanning only the region that the edit can change.
+ * `text` is the edited text: `deleted_n` chars at `offset` were replaced by `inserted_n` chars.
+ * 
+ * The stream has to be scanned with `track_reach` (not in parallel, see `scanner_parallel`).
+ * The tokens that only examined the text before `offset` are kept, the scanning restarts after them,
+ * and stops at the first token boundary after the edit that is also a boundary in the old stream:
+ * every token starts in the initial state of the DFA, so from there on the old tokens are the same,
+ * only moved by the size difference of the edit.
+ * 
+ * @return the number of re-scanned tokens
+ */
+unsigned int scanner_cursor_rescan(struct scanner_cursor * const cursor,
+                                   struct scanner_token_stream * const stream,
+                                   const char * const text,
+                                   const unsigned int text_n,
+                                   const unsigned int offset,
+                                   const unsigned int deleted_n,
+                                   const unsigned int inserted_n);
+
+/**
+ * Search mode: finds every token inside the text and ignores the characters between them.
+ */
+void scanner_cursor_search(struct scanner_cursor * const cursor,
+                           const char * const text,
+                           const unsigned int text_n,
+                           struct scanner_token_stream * const stream);
+
+/**
+ * Scans a whole file ("-" is the standard input) into `stream`.
+ * 
+ * The file is mapped and scanned in place, the lexemes of the stream point into the mapping:
+ * the returned file has to be closed with `cutils_mapped_file_close` after the stream is not needed anymore.
+ * Files bigger than 4GB have to be fed through the streaming scanner.
+ * 
+ * @return NULL if the file can't be read (the stream is left untouched)
+ */
+struct cutils_mapped_file *scanner_cursor_scan_file(struct scanner_cursor * const cursor,
+                                                    const char * const path,
+                                                    struct scanner_token_stream * const stream);
+
+// --------------------------------------
+// STREAMING
+// --------------------------------------
+
+/**
+ * Push-style streaming scanner: the input is fed in arbitrary chunks (e.g. read from a pipe)
+ * and the completed tokens are delivered after every chunk.
+ * 
+ * A token can span chunk boundaries: the match in progress at the end of a chunk is paused
+ * (with its DFA state and lookahead path) and resumed on the next chunk, and only the chars
+ * from the start of the unfinished token are kept. The memory is bounded by the chunk size plus the
+ * longest token (with its lookahead), not by the size of the input.
+ * 
+ * The completed tokens are in `tokens`: their lexemes are views into the internal buffer,
+ * and they are valid until the next `scanner_push_feed` call. The offsets of the tokens are relative
+ * to the buffer, `tokens->base_offset` is the offset of the buffer in the whole input.
+ * Lines and cols are counted across the chunks.
+ */
+struct scanner_push {
+    struct scanner_cursor *cursor;
+    struct scanner_token_stream *tokens;
+
+    // called after every chunk with completed tokens (can be NULL)
+    void (*on_tokens)(struct scanner_push * const push, void *context);
+    void *context;
+
+    char *_buffer;                      // unfinished token + the last chunk
+    unsigned int _buffer_n;
+    unsigned int _buffer_capacity;
+    unsigned int _consumed;             // chars of the buffer that are already tokenized
+
+    struct _scanner_match _match;       // match in progress at the end of the buffer
+    unsigned char _matching;            // 0, or the match is paused in the DFA or in an uncategorized run
+};
+
+struct scanner_push *scanner_push_create(const struct scanner * const scanner,
+                                         void (*on_tokens)(struct scanner_push * const push, void *context),
+                                         void *context);
+void scanner_push_destroy(struct scanner_push *push);
+
+/**
+ * Scans the next chunk of the input. `tokens` holds the tokens that were completed by it.
+ */
+void scanner_push_feed(struct scanner_push * const push, const char * const chunk, const unsigned int chunk_n);
+
+/**
+ * Signals the end of the input: the unfinished token is completed.
+ */
+void scanner_push_finish(struct scanner_push * const push);
+
+// --------------------------------------
+// PULL
+// --------------------------------------
+
+#define SCANNER_PULL_RING 64    // buffered tokens (power of 2), the maximum lookahead of `scanner_peek`
+#define SCANNER_PULL_BATCH 16   // tokens scanned at once when the parser runs out of them
+
+/**
+ * A token record of the pull scanner.
+ */
+struct scanner_token {
+    unsigned int start;
+    unsigned int length;
+    unsigned short token;
+    unsigned long long position;  // packed line and col, see SCANNER_TOKEN_LINE/COL
+};
+
+/**
+ * Pull-style scanner for a parser: the tokens are scanned on demand in small batches
+ * into a ring buffer, so the first token is available right away and the scanner and
+ * the parser work on the same few cache lines of the text.
+ * 
+ *      struct scanner_pull *pull = scanner_pull_create(scanner, text, text_n);
+ *      
+ *      const struct scanner_token *token;
+ *      while ((token = scanner_next(pull)) != NULL) {
+ *          if (token->token == IF && scanner_peek(pull, 0)->token == LPAREN) { ... }
+ *      }
+ */
+struct scanner_pull {
+    struct scanner_cursor *cursor;
+    const char *text;
+    unsigned int text_n;
+
+    unsigned int _text_i;                       // where the scanning goes on
+    struct scanner_token_stream *_batch;        // positions are counted across the batches
+
+    struct scanner_token _ring[SCANNER_PULL_RING];
+    unsigned int _head;                         // the next token
+    unsigned int _n;                            // number of buffered tokens
+};
+
+struct scanner_pull *scanner_pull_create(const struct scanner * const scanner,
+                                         const char * const text,
+                                         const unsigned int text_n);
+void scanner_pull_destroy(struct scanner_pull *pull);
+
+/**
+ * Consumes the next token.
+ * The record is valid until the next call of `scanner_next` or `scanner_peek`.
+ * 
+ * @return NULL at the end of the text
+ */
+const struct scanner_token *scanner_next(struct scanner_pull * const pull);
+
+/**
+ * The k-th token after the next one without consuming anything (k = 0 is the next token).
+ * `k` has to be less than SCANNER_PULL_RING.
+ * 
+ * @return NULL if the text ends before it
+ */
+const struct scanner_token *scanner_peek(struct scanner_pull * const pull, const unsigned int k);
+
+static inline const char *scanner_pull_lexeme(const struct scanner_pull * const pull,
+                                              const struct scanner_token * const token) {
+    return pull->text + token->start;
+}
+
+// --------------------------------------
+// BATCH
+// --------------------------------------
+
+/**
+ * An input of `scanner_batch_scan`, it doesn't have to be NUL terminated.
+ */
+struct scanner_string_view {
+    const char *data;
+    unsigned int n;
+};
+
+/**
+ * Tokenizes many small strings (e.g. config values, identifiers, log fields) in one call.
+ * 
+ * The tokens of all inputs are written into one shared stream, the tokens of input i are
+ * [offsets[i], offsets[i + 1]) and their starts are relative to the input.
+ * Nothing is allocated or cleared per input: the inputs share one position space of the
+ * failed memo of the cursor, so its window moves on to the next input like in a long text,
+ * and only the rows of the positions that the previous input used are cleared.
+ * The token positions (line, col) are not counted, the stream has `lazy_positions`.
+ */
+struct scanner_batch {
+    struct scanner_cursor *cursor;
+    struct scanner_token_stream *tokens;
+
+    unsigned int *offsets;              // n_inputs + 1 entries
+    unsigned int n_inputs;
+    unsigned int _offsets_capacity;
+
+    unsigned int _position;             // start of the next input in the position space of the cursor
+};
+
+struct scanner_batch *scanner_batch_create(const struct scanner * const scanner);
+void scanner_batch_destroy(struct scanner_batch *batch);
+
+/**
+ * Tokenizes the inputs, the same tokens as `scanner_cursor_scan` on each of them.
+ * The previous results of the batch are overwritten.
+ */
+void scanner_batch_scan(struct scanner_batch * const batch,
+                        const struct scanner_string_view * const inputs,
+                        const unsigned int n_inputs);
+
+static inline const char *scanner_batch_lexeme(const struct scanner_batch * const batch,
+                                               const struct scanner_string_view * const inputs,
+                                               const unsigned int input,
+                                               const unsigned int i) {
+    return inputs[input].data + batch->tokens->start[i];
+}
+
+/**
+ * Skips ahead to the next position of the text from where a token can be recognized.
+ * 
+ * Instead of stepping the DFA byte by byte, the candidate positions are found
+ * with the first-byte set (memchr or vectorized byte-set search, see cutils/byteset.h)
+ * and then verified against the required literal prefix of the tokens.
+ * 
+ * Returns:
+ *  the next candidate position (>= text_i), or `text_n` if there is none
+ */
+unsigned int scanner_skip_ahead(const struct scanner * const scanner,
+                                const char * const text,
+                                const unsigned int text_n,
+                                unsigned int text_i);
+
+#endif // SCANNER_RUNTIME_H
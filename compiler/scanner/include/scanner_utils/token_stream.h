@@ -0,0 +1,143 @@
+#ifndef SCANNER_TOKEN_STREAM_H
+#define SCANNER_TOKEN_STREAM_H
+
+#include <cutils/byteset.h>
+#include <scanner_utils/line_index.h>
+
+/**
+ * Output of the scanner: (token, line, col, lexeme) for every recognized token.
+ *
+ * The tokens are stored as a structure of arrays, so scanning appends to a few
+ * flat arrays and doesn't allocate anything per token. The lexemes are not copied,
+ * they are views (start offset + length) into the source text, which has to outlive the stream.
+ *
+ * Positions:
+ *  - line: starts from 1
+ *  - col:  index of the first character of the token in its line (starts from 0)
+ *  The line and col are packed into a single 64 bit `position` (line in the upper half).
+ *
+ *  Positions are never tracked inside the DFA loop. By default they are calculated when a
+ *  token is pushed, by counting the newlines since the previous token with vectorized compares.
+ *  With `lazy_positions` set, pushing doesn't calculate anything: the first position request
+ *  builds a line index of the source and every position is a binary search in it.
+ */
+struct scanner_token_stream {
+    const char *source;
+    unsigned int source_n;
+    unsigned long long base_offset; // offset of `source` in the whole input (streaming), 0 otherwise
+
+    unsigned int n;              // number of tokens
+    unsigned int _capacity;
+
+    unsigned int *start;         // indexed by token -> offset of the lexeme in `source`
+    unsigned int *length;        // indexed by token -> length of the lexeme
+    unsigned short *token;       // indexed by token -> index of the token category
+    unsigned long long *position; // indexed by token -> packed line and col (not filled with `lazy_positions`)
+
+    unsigned char lazy_positions; // set it before pushing tokens, `scanner_token_stream_reset` keeps it
+
+    // incremental re-scanning (see `scanner_cursor_rescan`): the end of the text that the scanner
+    // examined until the token was recognized, the token (and the ones before it) only depend on text[0..reach)
+    unsigned int *reach;          // indexed by token, non-decreasing (only filled with `track_reach`)
+    unsigned char track_reach;    // set it before scanning, `scanner_token_stream_reset` keeps it
+
+    // newline counting state, positions are calculated in the order of the tokens
+    unsigned int _counted;       // newlines are counted in source[0.._counted)
+    unsigned int _line;          // line at `_counted`
+    unsigned int _line_start;    // offset of the first char of `_line`
+    struct cutils_byteset _newline;
+
+    struct scanner_line_index *_line_index; // built on the first request with `lazy_positions`
+};
+
+#define SCANNER_TOKEN_POSITION(line, col) (((unsigned long long)(line) << 32) | (unsigned int)(col))
+#define SCANNER_TOKEN_LINE(position) ((unsigned int)((position) >> 32))
+#define SCANNER_TOKEN_COL(position) ((unsigned int)(position))
+
+struct scanner_token_stream *scanner_token_stream_create(const char * const source, const unsigned int source_n);
+void scanner_token_stream_destroy(struct scanner_token_stream *stream);
+
+/**
+ * Removes every token and starts over on a (possibly different) source.
+ * The arrays keep their capacity.
+ */
+void scanner_token_stream_reset(struct scanner_token_stream * const stream,
+                                const char * const source,
+                                const unsigned int source_n);
+
+/**
+ * Removes every token, but the positions go on from where they are (the next chunk of a stream).
+ */
+void scanner_token_stream_clear(struct scanner_token_stream * const stream);
+
+/**
+ * Moves the start of the source forward by `shift` chars (the consumed part of a stream buffer).
+ * Has to be called before the chars are dropped: the newlines in front of `shift` are counted first.
+ * The caller sets the new `source` and `source_n` afterwards.
+ * Not supported with `lazy_positions`.
+ */
+void scanner_token_stream_rebase(struct scanner_token_stream * const stream, const unsigned int shift);
+
+/**
+ * The positions of the next tokens are counted from `offset`, which is at `line` and `col`
+ * (a part of the source that is scanned separately, see `scanner_token_stream_append`).
+ */
+void scanner_token_stream_seek(struct scanner_token_stream * const stream,
+                               const unsigned int offset,
+                               const unsigned int line,
+                               const unsigned int col);
+
+/**
+ * Appends the tokens [from, src->n) of `src`, a stream of the same source.
+ * If `src` counted its positions from a `scanner_token_stream_seek`, they are corrected
+ * to the lines and cols of `stream`: only the lines are shifted, except on the first line.
+ */
+void scanner_token_stream_append(struct scanner_token_stream * const stream,
+                                 const struct scanner_token_stream * const src,
+                                 const unsigned int from);
+
+/**
+ * Updates the stream after an edit of its source (see `scanner_cursor_rescan`):
+ * the tokens [from, to) are replaced by the tokens of `src`, a stream on the edited source,
+ * and the tokens after them are moved by `delta` chars.
+ * `src` counts the positions from the start of its first token (`scanner_token_stream_seek`).
+ */
+void scanner_token_stream_splice(struct scanner_token_stream * const stream,
+                                 const unsigned int from,
+                                 const unsigned int to,
+                                 struct scanner_token_stream * const src,
+                                 const long long delta);
+
+/**
+ * Appends a token. The tokens have to be pushed in the order of their start offsets.
+ * The position of the token is calculated here, after the DFA has recognized it.
+ */
+void scanner_token_stream_push(struct scanner_token_stream * const stream,
+                               const unsigned int start,
+                               const unsigned int length,
+                               const unsigned short token);
+
+/**
+ * View of the lexeme of the i-th token (not terminated).
+ */
+static inline const char *scanner_token_stream_lexeme(const struct scanner_token_stream * const stream,
+                                                      const unsigned int i) {
+    return stream->source + stream->start[i];
+}
+
+/**
+ * Packed line and col of the i-th token.
+ */
+unsigned long long scanner_token_stream_position(struct scanner_token_stream * const stream, const unsigned int i);
+
+static inline unsigned int scanner_token_stream_line(struct scanner_token_stream * const stream,
+                                                     const unsigned int i) {
+    return SCANNER_TOKEN_LINE(scanner_token_stream_position(stream, i));
+}
+
+static inline unsigned int scanner_token_stream_col(struct scanner_token_stream * const stream,
+                                                    const unsigned int i) {
+    return SCANNER_TOKEN_COL(scanner_token_stream_position(stream, i));
+}
+
+#endif // SCANNER_TOKEN_STREAM_H
@@ -0,0 +1,243 @@
+#include <scanner_utils/comb.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef UNIT_TESTING
+    #include <cutils/cutils_unittest.h>
+#endif
+
+// the default row of a state is only searched among the last rows to keep the packing fast on big DFAs
+#define _SCANNER_COMB_DEFAULT_CANDIDATES 256
+
+/**
+ * Number of bytes on which the two rows differ.
+ */
+static unsigned int _comb_row_difference(const unsigned short * const row_a, const unsigned short * const row_b) {
+    unsigned int n = 0;
+    for (unsigned int c = 0; c < 256; c++) {
+        n += row_a[c] != row_b[c];
+    }
+    return n;
+}
+
+/**
+ * Number of non-error transitions of the row.
+ */
+static unsigned int _comb_row_size(const unsigned short * const row) {
+    unsigned int n = 0;
+    for (unsigned int c = 0; c < 256; c++) {
+        n += row[c] != SCANNER_DFA_STATE_ERROR;
+    }
+    return n;
+}
+
+// (thread local, because `qsort` doesn't pass a context to the compare function)
+static _Thread_local const unsigned short *_comb_row_n;
+
+static int _comb_compare_rows(const void *a, const void *b) {
+    unsigned short state_a = *(const unsigned short *)a;
+    unsigned short state_b = *(const unsigned short *)b;
+
+    // the biggest rows are placed first, they are the hardest to fit
+    if (_comb_row_n[state_a] != _comb_row_n[state_b]) {
+        return (int)_comb_row_n[state_b] - (int)_comb_row_n[state_a];
+    }
+
+    return (int)state_a - (int)state_b;
+}
+
+struct scanner_comb *scanner_comb_create_from_dfa(const struct scanner_dfa * const dfa) {
+    const unsigned short n = dfa->n_states;
+
+    struct scanner_comb *comb = malloc(sizeof(struct scanner_comb));
+
+    if (comb == NULL) {
+        printf("ERROR: `malloc` failed when creating comb table.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    comb->n_states = n;
+    comb->initial_state = dfa->initial_state;
+    comb->base = calloc(n, sizeof(unsigned int));
+    comb->default_state = malloc(n * sizeof(unsigned short));
+    comb->token = malloc(n * sizeof(unsigned short));
+    memcpy(comb->token, dfa->token, n * sizeof(unsigned short));
+
+    // 1. choosing the default rows
+    unsigned short *row_n = malloc(n * sizeof(unsigned short)); // number of stored entries
+
+    for (unsigned short state = 0; state < n; state++) {
+        const unsigned short *row = dfa->transition + (unsigned int)state * 256;
+
+        comb->default_state[state] = SCANNER_COMB_NO_DEFAULT;
+        row_n[state] = _comb_row_size(row);
+
+        if (state == SCANNER_DFA_STATE_ERROR || row_n[state] == 0) {
+            continue;
+        }
+
+        unsigned short first_candidate = state > _SCANNER_COMB_DEFAULT_CANDIDATES ? state - _SCANNER_COMB_DEFAULT_CANDIDATES : 1;
+
+        for (unsigned short candidate = first_candidate; candidate < state; candidate++) {
+            // default rows are not chained: only states without a default row can be one
+            // (the default row of `candidate` is already final, it comes before `state`)
+            if (comb->default_state[candidate] != SCANNER_COMB_NO_DEFAULT) {
+                continue;
+            }
+
+            unsigned int difference = _comb_row_difference(row, dfa->transition + (unsigned int)candidate * 256);
+
+            if (difference < row_n[state]) {
+                row_n[state] = difference;
+                comb->default_state[state] = candidate;
+            }
+        }
+    }
+
+    // 2. first-fit packing of the rows, biggest first
+    unsigned short *order = malloc(n * sizeof(unsigned short));
+    for (unsigned short state = 0; state < n; state++) {
+        order[state] = state;
+    }
+    _comb_row_n = row_n;
+    qsort(order, n, sizeof(unsigned short), _comb_compare_rows);
+
+    unsigned int capacity = 1024;
+    unsigned short *next = malloc(capacity * sizeof(unsigned short));
+    unsigned short *check = malloc(capacity * sizeof(unsigned short));
+    for (unsigned int i = 0; i < capacity; i++) {
+        check[i] = SCANNER_COMB_FREE;
+    }
+
+    unsigned int max_base = 0;
+    unsigned int lowest_free = 0;   // every entry before it is used
+    unsigned char *stored = malloc(256);
+
+    for (unsigned short i = 0; i < n; i++) {
+        const unsigned short state = order[i];
+        const unsigned short *row = dfa->transition + (unsigned int)state * 256;
+        const unsigned short *default_row = comb->default_state[state] == SCANNER_COMB_NO_DEFAULT ?
+                                            NULL : dfa->transition + (unsigned int)comb->default_state[state] * 256;
+
+        unsigned char first = 0, last = 0;
+        unsigned char any = 0;
+        for (unsigned int c = 0; c < 256; c++) {
+            stored[c] = default_row == NULL ? row[c] != SCANNER_DFA_STATE_ERROR : row[c] != default_row[c];
+            if (stored[c]) {
+                last = c;
+                if (!any) {
+                    first = c;
+                    any = 1;
+                }
+            }
+        }
+
+        // empty rows never match the check array
+        if (!any) {
+            comb->base[state] = 0;
+            continue;
+        }
+
+        // the first stored byte can only go into a free entry: the bases before `lowest_free - first`
+        // are never tried, so the search doesn't start over the filled front for every row
+        unsigned int base = lowest_free > first ? lowest_free - first : 0;
+        while (1) {
+            if (base + last >= capacity) {
+                unsigned int new_capacity = 2 * capacity;
+                while (base + last >= new_capacity) {
+                    new_capacity *= 2;
+                }
+
+                next = realloc(next, new_capacity * sizeof(unsigned short));
+                check = realloc(check, new_capacity * sizeof(unsigned short));
+                for (unsigned int j = capacity; j < new_capacity; j++) {
+                    check[j] = SCANNER_COMB_FREE;
+                }
+                capacity = new_capacity;
+            }
+
+            unsigned char fits = 1;
+            for (unsigned int c = first; c <= last && fits; c++) {
+                fits = !stored[c] || check[base + c] == SCANNER_COMB_FREE;
+            }
+
+            if (fits) {
+                break;
+            }
+            base++;
+        }
+
+        comb->base[state] = base;
+        if (base > max_base) {
+            max_base = base;
+        }
+
+        for (unsigned int c = first; c <= last; c++) {
+            if (stored[c]) {
+                next[base + c] = row[c];
+                check[base + c] = state;
+            }
+        }
+
+        while (lowest_free < capacity && check[lowest_free] != SCANNER_COMB_FREE) {
+            lowest_free++;
+        }
+    }
+
+    // padding: base + byte is always a valid index
+    comb->n_entries = max_base + 256;
+    if (comb->n_entries > capacity) {
+        next = realloc(next, comb->n_entries * sizeof(unsigned short));
+        check = realloc(check, comb->n_entries * sizeof(unsigned short));
+        for (unsigned int j = capacity; j < comb->n_entries; j++) {
+            check[j] = SCANNER_COMB_FREE;
+        }
+    }
+    for (unsigned int j = 0; j < comb->n_entries; j++) {
+        if (check[j] == SCANNER_COMB_FREE) {
+            next[j] = SCANNER_DFA_STATE_ERROR;
+        }
+    }
+
+    comb->next = next;
+    comb->check = check;
+
+    free(row_n);
+    free(order);
+    free(stored);
+
+    return comb;
+}
+
+void scanner_comb_destroy(struct scanner_comb *comb) {
+    if (comb != NULL) {
+        free(comb->base);
+        free(comb->default_state);
+        free(comb->next);
+        free(comb->check);
+        free(comb->token);
+        free(comb);
+    }
+}
+
+unsigned int scanner_comb_size(const struct scanner_comb * const comb) {
+    return comb->n_states * (sizeof(unsigned int) + sizeof(unsigned short)) +
+           comb->n_entries * 2 * sizeof(unsigned short);
+}
+
+unsigned int scanner_dfa_table_size(const struct scanner_dfa * const dfa) {
+    return dfa->n_states * 256 * sizeof(unsigned short);
+}
+
+enum SCANNER_TABLE_LAYOUT scanner_comb_choose_layout(const struct scanner_dfa * const dfa,
+                                                     const struct scanner_comb * const comb) {
+    unsigned int dense_size = scanner_dfa_table_size(dfa);
+
+    if (dense_size > SCANNER_COMB_DENSE_LIMIT && 2 * scanner_comb_size(comb) <= dense_size) {
+        return SCANNER_TABLE_LAYOUT_COMB;
+    }
+
+    return SCANNER_TABLE_LAYOUT_DENSE;
+}
@@ -0,0 +1,388 @@
+#include <scanner_utils/dfa.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef UNIT_TESTING
+    #include <cutils/cutils_unittest.h>
+#endif
+
+struct scanner_dfa *scanner_dfa_create(const unsigned short n_states) {
+    struct scanner_dfa *dfa = malloc(sizeof(struct scanner_dfa));
+
+    if (dfa == NULL) {
+        printf("ERROR: `malloc` failed when creating DFA.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    dfa->n_states = n_states;
+    dfa->initial_state = SCANNER_DFA_STATE_ERROR;
+
+    // error state is 0, so every transition leads to the error state by default
+    dfa->transition = calloc((unsigned int)n_states * 256, sizeof(*dfa->transition));
+    dfa->token = calloc(n_states, sizeof(*dfa->token));
+    dfa->accelerated = calloc(n_states, sizeof(*dfa->accelerated));
+    dfa->self_loop = calloc(n_states, sizeof(*dfa->self_loop));
+
+    if (dfa->transition == NULL || dfa->token == NULL || dfa->accelerated == NULL || dfa->self_loop == NULL) {
+        printf("ERROR: `calloc` failed when creating DFA with %d states.\n", n_states);
+        exit(EXIT_FAILURE);
+    }
+
+    return dfa;
+}
+
+struct scanner_dfa *scanner_dfa_create_from_fa(const struct scanner_fa_128 * const fa, const unsigned short token) {
+    struct scanner_dfa *dfa = scanner_dfa_create(fa->n_states);
+    dfa->initial_state = fa->initial_state;
+
+    for (unsigned short state = 1; state < fa->n_states; state++) {
+        if (scanner_fa_is_accepting(fa, state)) {
+            dfa->token[state] = token;
+        }
+
+        for (unsigned int c = 1; c < 128; c++) {
+            dfa->transition[state * 256 + c] = scanner_dfa_next_state(fa, state, c);
+        }
+    }
+
+    scanner_dfa_find_accelerated(dfa);
+
+    return dfa;
+}
+
+void scanner_dfa_destroy(struct scanner_dfa *dfa) {
+    if (dfa != NULL) {
+        free(dfa->transition);
+        free(dfa->token);
+        free(dfa->accelerated);
+        free(dfa->self_loop);
+        free(dfa);
+    }
+}
+
+void scanner_dfa_set_transition(struct scanner_dfa * const dfa, const unsigned short state, const unsigned char byte, const unsigned short next_state) {
+    if (state == SCANNER_DFA_STATE_ERROR) {
+        printf("WARNING: trying to add transition to the error-state. The attempt didn't have any consequences because you can't add transitions to the error state.\n");
+        return;
+    }
+
+    dfa->transition[state * 256 + byte] = next_state;
+}
+
+unsigned short scanner_dfa_get_transition(const struct scanner_dfa * const dfa, const unsigned short state, const unsigned char byte) {
+    return dfa->transition[state * 256 + byte];
+}
+
+// signatures of the states while refining the partition: (class, class of the next state for every byte)
+// (thread local, because `qsort` doesn't pass a context to the compare function)
+static _Thread_local unsigned short *_minimize_signature;
+
+static int _minimize_compare(const void *a, const void *b) {
+    const unsigned short *sig_a = _minimize_signature + *(const unsigned short *)a * 257;
+    const unsigned short *sig_b = _minimize_signature + *(const unsigned short *)b * 257;
+    int cmp = memcmp(sig_a, sig_b, 257 * sizeof(unsigned short));
+
+    // keeping the original order of the states inside a class
+    if (cmp == 0) {
+        cmp = (int)*(const unsigned short *)a - (int)*(const unsigned short *)b;
+    }
+
+    return cmp;
+}
+
+void scanner_dfa_minimize(struct scanner_dfa * const dfa) {
+    const unsigned short n = dfa->n_states;
+
+    unsigned short *class = malloc(n * sizeof(unsigned short));
+    unsigned short *order = malloc(n * sizeof(unsigned short));
+    unsigned short *signature = malloc((unsigned int)n * 257 * sizeof(unsigned short));
+
+    // initial partition: states are distinguished by the token they recognize
+    // (the error state falls into the class of the non-accepting states)
+    for (unsigned short state = 0; state < n; state++) {
+        class[state] = dfa->token[state];
+    }
+
+    unsigned int n_classes = 0;
+
+    while (1) {
+        for (unsigned short state = 0; state < n; state++) {
+            unsigned short *sig = signature + (unsigned int)state * 257;
+            const unsigned short *row = dfa->transition + (unsigned int)state * 256;
+
+            sig[0] = class[state];
+            for (unsigned int c = 0; c < 256; c++) {
+                sig[c + 1] = class[row[c]];
+            }
+
+            order[state] = state;
+        }
+
+        // states with the same signature stay in the same class
+        _minimize_signature = signature;
+        qsort(order, n, sizeof(unsigned short), _minimize_compare);
+
+        unsigned int n_new_classes = 0;
+        for (unsigned short i = 0; i < n; i++) {
+            if (i > 0 && memcmp(signature + order[i-1] * 257, signature + order[i] * 257, 257 * sizeof(unsigned short)) != 0) {
+                n_new_classes++;
+            }
+            class[order[i]] = n_new_classes;
+        }
+        n_new_classes++;
+
+        if (n_new_classes == n_classes) {
+            break;
+        }
+
+        n_classes = n_new_classes;
+    }
+
+    // renumbering: the class of the error state is the new error state,
+    // the others follow in the order of their first original state
+    unsigned short *new_state = malloc(n_classes * sizeof(unsigned short));
+    unsigned short *representative = malloc(n_classes * sizeof(unsigned short));
+    for (unsigned int i = 0; i < n_classes; i++) {
+        new_state[i] = 0xFFFF;
+    }
+
+    new_state[class[SCANNER_DFA_STATE_ERROR]] = SCANNER_DFA_STATE_ERROR;
+    representative[SCANNER_DFA_STATE_ERROR] = SCANNER_DFA_STATE_ERROR;
+    unsigned short n_states = 1;
+
+    for (unsigned short state = 1; state < n; state++) {
+        if (new_state[class[state]] == 0xFFFF) {
+            new_state[class[state]] = n_states;
+            representative[n_states] = state;
+            n_states++;
+        }
+    }
+
+    struct scanner_dfa *minimal = scanner_dfa_create(n_states);
+    minimal->initial_state = new_state[class[dfa->initial_state]];
+
+    for (unsigned short state = 0; state < n_states; state++) {
+        const unsigned short *row = dfa->transition + (unsigned int)representative[state] * 256;
+
+        minimal->token[state] = dfa->token[representative[state]];
+
+        if (state == SCANNER_DFA_STATE_ERROR) {
+            continue;
+        }
+
+        for (unsigned int c = 0; c < 256; c++) {
+            minimal->transition[(unsigned int)state * 256 + c] = new_state[class[row[c]]];
+        }
+    }
+
+    // the minimal DFA takes the place of the original
+    free(dfa->transition);
+    free(dfa->token);
+    free(dfa->accelerated);
+    free(dfa->self_loop);
+    *dfa = *minimal;
+    free(minimal);
+
+    free(class);
+    free(order);
+    free(signature);
+    free(new_state);
+    free(representative);
+
+    scanner_dfa_find_accelerated(dfa);
+}
+
+void scanner_dfa_find_accelerated(struct scanner_dfa * const dfa) {
+    for (unsigned short state = 0; state < dfa->n_states; state++) {
+        struct cutils_byteset self_loop = cutils_byteset_empty();
+        unsigned short n_self_loop = 0;
+        unsigned short n_transitions = 0;
+
+        const unsigned short *row = dfa->transition + state * 256;
+
+        for (unsigned int c = 0; c < 256; c++) {
+            if (row[c] == SCANNER_DFA_STATE_ERROR) {
+                continue;
+            }
+
+            n_transitions++;
+
+            if (row[c] == state) {
+                self_loop._bitvector[c >> 5] |= 1u << (c & 31);
+                n_self_loop++;
+            }
+        }
+
+        _cutils_byteset_update_ranges(&self_loop);
+
+        dfa->self_loop[state] = self_loop;
+        dfa->accelerated[state] = state != SCANNER_DFA_STATE_ERROR &&
+                                  n_self_loop > 0 &&
+                                  2 * n_self_loop >= n_transitions &&
+                                  self_loop._n_ranges <= CUTILS_BYTESET_MAX_RANGES;
+    }
+}
+
+void scanner_dfa_renumber(struct scanner_dfa * const dfa, const unsigned short * const order) {
+    const unsigned short n = dfa->n_states;
+
+    if (order[0] != SCANNER_DFA_STATE_ERROR) {
+        printf("ERROR: scanner_dfa_renumber -> the error state has to stay state_0. Aborting...\n");
+        exit(EXIT_FAILURE);
+    }
+
+    unsigned short *new_state = malloc(n * sizeof(unsigned short));
+    for (unsigned short i = 0; i < n; i++) {
+        new_state[order[i]] = i;
+    }
+
+    struct scanner_dfa *renumbered = scanner_dfa_create(n);
+    renumbered->initial_state = new_state[dfa->initial_state];
+
+    for (unsigned short state = 1; state < n; state++) {
+        const unsigned short *row = dfa->transition + (unsigned int)order[state] * 256;
+        unsigned short *new_row = renumbered->transition + (unsigned int)state * 256;
+
+        for (unsigned int c = 0; c < 256; c++) {
+            new_row[c] = new_state[row[c]];
+        }
+
+        renumbered->token[state] = dfa->token[order[state]];
+        renumbered->accelerated[state] = dfa->accelerated[order[state]];
+        renumbered->self_loop[state] = dfa->self_loop[order[state]];
+    }
+
+    free(dfa->transition);
+    free(dfa->token);
+    free(dfa->accelerated);
+    free(dfa->self_loop);
+    *dfa = *renumbered;
+    free(renumbered);
+
+    free(new_state);
+}
+
+/**
+ * Fills `order` with the states in breadth-first order from the initial state,
+ * followed by the unreachable states. `order[0]` is always the error state.
+ */
+static void _dfa_bfs_order(const struct scanner_dfa * const dfa, unsigned short * const order) {
+    const unsigned short n = dfa->n_states;
+    unsigned char *visited = calloc(n, sizeof(unsigned char));
+
+    order[0] = SCANNER_DFA_STATE_ERROR;
+    visited[SCANNER_DFA_STATE_ERROR] = 1;
+    unsigned short n_ordered = 1;
+
+    if (!visited[dfa->initial_state]) {
+        order[n_ordered++] = dfa->initial_state;
+        visited[dfa->initial_state] = 1;
+    }
+
+    // the ordered states are the queue
+    for (unsigned short i = 1; i < n_ordered; i++) {
+        const unsigned short *row = dfa->transition + (unsigned int)order[i] * 256;
+
+        for (unsigned int c = 0; c < 256; c++) {
+            if (!visited[row[c]]) {
+                visited[row[c]] = 1;
+                order[n_ordered++] = row[c];
+            }
+        }
+    }
+
+    for (unsigned short state = 1; state < n; state++) {
+        if (!visited[state]) {
+            order[n_ordered++] = state;
+        }
+    }
+
+    free(visited);
+}
+
+void scanner_dfa_renumber_bfs(struct scanner_dfa * const dfa) {
+    unsigned short *order = malloc(dfa->n_states * sizeof(unsigned short));
+
+    _dfa_bfs_order(dfa, order);
+    scanner_dfa_renumber(dfa, order);
+
+    free(order);
+}
+
+void scanner_dfa_profile(const struct scanner_dfa * const dfa,
+                         const char * const corpus,
+                         const unsigned int corpus_n,
+                         unsigned int * const visits) {
+    memset(visits, 0, dfa->n_states * sizeof(unsigned int));
+
+    unsigned int start = 0;
+
+    while (start < corpus_n) {
+        unsigned short state = dfa->initial_state;
+        unsigned int last_accept_end = start;
+
+        visits[state]++;
+
+        for (unsigned int i = start; i < corpus_n; i++) {
+            state = dfa->transition[(unsigned int)state * 256 + (unsigned char)corpus[i]];
+
+            if (state == SCANNER_DFA_STATE_ERROR) {
+                break;
+            }
+
+            visits[state]++;
+
+            if (dfa->token[state] != 0) {
+                last_accept_end = i + 1;
+            }
+        }
+
+        // rollback to the end of the last token, or skip the unrecognized byte
+        start = last_accept_end > start ? last_accept_end : start + 1;
+    }
+}
+
+// (thread local, because `qsort` doesn't pass a context to the compare function)
+static _Thread_local const unsigned int *_profile_visits;
+static _Thread_local const unsigned short *_profile_bfs_rank;
+
+static int _profile_compare(const void *a, const void *b) {
+    unsigned short state_a = *(const unsigned short *)a;
+    unsigned short state_b = *(const unsigned short *)b;
+
+    if (_profile_visits[state_a] != _profile_visits[state_b]) {
+        return _profile_visits[state_a] > _profile_visits[state_b] ? -1 : 1;
+    }
+
+    return (int)_profile_bfs_rank[state_a] - (int)_profile_bfs_rank[state_b];
+}
+
+void scanner_dfa_renumber_profile(struct scanner_dfa * const dfa,
+                                  const char * const corpus,
+                                  const unsigned int corpus_n) {
+    const unsigned short n = dfa->n_states;
+
+    unsigned int *visits = malloc(n * sizeof(unsigned int));
+    unsigned short *order = malloc(n * sizeof(unsigned short));
+    unsigned short *bfs_rank = malloc(n * sizeof(unsigned short));
+
+    scanner_dfa_profile(dfa, corpus, corpus_n, visits);
+
+    _dfa_bfs_order(dfa, order);
+    for (unsigned short i = 0; i < n; i++) {
+        bfs_rank[order[i]] = i;
+    }
+
+    // the error state stays in front
+    _profile_visits = visits;
+    _profile_bfs_rank = bfs_rank;
+    qsort(order + 1, n - 1, sizeof(unsigned short), _profile_compare);
+
+    scanner_dfa_renumber(dfa, order);
+
+    free(visits);
+    free(order);
+    free(bfs_rank);
+}
@@ -0,0 +1,252 @@
+#include <scanner_utils/dfa_cache.h>
+
+#include <dirent.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <utime.h>
+
+#ifdef UNIT_TESTING
+    #include <cutils/cutils_unittest.h>
+#endif
+
+#define _DFA_CACHE_MAGIC 0x41464453u // "SDFA"
+#define _DFA_CACHE_SUFFIX ".dfa"
+
+// set by the build for this file only, the other files don't have to be compiled again when it changes
+#ifndef SCANNER_DFA_CACHE_BUILD
+    #define SCANNER_DFA_CACHE_BUILD 0
+#endif
+
+// numbers the temporary files of the process, the threads of a generator can store the same key
+static atomic_uint _dfa_cache_n_stored = 0;
+
+/**
+ * File header, followed by `transition` (n_states * 256) and `token` (n_states).
+ */
+struct _dfa_cache_header {
+    unsigned int magic;
+    unsigned int version;
+    unsigned long long key;
+    unsigned short n_states;
+    unsigned short initial_state;
+};
+
+// --------------------------------------
+// KEY
+// --------------------------------------
+
+static unsigned long long _dfa_cache_hash(unsigned long long h, const void * const data, const unsigned int n) {
+    const unsigned char *bytes = data;
+
+    // FNV-1a
+    for (unsigned int i = 0; i < n; i++) {
+        h = (h ^ bytes[i]) * 1099511628211ull;
+    }
+
+    return h;
+}
+
+/**
+ * The start of a key: the kind of the key, the file format and the build of the construction.
+ */
+static unsigned long long _dfa_cache_hash_start(const char * const kind) {
+    const unsigned int version = SCANNER_DFA_CACHE_VERSION;
+    const unsigned long long build = SCANNER_DFA_CACHE_BUILD;
+
+    unsigned long long h = _dfa_cache_hash(14695981039346656037ull, kind, strlen(kind));
+    h = _dfa_cache_hash(h, &version, sizeof(version));
+    return _dfa_cache_hash(h, &build, sizeof(build));
+}
+
+unsigned long long scanner_dfa_cache_build() {
+    return SCANNER_DFA_CACHE_BUILD;
+}
+
+unsigned long long scanner_dfa_cache_key(const struct scanner_rules * const rules) {
+    unsigned long long h = _dfa_cache_hash_start("rules");
+
+    // the definitions in order, with a mark of the tokens (the rules are in the same order)
+    unsigned short rule = 0;
+    for (unsigned short i = 0; i < rules->n_definitions; i++) {
+        const struct scanner_regex_definition *definition = rules->definitions[i];
+        const unsigned char is_token = rule < rules->n && rules->rules[rule].definition == definition;
+        rule += is_token;
+
+        // the terminating zeros separate the strings
+        h = _dfa_cache_hash(h, &is_token, 1);
+        h = _dfa_cache_hash(h, definition->name->_s, definition->name->size + 1);
+        h = _dfa_cache_hash(h, definition->regex->_s, definition->regex->size + 1);
+    }
+
+    return h;
+}
+
+/**
+ * The references of the tree, in order.
+ */
+static unsigned long long _dfa_cache_hash_references(unsigned long long h, const struct scanner_regex_tree_node * const node) {
+    if (node->type == SCANNER_REGEX_TREE_NODE_REFERENCE) {
+        const unsigned long long key = scanner_dfa_cache_regex_key(node->definition);
+        return _dfa_cache_hash(h, &key, sizeof(key));
+    }
+
+    for (unsigned short i = 0; i < node->children_n; i++) {
+        h = _dfa_cache_hash_references(h, node->children[i]);
+    }
+
+    return h;
+}
+
+unsigned long long scanner_dfa_cache_regex_key(const struct scanner_regex_definition * const definition) {
+    unsigned long long h = _dfa_cache_hash_start("regex");
+    h = _dfa_cache_hash(h, definition->regex->_s, definition->regex->size + 1);
+
+    return _dfa_cache_hash_references(h, definition->tree);
+}
+
+unsigned long long scanner_dfa_cache_combine_key(const unsigned long long a, const unsigned long long b) {
+    unsigned long long h = _dfa_cache_hash(14695981039346656037ull, "combine", 7);
+    h = _dfa_cache_hash(h, &a, sizeof(a));
+    return _dfa_cache_hash(h, &b, sizeof(b));
+}
+
+// --------------------------------------
+// FILES
+// --------------------------------------
+
+static void _dfa_cache_path(char * const path, const unsigned int path_n,
+                            const char * const directory, const unsigned long long key) {
+    snprintf(path, path_n, "%s/%016llx" _DFA_CACHE_SUFFIX, directory, key);
+}
+
+struct scanner_dfa *scanner_dfa_cache_load(const char * const directory, const unsigned long long key) {
+    char path[strlen(directory) + 32];
+    _dfa_cache_path(path, sizeof(path), directory, key);
+
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        return NULL;
+    }
+
+    struct _dfa_cache_header header;
+    struct scanner_dfa *dfa = NULL;
+
+    if (fread(&header, sizeof(header), 1, file) == 1 &&
+        header.magic == _DFA_CACHE_MAGIC && header.version == SCANNER_DFA_CACHE_VERSION &&
+        header.key == key && header.n_states > 0 && header.initial_state < header.n_states) {
+        dfa = scanner_dfa_create(header.n_states);
+        dfa->initial_state = header.initial_state;
+
+        const unsigned int n_transitions = (unsigned int)header.n_states * 256;
+        unsigned char valid = fread(dfa->transition, sizeof(unsigned short), n_transitions, file) == n_transitions &&
+                              fread(dfa->token, sizeof(unsigned short), header.n_states, file) == header.n_states &&
+                              fgetc(file) == EOF;
+
+        for (unsigned int i = 0; valid && i < n_transitions; i++) {
+            valid = dfa->transition[i] < header.n_states;
+        }
+
+        if (!valid) {
+            scanner_dfa_destroy(dfa);
+            dfa = NULL;
+        }
+    }
+
+    fclose(file);
+
+    if (dfa == NULL) {
+        printf("WARNING: invalid cached DFA `%s`, it is compiled again.\n", path);
+        return NULL;
+    }
+
+    scanner_dfa_find_accelerated(dfa);
+
+    // the hits keep the file from being pruned
+    utime(path, NULL);
+
+    return dfa;
+}
+
+unsigned char scanner_dfa_cache_store(const char * const directory, const unsigned long long key,
+                                      const struct scanner_dfa * const dfa) {
+    if (mkdir(directory, 0777) != 0 && errno != EEXIST) {
+        printf("WARNING: couldn't create the DFA cache `%s`: %s\n", directory, strerror(errno));
+        return 0;
+    }
+
+    char path[strlen(directory) + 32];
+    char temporary_path[strlen(directory) + 64];
+    _dfa_cache_path(path, sizeof(path), directory, key);
+    snprintf(temporary_path, sizeof(temporary_path), "%s.%ld.%u.tmp", path, (long)getpid(),
+             atomic_fetch_add_explicit(&_dfa_cache_n_stored, 1, memory_order_relaxed));
+
+    FILE *file = fopen(temporary_path, "wb");
+    if (file == NULL) {
+        printf("WARNING: couldn't write the DFA cache `%s`: %s\n", temporary_path, strerror(errno));
+        return 0;
+    }
+
+    struct _dfa_cache_header header;
+    memset(&header, 0, sizeof(header));
+    header.magic = _DFA_CACHE_MAGIC;
+    header.version = SCANNER_DFA_CACHE_VERSION;
+    header.key = key;
+    header.n_states = dfa->n_states;
+    header.initial_state = dfa->initial_state;
+
+    const unsigned int n_transitions = (unsigned int)dfa->n_states * 256;
+    unsigned char written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                            fwrite(dfa->transition, sizeof(unsigned short), n_transitions, file) == n_transitions &&
+                            fwrite(dfa->token, sizeof(unsigned short), dfa->n_states, file) == dfa->n_states;
+    written = fclose(file) == 0 && written;
+
+    // the rename is atomic: the readers see the whole file or nothing
+    if (!written || rename(temporary_path, path) != 0) {
+        printf("WARNING: couldn't write the DFA cache `%s`: %s\n", path, strerror(errno));
+        remove(temporary_path);
+        return 0;
+    }
+
+    return 1;
+}
+
+unsigned int scanner_dfa_cache_prune(const char * const directory, const unsigned long long max_age) {
+    DIR *dir = opendir(directory);
+    if (dir == NULL) {
+        return 0;
+    }
+
+    const time_t now = time(NULL);
+    const unsigned int suffix_n = strlen(_DFA_CACHE_SUFFIX);
+    unsigned int n_removed = 0;
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        const char *suffix = strstr(entry->d_name, _DFA_CACHE_SUFFIX);
+
+        // the DFAs and the temporaries of interrupted stores
+        if (suffix == NULL || (suffix[suffix_n] != '\0' && strcmp(suffix + strlen(suffix) - 4, ".tmp") != 0)) {
+            continue;
+        }
+
+        char path[strlen(directory) + strlen(entry->d_name) + 2];
+        snprintf(path, sizeof(path), "%s/%s", directory, entry->d_name);
+
+        struct stat info;
+        if (stat(path, &info) == 0 &&
+            (unsigned long long)(now > info.st_mtime ? now - info.st_mtime : 0) >= max_age &&
+            remove(path) == 0) {
+            n_removed++;
+        }
+    }
+
+    closedir(dir);
+
+    return n_removed;
+}
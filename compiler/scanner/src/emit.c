@@ -0,0 +1,511 @@
+#include <scanner_utils/emit.h>
+
+#include <scanner_utils/comb.h>
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef UNIT_TESTING
+    #include <cutils/cutils_unittest.h>
+#endif
+
+// states with more byte ranges are dispatched with a switch instead of range compares
+#define _EMIT_DIRECT_MAX_RANGES 8
+
+static void _emit_upper(FILE * const out, const char * const name) {
+    for (const char *c = name; *c != '\0'; c++) {
+        fputc(toupper((unsigned char)*c), out);
+    }
+}
+
+static void _emit_char(FILE * const out, const unsigned char c) {
+    if (isprint(c) && c != '\'' && c != '\\') {
+        fprintf(out, "'%c'", c);
+    } else {
+        fprintf(out, "0x%02x", c);
+    }
+}
+
+static void _emit_string(FILE * const out, const char * const s) {
+    fputc('"', out);
+    for (const char *c = s; *c != '\0'; c++) {
+        if (*c == '"' || *c == '\\') {
+            fputc('\\', out);
+        }
+        fputc(*c, out);
+    }
+    fputc('"', out);
+}
+
+void scanner_emit_header(FILE * const out, const char * const name, const struct scanner_rules * const rules) {
+    fprintf(out, "// generated by the scanner generator, do not edit\n\n");
+
+    fprintf(out, "#ifndef ");
+    _emit_upper(out, name);
+    fprintf(out, "_SCANNER_H\n#define ");
+    _emit_upper(out, name);
+    fprintf(out, "_SCANNER_H\n\n");
+
+    fprintf(out, "#define ");
+    _emit_upper(out, name);
+    fprintf(out, "_TOKEN_ERROR 0\n");
+
+    for (unsigned short i = 0; i < rules->n; i++) {
+        fprintf(out, "#define ");
+        _emit_upper(out, name);
+        fprintf(out, "_TOKEN_%s %u\n", rules->rules[i].name->_s, i + 1);
+    }
+
+    fprintf(out, "#define ");
+    _emit_upper(out, name);
+    fprintf(out, "_N_TOKENS %u\n\n", rules->n + 1);
+
+    fprintf(out, "struct %s_token {\n"
+                 "    unsigned int start;\n"
+                 "    unsigned int length;\n"
+                 "    unsigned short token;\n"
+                 "};\n\n", name);
+
+    fprintf(out, "extern const char * const %s_token_names[", name);
+    _emit_upper(out, name);
+    fprintf(out, "_N_TOKENS];\n");
+
+    fprintf(out, "extern const unsigned char %s_token_skip[", name);
+    _emit_upper(out, name);
+    fprintf(out, "_N_TOKENS];\n\n");
+
+    fprintf(out, "/**\n"
+                 " * The longest token that starts at text[text_i], returns the position after it.\n"
+                 " * If no token starts there, the char is an ERROR token of length 1.\n"
+                 " */\n"
+                 "unsigned int %s_next_token(const char *text, unsigned int text_n, unsigned int text_i, unsigned short *token);\n\n",
+            name);
+
+    fprintf(out, "/**\n"
+                 " * Scans the tokens from `*text_i` into `tokens` until the end of the text or `capacity` tokens,\n"
+                 " * the tokens of `skip` definitions are left out. `*text_i` is moved after the last token.\n"
+                 " * Returns the number of tokens.\n"
+                 " */\n"
+                 "unsigned int %s_scan(const char *text, unsigned int text_n, unsigned int *text_i,\n"
+                 "    struct %s_token *tokens, unsigned int capacity);\n\n",
+            name, name);
+
+    fprintf(out, "#endif\n");
+}
+
+// --------------------------------------
+// TABLE BACKEND
+// --------------------------------------
+
+static unsigned int _emit_bits(unsigned int value) {
+    unsigned int bits = 1;
+    while (value >> bits) {
+        bits++;
+    }
+    return bits;
+}
+
+static void _emit_table_next(FILE * const out,
+                             const char * const name,
+                             const struct scanner_rules * const rules,
+                             const struct scanner_dfa * const dfa) {
+    // an entry is the next state in the low bits and its token in the high bits,
+    // the error state is the only entry 0
+    const unsigned int state_bits = _emit_bits(dfa->n_states - 1);
+    const unsigned int entry_bits = state_bits + _emit_bits(rules->n);
+    const char *type = entry_bits <= 8 ? "unsigned char" : entry_bits <= 16 ? "unsigned short" : "unsigned int";
+
+    fprintf(out, "// %u states, an entry is `token << %u | next state`\n", dfa->n_states, state_bits);
+    fprintf(out, "static const _Alignas(64) %s %s_transition[%u] = {", type, name, (unsigned int)dfa->n_states * 256);
+    for (unsigned int i = 0; i < (unsigned int)dfa->n_states * 256; i++) {
+        const unsigned int next_state = dfa->transition[i];
+        fprintf(out, "%s%u,", i % 32 == 0 ? "\n    " : " ", (unsigned int)dfa->token[next_state] << state_bits | next_state);
+    }
+    fprintf(out, "\n};\n\n");
+
+    fprintf(out, "static inline unsigned int _%s_next(const char *text, unsigned int text_n, unsigned int text_i, unsigned short *token) {\n"
+                 "    const unsigned char *s = (const unsigned char *)text;\n"
+                 "    unsigned int entry = %u;\n"
+                 "    unsigned int last_end = text_i;\n"
+                 "    unsigned int last_token = 0;\n"
+                 "\n"
+                 "    // a single load per byte: the next state and whether it accepts\n"
+                 "    for (unsigned int i = text_i; i < text_n;) {\n"
+                 "        entry = %s_transition[(entry & 0x%x) * 256 + s[i++]];\n"
+                 "        if (entry == 0) {\n"
+                 "            break;\n"
+                 "        }\n"
+                 "        if (entry >> %u != 0) {\n"
+                 "            last_token = entry >> %u;\n"
+                 "            last_end = i;\n"
+                 "        }\n"
+                 "    }\n"
+                 "\n"
+                 "    if (last_end == text_i) {\n"
+                 "        *token = 0;\n"
+                 "        return text_i + 1;\n"
+                 "    }\n"
+                 "\n"
+                 "    *token = (unsigned short)last_token;\n"
+                 "    return last_end;\n"
+                 "}\n\n",
+            name, dfa->initial_state, name, (1u << state_bits) - 1, state_bits, state_bits);
+}
+
+/**
+ * `static const` array of the values with the smallest unsigned type that fits `max`.
+ */
+static void _emit_array(FILE * const out, const char * const name, const char * const suffix,
+                        const unsigned int * const values, const unsigned int n, const unsigned int max) {
+    const unsigned int bits = _emit_bits(max);
+    const char *type = bits <= 8 ? "unsigned char" : bits <= 16 ? "unsigned short" : "unsigned int";
+
+    fprintf(out, "static const _Alignas(64) %s %s_%s[%u] = {", type, name, suffix, n);
+    for (unsigned int i = 0; i < n; i++) {
+        fprintf(out, "%s%u,", i % 32 == 0 ? "\n    " : " ", values[i]);
+    }
+    fprintf(out, "\n};\n\n");
+}
+
+/**
+ * The row displacement table of `comb` (see comb.h) with the same entries as the dense table.
+ * The states without a default row have the error state as default, its row is empty,
+ * and the unused entries are checked by `n_states`, so a transition is always two probes at most.
+ */
+static void _emit_comb_next(FILE * const out,
+                            const char * const name,
+                            const struct scanner_rules * const rules,
+                            const struct scanner_comb * const comb) {
+    const unsigned int state_bits = _emit_bits(comb->n_states - 1);
+    const unsigned int n_values = comb->n_entries > comb->n_states ? comb->n_entries : comb->n_states;
+    unsigned int *values = malloc(n_values * sizeof(unsigned int));
+
+    fprintf(out, "// %u states in %u row displacement entries, an entry is `token << %u | next state`\n",
+            comb->n_states, comb->n_entries, state_bits);
+
+    unsigned int max_base = 0;
+    for (unsigned int state = 0; state < comb->n_states; state++) {
+        values[state] = comb->base[state];
+        if (values[state] > max_base) {
+            max_base = values[state];
+        }
+    }
+    _emit_array(out, name, "base", values, comb->n_states, max_base);
+
+    for (unsigned int state = 0; state < comb->n_states; state++) {
+        values[state] = comb->default_state[state] == SCANNER_COMB_NO_DEFAULT ? SCANNER_DFA_STATE_ERROR : comb->default_state[state];
+    }
+    _emit_array(out, name, "default", values, comb->n_states, comb->n_states - 1);
+
+    for (unsigned int i = 0; i < comb->n_entries; i++) {
+        values[i] = (unsigned int)comb->token[comb->next[i]] << state_bits | comb->next[i];
+    }
+    _emit_array(out, name, "next", values, comb->n_entries, (unsigned int)rules->n << state_bits | ((1u << state_bits) - 1));
+
+    for (unsigned int i = 0; i < comb->n_entries; i++) {
+        values[i] = comb->check[i] == SCANNER_COMB_FREE ? comb->n_states : comb->check[i];
+    }
+    _emit_array(out, name, "check", values, comb->n_entries, comb->n_states);
+
+    free(values);
+
+    fprintf(out, "static inline unsigned int _%s_next(const char *text, unsigned int text_n, unsigned int text_i, unsigned short *token) {\n"
+                 "    const unsigned char *s = (const unsigned char *)text;\n"
+                 "    unsigned int state = %u;\n"
+                 "    unsigned int last_end = text_i;\n"
+                 "    unsigned int last_token = 0;\n"
+                 "\n"
+                 "    for (unsigned int i = text_i; i < text_n;) {\n"
+                 "        unsigned int index = %s_base[state] + s[i];\n"
+                 "        if (%s_check[index] != state) {\n"
+                 "            state = %s_default[state];\n"
+                 "            index = %s_base[state] + s[i];\n"
+                 "        }\n"
+                 "        i++;\n"
+                 "\n"
+                 "        const unsigned int entry = %s_check[index] == state ? %s_next[index] : 0;\n"
+                 "        if (entry == 0) {\n"
+                 "            break;\n"
+                 "        }\n"
+                 "        state = entry & 0x%x;\n"
+                 "        if (entry >> %u != 0) {\n"
+                 "            last_token = entry >> %u;\n"
+                 "            last_end = i;\n"
+                 "        }\n"
+                 "    }\n"
+                 "\n"
+                 "    if (last_end == text_i) {\n"
+                 "        *token = 0;\n"
+                 "        return text_i + 1;\n"
+                 "    }\n"
+                 "\n"
+                 "    *token = (unsigned short)last_token;\n"
+                 "    return last_end;\n"
+                 "}\n\n",
+            name, comb->initial_state, name, name, name, name, name, name, (1u << state_bits) - 1, state_bits, state_bits);
+}
+
+// --------------------------------------
+// KEYWORDS
+// --------------------------------------
+
+/**
+ * The perfect hash table of `keywords` (see keywords.h) and `_name_token`: the next token
+ * of the DFA, reclassified as a keyword if its lexeme is in the table.
+ */
+static void _emit_keywords(FILE * const out, const char * const name, const struct scanner_keywords * const keywords) {
+    const unsigned int n_slots = keywords->n_slots;
+    unsigned int *values = malloc((n_slots > keywords->_literals_size ? n_slots : keywords->_literals_size) * sizeof(unsigned int));
+    unsigned int max = 0;
+
+    fprintf(out, "// %u keywords in %u slots, the lexemes of the shadowing tokens are looked up by their hash\n",
+            keywords->n_keywords, n_slots);
+
+    for (unsigned int slot = 0; slot < n_slots; slot++) {
+        values[slot] = keywords->token[slot];
+        max = values[slot] > max ? values[slot] : max;
+    }
+    _emit_array(out, name, "keyword_token", values, n_slots, max);
+
+    max = 0;
+    for (unsigned int slot = 0; slot < n_slots; slot++) {
+        values[slot] = keywords->token[slot] != 0 ? keywords->shadow_token[slot] : 0;
+        max = values[slot] > max ? values[slot] : max;
+    }
+    _emit_array(out, name, "keyword_shadow", values, n_slots, max);
+
+    for (unsigned int slot = 0; slot < n_slots; slot++) {
+        values[slot] = keywords->token[slot] != 0 ? keywords->literal_n[slot] : 0;
+    }
+    _emit_array(out, name, "keyword_n", values, n_slots, keywords->max_n);
+
+    for (unsigned int slot = 0; slot < n_slots; slot++) {
+        values[slot] = keywords->token[slot] != 0 ? keywords->literal_offset[slot] : 0;
+    }
+    _emit_array(out, name, "keyword_offset", values, n_slots, keywords->_literals_size);
+
+    for (unsigned int i = 0; i < keywords->_literals_size; i++) {
+        values[i] = (unsigned char)keywords->literals[i];
+    }
+    _emit_array(out, name, "keyword_literals", values, keywords->_literals_size, 255);
+
+    free(values);
+
+    // the same hash as `_scanner_keywords_hash`
+    fprintf(out, "static inline unsigned int _%s_token(const char *text, unsigned int text_n, unsigned int text_i, unsigned short *token) {\n"
+                 "    const unsigned int end = _%s_next(text, text_n, text_i, token);\n"
+                 "    const unsigned int n = end - text_i;\n"
+                 "    if (n < %u || n > %u) {\n"
+                 "        return end;\n"
+                 "    }\n"
+                 "\n"
+                 "    unsigned int h = 2166136261u ^ %uu;\n"
+                 "    for (unsigned int i = text_i; i < end; i++) {\n"
+                 "        h = (h ^ (unsigned char)text[i]) * 16777619u;\n"
+                 "    }\n"
+                 "    const unsigned int slot = (h ^ (h >> 15)) & %u;\n"
+                 "\n"
+                 "    if (%s_keyword_token[slot] != 0 && %s_keyword_shadow[slot] == *token && %s_keyword_n[slot] == n &&\n"
+                 "        memcmp(%s_keyword_literals + %s_keyword_offset[slot], text + text_i, n) == 0) {\n"
+                 "        *token = %s_keyword_token[slot];\n"
+                 "    }\n"
+                 "\n"
+                 "    return end;\n"
+                 "}\n\n",
+            name, name, keywords->min_n, keywords->max_n, keywords->seed, n_slots - 1, name, name, name, name, name, name);
+}
+
+// --------------------------------------
+// DIRECT BACKEND
+// --------------------------------------
+
+/**
+ * The transitions of `state` to the bytes `c` (already consumed): range compares or a switch,
+ * then the error state.
+ */
+static void _emit_direct_transitions(FILE * const out, const struct scanner_dfa * const dfa, const unsigned short state) {
+    const unsigned short *row = dfa->transition + (unsigned int)state * 256;
+
+    unsigned int n_ranges = 0;
+    for (unsigned int c = 0; c < 256; c++) {
+        if (row[c] != SCANNER_DFA_STATE_ERROR && (c == 0 || row[c - 1] != row[c])) {
+            n_ranges++;
+        }
+    }
+
+    if (n_ranges <= _EMIT_DIRECT_MAX_RANGES) {
+        for (unsigned int c = 0; c < 256;) {
+            unsigned int to = c;
+            while (to + 1 < 256 && row[to + 1] == row[c]) {
+                to++;
+            }
+
+            if (row[c] != SCANNER_DFA_STATE_ERROR) {
+                fprintf(out, "    if (");
+                if (c == to) {
+                    fprintf(out, "c == ");
+                    _emit_char(out, c);
+                } else {
+                    fprintf(out, "c >= ");
+                    _emit_char(out, c);
+                    fprintf(out, " && c <= ");
+                    _emit_char(out, to);
+                }
+                fprintf(out, ") goto s%u;\n", row[c]);
+            }
+
+            c = to + 1;
+        }
+
+        fprintf(out, "    goto done;\n");
+        return;
+    }
+
+    // a case list per next state, in the order of their first byte
+    unsigned char emitted[256] = {0};
+
+    fprintf(out, "    switch (c) {\n");
+    for (unsigned int c = 0; c < 256; c++) {
+        if (row[c] == SCANNER_DFA_STATE_ERROR || emitted[c]) {
+            continue;
+        }
+
+        unsigned int n_cases = 0;
+        for (unsigned int d = c; d < 256; d++) {
+            if (row[d] == row[c]) {
+                fprintf(out, "%s", n_cases % 8 == 0 ? (n_cases == 0 ? "        " : "\n        ") : " ");
+                fprintf(out, "case ");
+                _emit_char(out, d);
+                fprintf(out, ":");
+                emitted[d] = 1;
+                n_cases++;
+            }
+        }
+
+        fprintf(out, "\n            goto s%u;\n", row[c]);
+    }
+    fprintf(out, "        default:\n"
+                 "            goto done;\n"
+                 "    }\n");
+}
+
+static void _emit_direct_next(FILE * const out, const char * const name, const struct scanner_dfa * const dfa) {
+    fprintf(out, "static inline unsigned int _%s_next(const char *text, unsigned int text_n, unsigned int text_i, unsigned short *token) {\n"
+                 "    const unsigned char *s = (const unsigned char *)text;\n"
+                 "    unsigned int i = text_i;\n"
+                 "    unsigned int last_end = text_i;\n"
+                 "    unsigned short last_token = 0;\n"
+                 "    unsigned char c;\n"
+                 "\n"
+                 "    goto s%u;\n\n",
+            name, dfa->initial_state);
+
+    for (unsigned short state = 1; state < dfa->n_states; state++) {
+        fprintf(out, "s%u:\n", state);
+
+        if (dfa->token[state] != 0) {
+            fprintf(out, "    last_token = %u;\n"
+                         "    last_end = i;\n", dfa->token[state]);
+        }
+
+        fprintf(out, "    if (i == text_n) goto done;\n"
+                     "    c = s[i++];\n");
+
+        _emit_direct_transitions(out, dfa, state);
+        fprintf(out, "\n");
+    }
+
+    fprintf(out, "done:\n"
+                 "    if (last_end == text_i) {\n"
+                 "        *token = 0;\n"
+                 "        return text_i + 1;\n"
+                 "    }\n"
+                 "\n"
+                 "    *token = last_token;\n"
+                 "    return last_end;\n"
+                 "}\n\n");
+}
+
+void scanner_emit_source(FILE * const out,
+                         const char * const name,
+                         const char * const header_name,
+                         const struct scanner_rules * const rules,
+                         const struct scanner_dfa * const dfa,
+                         const struct scanner_keywords * const keywords) {
+    fprintf(out, "// generated by the scanner generator (%s backend), do not edit\n\n",
+            rules->backend == SCANNER_BACKEND_DIRECT ? "direct" : rules->backend == SCANNER_BACKEND_COMB ? "comb" : "table");
+    fprintf(out, "#include \"%s\"\n\n", header_name);
+    fprintf(out, "#include <string.h>\n\n");
+
+    fprintf(out, "const char * const %s_token_names[", name);
+    _emit_upper(out, name);
+    fprintf(out, "_N_TOKENS] = {\n    \"ERROR\",\n");
+    for (unsigned short i = 0; i < rules->n; i++) {
+        fprintf(out, "    ");
+        _emit_string(out, rules->rules[i].name->_s);
+        fprintf(out, ",\n");
+    }
+    fprintf(out, "};\n\n");
+
+    fprintf(out, "const unsigned char %s_token_skip[", name);
+    _emit_upper(out, name);
+    fprintf(out, "_N_TOKENS] = {0");
+    for (unsigned short i = 0; i < rules->n; i++) {
+        fprintf(out, ", %u", rules->rules[i].skip);
+    }
+    fprintf(out, "};\n\n");
+
+    if (rules->backend == SCANNER_BACKEND_DIRECT) {
+        _emit_direct_next(out, name, dfa);
+    } else {
+        // the table backend is packed if the dense table is big and sparse
+        struct scanner_comb *comb = scanner_comb_create_from_dfa(dfa);
+
+        if (rules->backend == SCANNER_BACKEND_COMB || scanner_comb_choose_layout(dfa, comb) == SCANNER_TABLE_LAYOUT_COMB) {
+            _emit_comb_next(out, name, rules, comb);
+        } else {
+            _emit_table_next(out, name, rules, dfa);
+        }
+
+        scanner_comb_destroy(comb);
+    }
+
+    if (keywords != NULL && keywords->n_keywords > 0) {
+        _emit_keywords(out, name, keywords);
+    } else {
+        fprintf(out, "static inline unsigned int _%s_token(const char *text, unsigned int text_n, unsigned int text_i, unsigned short *token) {\n"
+                     "    return _%s_next(text, text_n, text_i, token);\n"
+                     "}\n\n",
+                name, name);
+    }
+
+    fprintf(out, "unsigned int %s_next_token(const char *text, unsigned int text_n, unsigned int text_i, unsigned short *token) {\n"
+                 "    return _%s_token(text, text_n, text_i, token);\n"
+                 "}\n\n",
+            name, name);
+
+    fprintf(out, "unsigned int %s_scan(const char *text, unsigned int text_n, unsigned int *text_i,\n"
+                 "    struct %s_token *tokens, unsigned int capacity) {\n"
+                 "    unsigned int i = *text_i;\n"
+                 "    unsigned int n = 0;\n"
+                 "\n"
+                 "    while (i < text_n && n < capacity) {\n"
+                 "        unsigned short token;\n"
+                 "        const unsigned int end = _%s_token(text, text_n, i, &token);\n"
+                 "\n"
+                 "        if (!%s_token_skip[token]) {\n"
+                 "            tokens[n].start = i;\n"
+                 "            tokens[n].length = end - i;\n"
+                 "            tokens[n].token = token;\n"
+                 "            n++;\n"
+                 "        }\n"
+                 "\n"
+                 "        i = end;\n"
+                 "    }\n"
+                 "\n"
+                 "    *text_i = i;\n"
+                 "    return n;\n"
+                 "}\n",
+            name, name, name, name);
+}
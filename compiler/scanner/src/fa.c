@@ -1,5 +1,7 @@
 #include "../include/scanner_utils/fa.h"
+#include "../include/scanner_utils/regex_parser.h"
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
 #include <string.h>
@@ -140,7 +142,8 @@ void scanner_fa_add_transition(struct scanner_fa_128 * const fa, unsigned char s
         return;
     }
 
-    if (scanner_dfa_next_state(fa, state, character) != 0) {
+    // empty transitions are non-deterministic by nature
+    if (character != 0x00 && scanner_dfa_next_state(fa, state, character) != 0) {
         printf("WARNING: adding already existing transition to state `%d` with char `%c`. This finite automaton will behave as an non-deterministic FA from this point.\n", state, character);
     }
 
@@ -284,6 +287,115 @@ struct scanner_fa_128 *scanner_fa_thompson_create_char(unsigned char character)
     return fa;
 }
 
+struct scanner_fa_128 *scanner_fa_copy(const struct scanner_fa_128 * const fa) {
+    // merging into an FA with only the error state keeps the numbering
+    struct scanner_fa_128 *copy = scanner_fa_create();
+    scanner_fa_merge(copy, fa);
+    copy->initial_state = fa->initial_state;
+    return copy;
+}
+
+struct scanner_fa_128 *scanner_fa_thompson_create_set(const struct cutils_set128 characters) {
+    struct scanner_fa_128 *fa = scanner_fa_create();
+    scanner_fa_add_states(fa, 2);
+    scanner_fa_set_accepting(fa, 2, 1);
+    fa->initial_state = 1;
+
+    for (unsigned char c = 1; c < 128; c++) {
+        if (cutils_set128_has_element(characters, c)) {
+            scanner_fa_add_transition(fa, 1, c, 2);
+        }
+    }
+
+    return fa;
+}
+
+static struct cutils_set128 _fa_set128_range(unsigned char from, unsigned char to) {
+    struct cutils_set128 A = cutils_set128_empty();
+    for (unsigned int c = from; c <= to && c < 128; c++) {
+        A = cutils_set128_union(A, cutils_set128_create(c));
+    }
+    return A;
+}
+
+struct scanner_fa_128 *scanner_fa_thompson_from_regex(const struct scanner_regex_tree_node * const root) {
+    struct scanner_fa_128 *fa;
+    struct scanner_fa_128 *operand;
+
+    switch (root->type) {
+        case SCANNER_REGEX_TREE_NODE_LITERAL:
+            fa = scanner_fa_thompson_create_char(root->literal);
+            break;
+
+        case SCANNER_REGEX_TREE_NODE_RANGE:
+            fa = scanner_fa_thompson_create_set(_fa_set128_range(root->children[0]->literal, root->children[1]->literal));
+            break;
+
+        case SCANNER_REGEX_TREE_NODE_WILDCARD:
+            fa = scanner_fa_thompson_create_set(_fa_set128_range(1, 127));
+            break;
+
+        case SCANNER_REGEX_TREE_NODE_ANYWHITE: {
+            const char whitespaces[] = {' ', '\t', '\r', '\n'};
+            fa = scanner_fa_thompson_create_set(cutils_set128_create_fromlist(whitespaces, 4));
+            break;
+        }
+
+        case SCANNER_REGEX_TREE_NODE_EMPTYLIT:
+            // the empty transition is a transition on the NUL character
+            fa = scanner_fa_thompson_create_char(0x00);
+            break;
+
+        case SCANNER_REGEX_TREE_NODE_REFERENCE:
+            fa = scanner_fa_copy(root->definition->nfa);
+            break;
+
+        case SCANNER_REGEX_TREE_NODE_CONC:
+        case SCANNER_REGEX_TREE_NODE_ALT:
+            fa = scanner_fa_thompson_from_regex(root->children[0]);
+
+            for (unsigned short i = 1; i < root->children_n; i++) {
+                operand = scanner_fa_thompson_from_regex(root->children[i]);
+
+                if (root->type == SCANNER_REGEX_TREE_NODE_CONC) {
+                    scanner_fa_thompson_concat(fa, operand);
+                } else {
+                    scanner_fa_thompson_alter(fa, operand);
+                }
+
+                scanner_fa_destroy(operand);
+            }
+            break;
+
+        case SCANNER_REGEX_TREE_NODE_CLOS:
+            fa = scanner_fa_thompson_from_regex(root->children[0]);
+
+            // a+ == aa*
+            if (root->literal == '+') {
+                operand = scanner_fa_thompson_from_regex(root->children[0]);
+                scanner_fa_thompson_close(operand);
+                scanner_fa_thompson_concat(fa, operand);
+                scanner_fa_destroy(operand);
+            }
+            // a? == (a|\e)
+            else if (root->literal == '?') {
+                operand = scanner_fa_thompson_create_char(0x00);
+                scanner_fa_thompson_alter(fa, operand);
+                scanner_fa_destroy(operand);
+            }
+            else {
+                scanner_fa_thompson_close(fa);
+            }
+            break;
+
+        default:
+            printf("ERROR: scanner_fa_thompson_from_regex -> unknown regex tree node type: %d\n", root->type);
+            exit(EXIT_FAILURE);
+    }
+
+    return fa;
+}
+
 void scanner_fa_merge(struct scanner_fa_128 * const fa0, const struct scanner_fa_128 * const fa1) {
     if (fa0->n_states + fa1->n_states - 1 > 128) {
         printf("ERROR: scanner_fa_merge -> resulting FA is too big. Aborting...\n");
@@ -395,20 +507,127 @@ void scanner_fa_thompson_close(struct scanner_fa_128 * const fa) {
     scanner_fa_add_transition(fa, fa_end, 0x00, fa->n_states - 1);
 }
 
-void scanner_fa_nfa_to_dfa(struct scanner_fa_128 * const nfa) {
+struct cutils_set128 scanner_fa_nfa_eclosure(const struct scanner_fa_128 * const nfa, struct cutils_set128 input_states) {
+    // computes epsilon closure around the `input_states`
+    // epsilon closure includes the `input_states`
+    struct cutils_set128 closure = input_states;
+    struct cutils_set128 worklist = input_states;
+
+    while (!cutils_set128_isempty(worklist)) {
+        char state = cutils_set128_smallest(worklist);
+        worklist = cutils_set128_difference(worklist, cutils_set128_create(state));
+
+        if (nfa->transition[(int)state] == NULL) {
+            continue;
+        }
+
+        struct _scanner_fa_transition *end = _fa_find_closest_right_ptr(nfa, state);
+
+        for (struct _scanner_fa_transition *i_ptr = nfa->transition[(int)state]; i_ptr != end; i_ptr++) {
+            if (i_ptr->c == 0x00 && !cutils_set128_has_element(closure, i_ptr->next_state)) {
+                closure = cutils_set128_union(closure, cutils_set128_create(i_ptr->next_state));
+                worklist = cutils_set128_union(worklist, cutils_set128_create(i_ptr->next_state));
+            }
+        }
+    }
+
+    return closure;
+}
+
+static unsigned char _fa_set128_equal(const struct cutils_set128 A, const struct cutils_set128 B) {
+    return A._bitvector[0] == B._bitvector[0] && A._bitvector[1] == B._bitvector[1] &&
+           A._bitvector[2] == B._bitvector[2] && A._bitvector[3] == B._bitvector[3];
+}
+
+void scanner_fa_nfa_to_dfa_subsets(struct scanner_fa_128 * const nfa, struct cutils_set128 ** const dfa_subsets) {
     // q_i -> bit-vector of currently selected states
     // Q -> list of q_i's (list of bit-vectors)
     // alongside `nfa`, build a new FA called `DFA`
+    //
+    // The i-th element of Q is the (i+1)-th state of the DFA, state_0 stays the error state.
 
     struct scanner_fa_128 *dfa = scanner_fa_create();
 
     // reserve 16 sets at first. Double the size of the array when we reach that number
     unsigned int Q_capacity = 16;
-    struct cutils_set128 *Q = malloc(sizeof(struct cutils_set128) * 16);
-}
+    unsigned int Q_n = 0;
+    struct cutils_set128 *Q = malloc(sizeof(struct cutils_set128) * Q_capacity);
 
+    Q[Q_n++] = scanner_fa_nfa_eclosure(nfa, cutils_set128_create(nfa->initial_state));
+    scanner_fa_add_states(dfa, 1);
+    dfa->initial_state = 1;
 
-struct cutils_set128 scanner_fa_nfa_eclosure(struct scanner_fa_128 *nfa, struct cutils_set128 input_states) {
-    // computes epsilon closure around the `input_states`
-    // epsilon closure includes the `input_states`
-}
\ No newline at end of file
+    // states reachable from q_i by every character (delta(q_i, c) before the closure)
+    struct cutils_set128 move[128];
+
+    // the worklist is the part of Q that wasn't processed yet
+    for (unsigned int i = 0; i < Q_n; i++) {
+        for (unsigned int c = 0; c < 128; c++) {
+            move[c] = cutils_set128_empty();
+        }
+
+        // going through the transitions of every state of q_i only once
+        for (unsigned int state = 1; state < nfa->n_states; state++) {
+            if (!cutils_set128_has_element(Q[i], state) || nfa->transition[state] == NULL) {
+                continue;
+            }
+
+            struct _scanner_fa_transition *end = _fa_find_closest_right_ptr(nfa, state);
+
+            for (struct _scanner_fa_transition *i_ptr = nfa->transition[state]; i_ptr != end; i_ptr++) {
+                if (i_ptr->c > 0x00) {
+                    move[(int)i_ptr->c] = cutils_set128_union(move[(int)i_ptr->c], cutils_set128_create(i_ptr->next_state));
+                }
+            }
+        }
+
+        for (unsigned int c = 1; c < 128; c++) {
+            if (cutils_set128_isempty(move[c])) {
+                continue;
+            }
+
+            struct cutils_set128 t = scanner_fa_nfa_eclosure(nfa, move[c]);
+
+            unsigned int j;
+            for (j = 0; j < Q_n && !_fa_set128_equal(Q[j], t); j++);
+
+            // new DFA state
+            if (j == Q_n) {
+                if (Q_n + 1 >= 128) {
+                    printf("ERROR: scanner_fa_nfa_to_dfa -> resulting DFA is too big. Aborting...\n");
+                    exit(EXIT_FAILURE);
+                }
+
+                if (Q_n == Q_capacity) {
+                    Q_capacity *= 2;
+                    Q = realloc(Q, sizeof(struct cutils_set128) * Q_capacity);
+                }
+
+                Q[Q_n++] = t;
+                scanner_fa_add_states(dfa, 1);
+            }
+
+            scanner_fa_add_transition(dfa, i + 1, c, j + 1);
+        }
+
+        if (!cutils_set128_isempty(cutils_set128_intersection(Q[i], nfa->accepting))) {
+            scanner_fa_set_accepting(dfa, i + 1, 1);
+        }
+    }
+
+    // the DFA takes the place of the NFA
+    free(nfa->transition[0]);
+    free(nfa->transition);
+    *nfa = *dfa;
+    free(dfa);
+
+    if (dfa_subsets != NULL) {
+        *dfa_subsets = Q;
+    } else {
+        free(Q);
+    }
+}
+
+void scanner_fa_nfa_to_dfa(struct scanner_fa_128 * const nfa) {
+    scanner_fa_nfa_to_dfa_subsets(nfa, NULL);
+}
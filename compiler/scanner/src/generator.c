@@ -1,24 +1,181 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 
+#include <scanner_utils/comb.h>
+#include <scanner_utils/dfa.h>
+#include <scanner_utils/dfa_cache.h>
+#include <scanner_utils/emit.h>
+#include <scanner_utils/lang.h>
 #include <scanner_utils/regex_parser.h>
+#include <scanner_utils/regex_prefix.h>
+#include <scanner_utils/rules.h>
 
 #ifdef UNIT_TESTING
     #include <cutils/cutils_unittest.h>
 #endif
 
-// What do we need to generate?
-//  - FA states: #define FA_STATE_INITIAL 0; etc...
-//    - list of accepting states: BOOL is_accepting_state[NUM_OF_STATES];
-//  - transition table: short transition_table[NUM_OF_STATES][256];
-//    - with the columns for the ASCII characters
-//  - array to match token name indexes with states
-//    - unsigned int classify_lexeme[NUM_OF_STATES] -> returns index for the token names array;
-//  - tokens list with names
-//    - this is the easiest I guess
+// What is generated (emit.h)?
+//  - the header: #define NAME_TOKEN_X i for every rule, the token names and skip flags,
+//    and the declarations of name_next_token and name_scan
+//  - the DFA of the rules, one of:
+//    - a dense transition table: NUM_OF_STATES * 256 entries of `token << bits | next state`
+//    - the same table row displacement packed (comb.h): base, default, next and check arrays
+//    - direct-coded states with gotos, one block of code per state
+//  - the keyword table (keywords.h): the keywords are reclassified after the DFA
+//    instead of being spelled out in it, with a perfect hash of their literals
+//
+// `generator file.lang name output` emits a C scanner (emit.h): the DFA as a transition table,
+// or as direct-coded states with gotos (`%backend direct` in the .lang file).
+// The table is row displacement packed (comb.h) if `scanner_comb_choose_layout` picks it,
+// or always with `%backend comb`.
+//
+// `--cache dir` (before the file) loads the DFA from the on-disk cache (dfa_cache.h) if the rules
+// didn't change, and stores it otherwise. If some rules changed, only their DFAs and the
+// combinations above them are compiled again (see `scanner_rules_compile`). `generator --prune-cache dir days` removes the cached
+// DFAs that weren't used for `days` days (all of them with 0).
+//
+// `--threads n` (before the file) compiles the rule DFAs and their combinations on n threads,
+// one per online core by default. The scanner is the same with any number of threads.
 
 
+/**
+ * Compiles the token definitions of a .lang file and prints the size of the tables.
+ */
+static int generate(const char * const lang_path) {
+    struct scanner_rules *rules = scanner_lang_load(lang_path);
+
+    if (rules == NULL) {
+        return 1;
+    }
+
+    struct scanner_keywords *keywords;
+    struct scanner_dfa *dfa = scanner_rules_compile(rules, &keywords);
+    struct scanner_comb *comb = scanner_comb_create_from_dfa(dfa);
+
+    printf("%s: %d tokens, %d DFA states, %d keywords\n", lang_path, rules->n, dfa->n_states,
+           keywords != NULL ? keywords->n_keywords : 0);
+    printf("transition table: %s (dense: %u bytes, comb: %u bytes)\n",
+           scanner_comb_choose_layout(dfa, comb) == SCANNER_TABLE_LAYOUT_COMB ? "comb" : "dense",
+           scanner_dfa_table_size(dfa), scanner_comb_size(comb));
+
+    scanner_comb_destroy(comb);
+    scanner_keywords_destroy(keywords);
+    scanner_dfa_destroy(dfa);
+    scanner_rules_destroy(rules);
+
+    return 0;
+}
+
+/**
+ * Compiles the token definitions of a .lang file into a C scanner: `output.h` and `output.c`
+ * (see emit.h). `backend` overrides the `%backend` option of the file (NULL to keep it).
+ * The DFA goes through the cache directory `cache` (NULL without cache), it is compiled on `n_threads` threads.
+ */
+static int emit(const char * const lang_path, const char * const name, const char * const output,
+                const char * const backend, const char * const cache, const unsigned int n_threads) {
+    struct scanner_rules *rules = scanner_lang_load(lang_path);
+
+    if (rules == NULL) {
+        return 1;
+    }
+
+    rules->n_threads = n_threads;
+
+    if (backend != NULL) {
+        if (strcmp(backend, "table") == 0) {
+            rules->backend = SCANNER_BACKEND_TABLE;
+        } else if (strcmp(backend, "direct") == 0) {
+            rules->backend = SCANNER_BACKEND_DIRECT;
+        } else if (strcmp(backend, "comb") == 0) {
+            rules->backend = SCANNER_BACKEND_COMB;
+        } else {
+            printf("ERROR: the backend has to be `table`, `direct` or `comb`.\n");
+            scanner_rules_destroy(rules);
+            return 1;
+        }
+    }
+
+    // the shadowed keywords are left out of the DFA and emitted as a keyword table,
+    // the DFAs of the rules and their combinations go through the cache (see `scanner_rules_compile`)
+    rules->dfa_cache = cache;
+
+    struct scanner_keywords *keywords;
+    struct scanner_dfa *dfa = scanner_rules_compile(rules, &keywords);
+
+    const unsigned int output_n = strlen(output);
+    char header_path[output_n + 3];
+    char source_path[output_n + 3];
+    snprintf(header_path, sizeof(header_path), "%s.h", output);
+    snprintf(source_path, sizeof(source_path), "%s.c", output);
+
+    // the source includes the header from its own directory
+    const char *header_name = strrchr(header_path, '/');
+    header_name = header_name != NULL ? header_name + 1 : header_path;
+
+    FILE *header = fopen(header_path, "w");
+    FILE *source = fopen(source_path, "w");
+    int status = 0;
+
+    if (header == NULL || source == NULL) {
+        printf("ERROR: couldn't write the scanner `%s`.\n", output);
+        status = 1;
+    } else {
+        scanner_emit_header(header, name, rules);
+        scanner_emit_source(source, name, header_name, rules, dfa, keywords);
+    }
+
+    if (header != NULL) {
+        fclose(header);
+    }
+    if (source != NULL) {
+        fclose(source);
+    }
+
+    scanner_keywords_destroy(keywords);
+    scanner_dfa_destroy(dfa);
+    scanner_rules_destroy(rules);
+
+    return status;
+}
+
 // for testing
-int main(void) {
+int main(int argc, char **argv) {
+    if (argc == 2) {
+        return generate(argv[1]);
+    }
+
+    // generator --prune-cache dir days
+    if (argc == 4 && strcmp(argv[1], "--prune-cache") == 0) {
+        const unsigned int n_removed = scanner_dfa_cache_prune(argv[2], strtoull(argv[3], NULL, 10) * 24 * 60 * 60);
+        printf("%u cached DFAs removed from %s\n", n_removed, argv[2]);
+        return 0;
+    }
+
+    // generator [--cache dir] [--threads n] file.lang name output [table|direct|comb]
+    const char *cache = NULL;
+    const long n_cores = sysconf(_SC_NPROCESSORS_ONLN);
+    unsigned int n_threads = n_cores > 0 ? (unsigned int)n_cores : 1;
+
+    while (argc > 2 && strncmp(argv[1], "--", 2) == 0) {
+        if (strcmp(argv[1], "--cache") == 0) {
+            cache = argv[2];
+        } else if (strcmp(argv[1], "--threads") == 0 && atoi(argv[2]) > 0) {
+            n_threads = (unsigned int)atoi(argv[2]);
+        } else {
+            printf("ERROR: unknown option `%s %s`.\n", argv[1], argv[2]);
+            return 1;
+        }
+
+        argc -= 2;
+        argv += 2;
+    }
+
+    if (argc == 4 || argc == 5) {
+        return emit(argv[1], argv[2], argv[3], argc == 5 ? argv[4] : NULL, cache, n_threads);
+    }
+
     // REGEX TO BE TESTED
     //struct cutils_string *rgx = cutils_string_create_from("(ab|b)*");
     //const char *test_rgx = "(a|ab)*";
@@ -34,6 +191,27 @@ int main(void) {
         printf("\t%s\n", status.error_msg);
     } else {
         scanner_regex_tree_print(root);
+
+        struct scanner_regex_prefix prefix;
+        scanner_regex_prefix_analyze(root, &prefix);
+        printf("required prefix: \"%.*s\", first bytes: %d\n", prefix.literal_n, prefix.literal,
+               cutils_byteset_size(prefix.first_bytes));
+
+        // regex -> NFA -> DFA -> minimal DFA
+        struct scanner_fa_128 *fa = scanner_fa_thompson_from_regex(root);
+        scanner_fa_nfa_to_dfa(fa);
+        struct scanner_dfa *dfa = scanner_dfa_create_from_fa(fa, 1);
+        scanner_dfa_minimize(dfa);
+
+        printf("DFA states: %d (subset construction: %d)\n", dfa->n_states, fa->n_states);
+        for (unsigned short state = 0; state < dfa->n_states; state++) {
+            if (dfa->accelerated[state]) {
+                printf("\taccelerated state %d: %d self-loop bytes\n", state, cutils_byteset_size(dfa->self_loop[state]));
+            }
+        }
+
+        scanner_dfa_destroy(dfa);
+        scanner_fa_destroy(fa);
     }
 
 
@@ -44,5 +222,36 @@ int main(void) {
     }
     // ~ deconstruct
 
+    // RULE SET: the mnemonics are shadowed by the identifier rule
+    struct scanner_rules *rules = scanner_rules_create();
+    scanner_rules_add(rules, "REGISTER", "r[0-9]+");
+    scanner_rules_add(rules, "MOV", "mov");
+    scanner_rules_add(rules, "ADD", "add");
+    scanner_rules_add(rules, "SUB", "sub");
+    scanner_rules_add(rules, "BX", "bx");
+    scanner_rules_add(rules, "IDENTIFIER", "([a-z]|[A-Z])([a-z]|[A-Z]|[0-9])*");
+
+    struct scanner_dfa *full_dfa = scanner_rules_compile(rules, NULL);
+
+    struct scanner_keywords *keywords;
+    struct scanner_dfa *dfa = scanner_rules_compile(rules, &keywords);
+
+    printf("rule set DFA states: %d (keywords in the DFA: %d)\n", dfa->n_states, full_dfa->n_states);
+    if (keywords != NULL) {
+        printf("keyword table: %d keywords in %d slots (seed: %u)\n",
+               keywords->n_keywords, keywords->n_slots, keywords->seed);
+    }
+
+    struct scanner_comb *comb = scanner_comb_create_from_dfa(dfa);
+    printf("transition table: %s (dense: %u bytes, comb: %u bytes)\n",
+           scanner_comb_choose_layout(dfa, comb) == SCANNER_TABLE_LAYOUT_COMB ? "comb" : "dense",
+           scanner_dfa_table_size(dfa), scanner_comb_size(comb));
+
+    scanner_comb_destroy(comb);
+    scanner_keywords_destroy(keywords);
+    scanner_dfa_destroy(dfa);
+    scanner_dfa_destroy(full_dfa);
+    scanner_rules_destroy(rules);
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,190 @@
+#include <scanner_utils/keywords.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef UNIT_TESTING
+    #include <cutils/cutils_unittest.h>
+#endif
+
+#define _SCANNER_KEYWORDS_MAX_SEEDS 4096
+
+struct scanner_keywords *scanner_keywords_create() {
+    struct scanner_keywords *keywords = malloc(sizeof(struct scanner_keywords));
+
+    keywords->seed = 0;
+    keywords->n_slots = 0;
+    keywords->n_keywords = 0;
+    keywords->token = NULL;
+    keywords->shadow_token = NULL;
+    keywords->literal_offset = NULL;
+    keywords->literal_n = NULL;
+    keywords->min_n = 0xFF;
+    keywords->max_n = 0;
+    keywords->literals = NULL;
+    keywords->_literals_size = 0;
+
+    return keywords;
+}
+
+void scanner_keywords_destroy(struct scanner_keywords *keywords) {
+    if (keywords != NULL) {
+        free(keywords->token);
+        free(keywords->shadow_token);
+        free(keywords->literal_offset);
+        free(keywords->literal_n);
+        free(keywords->literals);
+        free(keywords);
+    }
+}
+
+static void _keywords_realloc_slots(struct scanner_keywords * const keywords, const unsigned int n_slots) {
+    keywords->token = realloc(keywords->token, n_slots * sizeof(*keywords->token));
+    keywords->shadow_token = realloc(keywords->shadow_token, n_slots * sizeof(*keywords->shadow_token));
+    keywords->literal_offset = realloc(keywords->literal_offset, n_slots * sizeof(*keywords->literal_offset));
+    keywords->literal_n = realloc(keywords->literal_n, n_slots * sizeof(*keywords->literal_n));
+
+    if (keywords->token == NULL || keywords->shadow_token == NULL ||
+        keywords->literal_offset == NULL || keywords->literal_n == NULL) {
+        printf("ERROR: `realloc` failed when growing the keyword table.\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+void scanner_keywords_add(struct scanner_keywords * const keywords,
+                          const char * const literal,
+                          const unsigned char literal_n,
+                          const unsigned short token,
+                          const unsigned short shadow_token) {
+    unsigned short i = keywords->n_keywords;
+
+    // until the table is built, the keywords are stored as a list in the first `n_keywords` slots
+    _keywords_realloc_slots(keywords, i + 1);
+
+    keywords->literals = realloc(keywords->literals, keywords->_literals_size + literal_n);
+    memcpy(keywords->literals + keywords->_literals_size, literal, literal_n);
+
+    keywords->token[i] = token;
+    keywords->shadow_token[i] = shadow_token;
+    keywords->literal_offset[i] = keywords->_literals_size;
+    keywords->literal_n[i] = literal_n;
+
+    keywords->_literals_size += literal_n;
+    keywords->n_keywords++;
+    keywords->n_slots = keywords->n_keywords;
+
+    if (literal_n < keywords->min_n) {
+        keywords->min_n = literal_n;
+    }
+    if (literal_n > keywords->max_n) {
+        keywords->max_n = literal_n;
+    }
+}
+
+unsigned int _scanner_keywords_hash(const unsigned int seed, const char * const s, const unsigned int n) {
+    unsigned int h = 2166136261u ^ seed;
+
+    for (unsigned int i = 0; i < n; i++) {
+        h = (h ^ (unsigned char)s[i]) * 16777619u;
+    }
+
+    return h ^ (h >> 15);
+}
+
+void scanner_keywords_build(struct scanner_keywords * const keywords) {
+    const unsigned short n = keywords->n_keywords;
+
+    if (n == 0) {
+        return;
+    }
+
+    // copy of the keyword list
+    unsigned short *token = malloc(n * sizeof(unsigned short));
+    unsigned short *shadow_token = malloc(n * sizeof(unsigned short));
+    unsigned int *literal_offset = malloc(n * sizeof(unsigned int));
+    unsigned char *literal_n = malloc(n * sizeof(unsigned char));
+
+    memcpy(token, keywords->token, n * sizeof(unsigned short));
+    memcpy(shadow_token, keywords->shadow_token, n * sizeof(unsigned short));
+    memcpy(literal_offset, keywords->literal_offset, n * sizeof(unsigned int));
+    memcpy(literal_n, keywords->literal_n, n * sizeof(unsigned char));
+
+    // equal keywords would collide with every seed
+    for (unsigned short i = 0; i < n; i++) {
+        for (unsigned short j = 0; j < i; j++) {
+            if (literal_n[i] == literal_n[j] &&
+                memcmp(keywords->literals + literal_offset[i], keywords->literals + literal_offset[j], literal_n[i]) == 0) {
+                printf("ERROR: the keyword `%.*s` is added twice.\n", literal_n[i], keywords->literals + literal_offset[i]);
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+
+    // load factor at most 1/2 at first, the table doubles if no seed was found
+    unsigned int n_slots = 2;
+    while (n_slots < 2 * n) {
+        n_slots *= 2;
+    }
+
+    unsigned char found = 0;
+
+    while (!found) {
+        _keywords_realloc_slots(keywords, n_slots);
+
+        for (unsigned int seed = 0; seed < _SCANNER_KEYWORDS_MAX_SEEDS && !found; seed++) {
+            memset(keywords->token, 0, n_slots * sizeof(*keywords->token));
+            found = 1;
+
+            for (unsigned short i = 0; i < n && found; i++) {
+                unsigned int slot = _scanner_keywords_hash(seed, keywords->literals + literal_offset[i], literal_n[i]) & (n_slots - 1);
+
+                if (keywords->token[slot] != 0) {
+                    found = 0;
+                    break;
+                }
+
+                keywords->token[slot] = token[i];
+                keywords->shadow_token[slot] = shadow_token[i];
+                keywords->literal_offset[slot] = literal_offset[i];
+                keywords->literal_n[slot] = literal_n[i];
+            }
+
+            if (found) {
+                keywords->seed = seed;
+            }
+        }
+
+        if (!found) {
+            n_slots *= 2;
+        }
+    }
+
+    keywords->n_slots = n_slots;
+
+    free(token);
+    free(shadow_token);
+    free(literal_offset);
+    free(literal_n);
+}
+
+unsigned short scanner_keywords_classify(const struct scanner_keywords * const keywords,
+                                         const unsigned short token,
+                                         const char * const lexeme,
+                                         const unsigned int lexeme_n) {
+    if (keywords == NULL || keywords->n_keywords == 0 ||
+        lexeme_n < keywords->min_n || lexeme_n > keywords->max_n) {
+        return token;
+    }
+
+    unsigned int slot = _scanner_keywords_hash(keywords->seed, lexeme, lexeme_n) & (keywords->n_slots - 1);
+
+    if (keywords->token[slot] != 0 &&
+        keywords->shadow_token[slot] == token &&
+        keywords->literal_n[slot] == lexeme_n &&
+        memcmp(keywords->literals + keywords->literal_offset[slot], lexeme, lexeme_n) == 0) {
+        return keywords->token[slot];
+    }
+
+    return token;
+}
@@ -0,0 +1,209 @@
+#include <scanner_utils/lang.h>
+
+#include <cutils/mapped_file.h>
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef UNIT_TESTING
+    #include <cutils/cutils_unittest.h>
+#endif
+
+static inline unsigned char _lang_is_space(const char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline unsigned char _lang_is_word(const char *begin, const char * const end, const char * const word) {
+    return (unsigned int)(end - begin) == strlen(word) && memcmp(begin, word, end - begin) == 0;
+}
+
+static unsigned char _lang_is_identifier(const char *begin, const char * const end) {
+    if (begin == end || (*begin >= '0' && *begin <= '9')) {
+        return 0;
+    }
+
+    for (; begin < end; begin++) {
+        if (!isalnum((unsigned char)*begin) && *begin != '_') {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * If the name [*begin, end) starts with `word` and whitespace (e.g. `skip NAME`),
+ * `*begin` is moved to the rest of the name and it returns 1.
+ */
+static unsigned char _lang_parse_modifier(const char ** const begin, const char * const end, const char * const word) {
+    const unsigned int n = strlen(word);
+
+    if ((unsigned int)(end - *begin) <= n + 1 || memcmp(*begin, word, n) != 0 || !_lang_is_space((*begin)[n])) {
+        return 0;
+    }
+
+    *begin += n + 1;
+    while (_lang_is_space(**begin)) {
+        (*begin)++;
+    }
+
+    return 1;
+}
+
+/**
+ * Parses the option of a `%name value` line (without the `%`). Returns 0 if the option is invalid.
+ */
+static unsigned char _lang_parse_option(struct scanner_rules * const rules,
+                                        const char *begin, const char * const end) {
+    const char *name_end = begin;
+    while (name_end < end && !_lang_is_space(*name_end)) {
+        name_end++;
+    }
+
+    const char *value = name_end;
+    while (value < end && _lang_is_space(*value)) {
+        value++;
+    }
+
+    if (_lang_is_word(begin, name_end, "backend")) {
+        if (_lang_is_word(value, end, "table")) {
+            rules->backend = SCANNER_BACKEND_TABLE;
+            return 1;
+        }
+        if (_lang_is_word(value, end, "direct")) {
+            rules->backend = SCANNER_BACKEND_DIRECT;
+            return 1;
+        }
+        if (_lang_is_word(value, end, "comb")) {
+            rules->backend = SCANNER_BACKEND_COMB;
+            return 1;
+        }
+
+        printf("ERROR: the backend has to be `table`, `direct` or `comb`.\n");
+        return 0;
+    }
+
+    printf("ERROR: unknown option `%%%.*s`.\n", (int)(name_end - begin), begin);
+    return 0;
+}
+
+/**
+ * Adds the definition of a single line [begin, end). Returns 0 if the line is invalid.
+ */
+static unsigned char _lang_parse_line(struct scanner_rules * const rules,
+                                      const char *begin, const char *end) {
+    while (begin < end && _lang_is_space(*begin)) {
+        begin++;
+    }
+    while (end > begin && _lang_is_space(end[-1])) {
+        end--;
+    }
+
+    // empty line or comment
+    if (begin == end || *begin == '#') {
+        return 1;
+    }
+
+    if (*begin == '%') {
+        return _lang_parse_option(rules, begin + 1, end);
+    }
+
+    const char *colon = memchr(begin, ':', end - begin);
+    if (colon == NULL) {
+        printf("ERROR: expected `NAME : regex`.\n");
+        return 0;
+    }
+
+    const char *name_end = colon;
+    while (name_end > begin && _lang_is_space(name_end[-1])) {
+        name_end--;
+    }
+
+    const char *regex_begin = colon + 1;
+    while (regex_begin < end && _lang_is_space(*regex_begin)) {
+        regex_begin++;
+    }
+
+    if (name_end == begin || regex_begin == end) {
+        printf("ERROR: the name and the regex of a token can't be empty.\n");
+        return 0;
+    }
+
+    // `skip NAME`: the tokens are consumed but never emitted
+    // `define NAME`: not a token, only referenced by the regexes after it as `{NAME}`
+    const unsigned char skip = _lang_parse_modifier(&begin, name_end, "skip");
+    const unsigned char define = !skip && _lang_parse_modifier(&begin, name_end, "define");
+
+    // the names are C identifiers in the generated scanners (see emit.h) and in the references
+    if (!_lang_is_identifier(begin, name_end)) {
+        printf("ERROR: the name `%.*s` is not an identifier (letters, digits and `_`, not starting with a digit).\n",
+               (int)(name_end - begin), begin);
+        return 0;
+    }
+
+    for (unsigned short i = 0; i < rules->n_definitions; i++) {
+        if (_lang_is_word(begin, name_end, rules->definitions[i]->name->_s)) {
+            printf("ERROR: the name `%.*s` is already defined.\n", (int)(name_end - begin), begin);
+            return 0;
+        }
+    }
+
+    struct cutils_string *name = cutils_string_create_from_n(begin, name_end - begin);
+    struct cutils_string *regex = cutils_string_create_from_n(regex_begin, end - regex_begin);
+
+    struct SCANNER_REGEX_STATUS status = skip   ? scanner_rules_add_skip(rules, name->_s, regex->_s)
+                                       : define ? scanner_rules_define(rules, name->_s, regex->_s)
+                                                : scanner_rules_add(rules, name->_s, regex->_s);
+
+    if (status.type != SCANNER_REGEX_SUCCESS) {
+        printf("ERROR: invalid regex of token '%s': %s\n", name->_s, status.error_msg);
+    }
+
+    cutils_string_destroy(name);
+    cutils_string_destroy(regex);
+
+    return status.type == SCANNER_REGEX_SUCCESS;
+}
+
+unsigned int scanner_lang_parse(struct scanner_rules * const rules, const char * const source, const unsigned int n) {
+    const char *line = source;
+    const char * const end = source + n;
+
+    for (unsigned int line_i = 1; line < end; line_i++) {
+        const char *line_end = memchr(line, '\n', end - line);
+        if (line_end == NULL) {
+            line_end = end;
+        }
+
+        if (!_lang_parse_line(rules, line, line_end)) {
+            return line_i;
+        }
+
+        line = line_end + 1;
+    }
+
+    return 0;
+}
+
+struct scanner_rules *scanner_lang_load(const char * const path) {
+    struct cutils_mapped_file *file = cutils_mapped_file_open(path);
+
+    if (file == NULL) {
+        return NULL;
+    }
+
+    struct scanner_rules *rules = scanner_rules_create();
+    unsigned int error_line = scanner_lang_parse(rules, file->data, file->size);
+
+    if (error_line != 0) {
+        printf("\tin %s:%u\n", path, error_line);
+        scanner_rules_destroy(rules);
+        rules = NULL;
+    }
+
+    cutils_mapped_file_close(file);
+
+    return rules;
+}
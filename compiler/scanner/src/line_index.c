@@ -0,0 +1,64 @@
+#include <scanner_utils/line_index.h>
+
+#include <cutils/byteset.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef UNIT_TESTING
+    #include <cutils/cutils_unittest.h>
+#endif
+
+struct scanner_line_index *scanner_line_index_create(const char * const source, const unsigned int source_n) {
+    const struct cutils_byteset newline = cutils_byteset_create('\n');
+
+    struct scanner_line_index *index = malloc(sizeof(struct scanner_line_index));
+
+    if (index == NULL) {
+        printf("ERROR: `malloc` failed when creating line index.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    index->n_lines = 1 + cutils_byteset_count(&newline, source, source_n);
+    index->line_start = malloc(index->n_lines * sizeof(unsigned int));
+
+    if (index->line_start == NULL) {
+        printf("ERROR: `malloc` failed when creating line index with %u lines.\n", index->n_lines);
+        exit(EXIT_FAILURE);
+    }
+
+    index->line_start[0] = 0;
+
+    unsigned int line = 1;
+    unsigned int i = 0;
+    while ((i += cutils_byteset_find(&newline, source + i, source_n - i)) < source_n) {
+        index->line_start[line++] = ++i;
+    }
+
+    return index;
+}
+
+void scanner_line_index_destroy(struct scanner_line_index *index) {
+    if (index != NULL) {
+        free(index->line_start);
+        free(index);
+    }
+}
+
+unsigned int scanner_line_index_line(const struct scanner_line_index * const index, const unsigned int offset) {
+    // the last line that starts at or before the offset
+    unsigned int low = 0;
+    unsigned int high = index->n_lines;
+
+    while (high - low > 1) {
+        unsigned int middle = low + (high - low) / 2;
+
+        if (index->line_start[middle] <= offset) {
+            low = middle;
+        } else {
+            high = middle;
+        }
+    }
+
+    return low + 1;
+}
@@ -0,0 +1,159 @@
+#include <scanner_utils/parallel.h>
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef UNIT_TESTING
+    #include <cutils/cutils_unittest.h>
+#endif
+
+struct _parallel_chunk {
+    struct scanner_cursor *cursor;
+    struct scanner_token_stream *stream;
+    const char *text;
+    unsigned int text_n;
+    unsigned int from;
+    unsigned int to;
+};
+
+static void *_parallel_scan_chunk(void *arg) {
+    struct _parallel_chunk *chunk = arg;
+
+    scanner_token_stream_reset(chunk->stream, chunk->text, chunk->text_n);
+    scanner_token_stream_seek(chunk->stream, chunk->from, 1, 0);
+    scanner_cursor_scan_range(chunk->cursor, chunk->text, chunk->text_n, chunk->from, chunk->to, chunk->stream);
+
+    return NULL;
+}
+
+struct scanner_parallel *scanner_parallel_create(const struct scanner * const scanner, const unsigned int n_threads) {
+    struct scanner_parallel *parallel = malloc(sizeof(struct scanner_parallel));
+
+    if (parallel == NULL) {
+        printf("ERROR: `malloc` failed when creating parallel scanner.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    parallel->scanner = scanner;
+    parallel->n_threads = n_threads > 0 ? n_threads : 1;
+    parallel->_cursors = malloc(parallel->n_threads * sizeof(struct scanner_cursor *));
+    parallel->_chunks = malloc(parallel->n_threads * sizeof(struct scanner_token_stream *));
+
+    if (parallel->_cursors == NULL || parallel->_chunks == NULL) {
+        printf("ERROR: `malloc` failed when creating parallel scanner.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (unsigned int t = 0; t < parallel->n_threads; t++) {
+        parallel->_cursors[t] = scanner_cursor_create(scanner);
+        parallel->_chunks[t] = scanner_token_stream_create(NULL, 0);
+    }
+
+    return parallel;
+}
+
+void scanner_parallel_destroy(struct scanner_parallel *parallel) {
+    if (parallel != NULL) {
+        for (unsigned int t = 0; t < parallel->n_threads; t++) {
+            scanner_cursor_destroy(parallel->_cursors[t]);
+            scanner_token_stream_destroy(parallel->_chunks[t]);
+        }
+
+        free(parallel->_cursors);
+        free(parallel->_chunks);
+        free(parallel);
+    }
+}
+
+/**
+ * Index of the first token of `stream` that starts at `position` or after it.
+ */
+static unsigned int _parallel_lower_bound(const struct scanner_token_stream * const stream,
+                                          const unsigned int position) {
+    unsigned int low = 0;
+    unsigned int high = stream->n;
+
+    while (low < high) {
+        unsigned int mid = low + (high - low) / 2;
+
+        if (stream->start[mid] < position) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return low;
+}
+
+void scanner_parallel_scan(struct scanner_parallel * const parallel,
+                           const char * const text,
+                           const unsigned int text_n,
+                           struct scanner_token_stream * const stream) {
+    unsigned int n_chunks = text_n / SCANNER_PARALLEL_MIN_CHUNK;
+    if (n_chunks > parallel->n_threads) {
+        n_chunks = parallel->n_threads;
+    }
+
+    if (n_chunks <= 1) {
+        scanner_cursor_scan(parallel->_cursors[0], text, text_n, stream);
+        return;
+    }
+
+    struct _parallel_chunk chunks[n_chunks];
+    pthread_t threads[n_chunks];
+
+    for (unsigned int k = 0; k < n_chunks; k++) {
+        chunks[k].cursor = parallel->_cursors[k];
+        chunks[k].stream = parallel->_chunks[k];
+        chunks[k].stream->lazy_positions = stream->lazy_positions;
+        chunks[k].text = text;
+        chunks[k].text_n = text_n;
+        chunks[k].from = (unsigned int)((unsigned long long)text_n * k / n_chunks);
+        chunks[k].to = (unsigned int)((unsigned long long)text_n * (k + 1) / n_chunks);
+    }
+
+    // the first chunk on the calling thread
+    for (unsigned int k = 1; k < n_chunks; k++) {
+        if (pthread_create(&threads[k], NULL, _parallel_scan_chunk, &chunks[k]) != 0) {
+            printf("ERROR: `pthread_create` failed when starting a scanner thread.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    _parallel_scan_chunk(&chunks[0]);
+
+    for (unsigned int k = 1; k < n_chunks; k++) {
+        pthread_join(threads[k], NULL);
+    }
+
+    // stitching: `text_i` is the end of the last real token
+    struct scanner_cursor *cursor = parallel->_cursors[0];
+    unsigned int text_i = 0;
+
+    for (unsigned int k = 0; k < n_chunks; k++) {
+        const struct scanner_token_stream *chunk = chunks[k].stream;
+
+        if (text_i >= chunks[k].to) {
+            continue;
+        }
+
+        unsigned int i = _parallel_lower_bound(chunk, text_i);
+
+        // re-synchronization: real tokens until they meet a speculative token start
+        while (text_i < chunks[k].to && (i == chunk->n || chunk->start[i] != text_i)) {
+            text_i = scanner_cursor_scan_range(cursor, text, text_n, text_i, text_i + 1, stream);
+
+            while (i < chunk->n && chunk->start[i] < text_i) {
+                i++;
+            }
+        }
+
+        if (text_i >= chunks[k].to) {
+            continue;
+        }
+
+        scanner_token_stream_append(stream, chunk, i);
+        text_i = chunk->start[chunk->n - 1] + chunk->length[chunk->n - 1];
+    }
+}
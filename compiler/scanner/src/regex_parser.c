@@ -1,6 +1,7 @@
 #include <scanner_utils/regex_parser.h>
 
 #include <stdlib.h>
+#include <string.h>
 
 #include <cutils/arrayi.h>
 #include <cutils/string.h>
@@ -8,6 +9,44 @@
 
 struct SCANNER_REGEX_STATUS scanner_regex_parse(const struct cutils_string * const rgx,
                                                 struct scanner_regex_tree_node **root) {
+    return scanner_regex_parse_with_definitions(rgx, NULL, 0, root);
+}
+
+static inline unsigned char _regex_is_name_char(const char c) {
+    return cutils_string_is_alphanum_c(c) || c == '_';
+}
+
+/**
+ * Returns the index of the `}` if `{` at `i` starts a reference, otherwise 0.
+ */
+static unsigned int _regex_reference_end(const struct cutils_string * const rgx, const unsigned int i) {
+    unsigned int end = i + 1;
+    while (end < rgx->size && _regex_is_name_char(cutils_string_at(rgx, end))) {
+        end++;
+    }
+
+    return end > i + 1 && end < rgx->size && cutils_string_at(rgx, end) == '}' ? end : 0;
+}
+
+static const struct scanner_regex_definition *_regex_find_definition(struct scanner_regex_definition * const * const definitions,
+                                                                     const unsigned int n_definitions,
+                                                                     const char * const name,
+                                                                     const unsigned int name_n) {
+    for (unsigned int i = n_definitions; i > 0; i--) {
+        const struct scanner_regex_definition *definition = definitions[i - 1];
+
+        if (definition->name->size == name_n && memcmp(definition->name->_s, name, name_n) == 0) {
+            return definition;
+        }
+    }
+
+    return NULL;
+}
+
+struct SCANNER_REGEX_STATUS scanner_regex_parse_with_definitions(const struct cutils_string * const rgx,
+                                                                 struct scanner_regex_definition * const * const definitions,
+                                                                 const unsigned int n_definitions,
+                                                                 struct scanner_regex_tree_node **root) {
     struct SCANNER_REGEX_STATUS ret;
     ret.type = SCANNER_REGEX_SUCCESS;
     ret.error_index = -1;
@@ -226,6 +265,27 @@ struct SCANNER_REGEX_STATUS scanner_regex_parse(const struct cutils_string * con
                 clos->parent = conc;
             }
 
+            // reference to a definition: {NAME}
+            else if (current_char == '{' && definitions != NULL && _regex_reference_end(rgx, i) != 0) {
+                const unsigned int end = _regex_reference_end(rgx, i);
+                const struct scanner_regex_definition *definition =
+                    _regex_find_definition(definitions, n_definitions, rgx->_s + i + 1, end - i - 1);
+
+                if (definition == NULL) {
+                    ret.type = SCANNER_REGEX_ERROR_REFERENCE;
+                    ret.error_index = i;
+                    ret.error_msg = "Reference to an unknown definition...";
+                    break;
+                }
+
+                struct scanner_regex_tree_node *reference =
+                    scanner_regex_tree_create(SCANNER_REGEX_TREE_NODE_REFERENCE, '{');
+                reference->definition = definition;
+                scanner_regex_tree_add_child(conc, reference);
+
+                i = end;
+            }
+
             else if (current_char == '.') {
                 scanner_regex_tree_add_child(
                     conc, scanner_regex_tree_create(SCANNER_REGEX_TREE_NODE_WILDCARD, '.')
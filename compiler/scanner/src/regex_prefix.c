@@ -0,0 +1,157 @@
+#include <scanner_utils/regex_prefix.h>
+
+#include <scanner_utils/regex_parser.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef UNIT_TESTING
+    #include <cutils/cutils_unittest.h>
+#endif
+
+static void _prefix_init(struct scanner_regex_prefix * const prefix,
+                         const unsigned char nullable,
+                         const unsigned char exact) {
+    prefix->first_bytes = cutils_byteset_empty();
+    prefix->nullable = nullable;
+    prefix->exact = exact;
+    prefix->literal_n = 0;
+}
+
+static void _prefix_init_literal(struct scanner_regex_prefix * const prefix, const unsigned char literal) {
+    _prefix_init(prefix, 0, 1);
+    prefix->first_bytes = cutils_byteset_create(literal);
+    prefix->literal[0] = literal;
+    prefix->literal_n = 1;
+}
+
+/**
+ * Appends the literal of `b` to the literal of `a`.
+ * If the result doesn't fit, the literal is truncated and it can't be exact anymore.
+ */
+static void _prefix_append_literal(struct scanner_regex_prefix * const a,
+                                   const struct scanner_regex_prefix * const b) {
+    unsigned int n = b->literal_n;
+
+    if (a->literal_n + n > SCANNER_REGEX_PREFIX_MAX_LITERAL) {
+        n = SCANNER_REGEX_PREFIX_MAX_LITERAL - a->literal_n;
+        a->exact = 0;
+    }
+
+    memcpy(a->literal + a->literal_n, b->literal, n);
+    a->literal_n += n;
+}
+
+static void _prefix_recursive_analyze(const struct scanner_regex_tree_node * const node,
+                                      struct scanner_regex_prefix * const prefix) {
+    struct scanner_regex_prefix child;
+
+    switch (node->type) {
+        case SCANNER_REGEX_TREE_NODE_LITERAL:
+            _prefix_init_literal(prefix, node->literal);
+            break;
+
+        case SCANNER_REGEX_TREE_NODE_RANGE: {
+            // range: left-child contains the left of the range,
+            //        right-child contains the right of the range
+            unsigned char from = node->children[0]->literal;
+            unsigned char to = node->children[1]->literal;
+
+            if (from == to) {
+                _prefix_init_literal(prefix, from);
+            } else {
+                _prefix_init(prefix, 0, 0);
+                prefix->first_bytes = cutils_byteset_create_range(from, to);
+            }
+            break;
+        }
+
+        case SCANNER_REGEX_TREE_NODE_WILDCARD:
+            // NUL is reserved for the empty transition of the NFA
+            _prefix_init(prefix, 0, 0);
+            prefix->first_bytes = cutils_byteset_create_range(1, 127);
+            break;
+
+        case SCANNER_REGEX_TREE_NODE_ANYWHITE:
+            _prefix_init(prefix, 0, 0);
+            prefix->first_bytes = cutils_byteset_union(cutils_byteset_create_range('\t', '\n'),
+                                                       cutils_byteset_create('\r'));
+            prefix->first_bytes = cutils_byteset_union(prefix->first_bytes, cutils_byteset_create(' '));
+            break;
+
+        case SCANNER_REGEX_TREE_NODE_EMPTYLIT:
+            _prefix_init(prefix, 1, 1);
+            break;
+
+        case SCANNER_REGEX_TREE_NODE_REFERENCE:
+            _prefix_recursive_analyze(node->definition->tree, prefix);
+            break;
+
+        case SCANNER_REGEX_TREE_NODE_CLOS:
+            _prefix_recursive_analyze(node->children[0], prefix);
+            prefix->exact = 0;
+
+            // `+` keeps the prefix of its operand: a+ == aa*
+            if (node->literal != '+') {
+                prefix->nullable = 1;
+                prefix->literal_n = 0;
+            }
+            break;
+
+        case SCANNER_REGEX_TREE_NODE_CONC:
+            _prefix_init(prefix, 1, 1);
+
+            for (unsigned short i = 0; i < node->children_n; i++) {
+                _prefix_recursive_analyze(node->children[i], &child);
+
+                // the first bytes of the operand are only reachable if everything before it can be empty
+                if (prefix->nullable) {
+                    prefix->first_bytes = cutils_byteset_union(prefix->first_bytes, child.first_bytes);
+                }
+                prefix->nullable = prefix->nullable && child.nullable;
+
+                // the literal goes on while the operands before were exact
+                if (prefix->exact) {
+                    _prefix_append_literal(prefix, &child);
+                    prefix->exact = prefix->exact && child.exact;
+                }
+            }
+            break;
+
+        case SCANNER_REGEX_TREE_NODE_ALT:
+            _prefix_recursive_analyze(node->children[0], prefix);
+
+            for (unsigned short i = 1; i < node->children_n; i++) {
+                _prefix_recursive_analyze(node->children[i], &child);
+                scanner_regex_prefix_alter(prefix, &child);
+            }
+            break;
+    }
+}
+
+void scanner_regex_prefix_alter(struct scanner_regex_prefix * const a,
+                                const struct scanner_regex_prefix * const b) {
+    a->first_bytes = cutils_byteset_union(a->first_bytes, b->first_bytes);
+    a->nullable = a->nullable || b->nullable;
+
+    // alternatives are only exact if they are the very same literal
+    a->exact = a->exact && b->exact && a->literal_n == b->literal_n;
+
+    // longest common prefix
+    unsigned char common_n = 0;
+    while (common_n < a->literal_n && common_n < b->literal_n &&
+           a->literal[common_n] == b->literal[common_n]) {
+        common_n++;
+    }
+
+    if (common_n < a->literal_n) {
+        a->exact = 0;
+    }
+
+    a->literal_n = common_n;
+}
+
+void scanner_regex_prefix_analyze(const struct scanner_regex_tree_node * const root,
+                                  struct scanner_regex_prefix * const prefix) {
+    _prefix_recursive_analyze(root, prefix);
+}
@@ -21,6 +21,7 @@ struct scanner_regex_tree_node *scanner_regex_tree_create(
     n->_children_capacity = _SCANNER_REGEX_TREE_INITIAL_CAP;
     n->children = calloc(n->_children_capacity, sizeof(struct scanner_regex_tree_node*));
     n->parent = NULL;
+    n->definition = NULL;
 
     return n;
 }
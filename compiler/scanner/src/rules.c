@@ -0,0 +1,660 @@
+#include <scanner_utils/rules.h>
+
+#include <scanner_utils/dfa_cache.h>
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef UNIT_TESTING
+    #include <cutils/cutils_unittest.h>
+#endif
+
+#define _SCANNER_RULES_INITIAL_CAP 8
+
+struct scanner_rules *scanner_rules_create() {
+    struct scanner_rules *rules = malloc(sizeof(struct scanner_rules));
+
+    rules->n = 0;
+    rules->_capacity = _SCANNER_RULES_INITIAL_CAP;
+    rules->rules = malloc(rules->_capacity * sizeof(struct scanner_rule));
+    rules->n_definitions = 0;
+    rules->_capacity_definitions = _SCANNER_RULES_INITIAL_CAP;
+    rules->definitions = malloc(rules->_capacity_definitions * sizeof(struct scanner_regex_definition *));
+    rules->backend = SCANNER_BACKEND_TABLE;
+    rules->dfa_cache = NULL;
+    rules->n_threads = 1;
+
+    return rules;
+}
+
+void scanner_rules_destroy(struct scanner_rules *rules) {
+    if (rules == NULL) {
+        return;
+    }
+
+    // the names, regexes and trees of the rules belong to their definitions
+    for (unsigned short i = 0; i < rules->n_definitions; i++) {
+        cutils_string_destroy(rules->definitions[i]->name);
+        cutils_string_destroy(rules->definitions[i]->regex);
+        scanner_regex_tree_destroy(rules->definitions[i]->tree);
+        scanner_fa_destroy(rules->definitions[i]->nfa);
+        free(rules->definitions[i]);
+    }
+
+    free(rules->definitions);
+    free(rules->rules);
+    free(rules);
+}
+
+/**
+ * Parses the regex (with references to the definitions before it), compiles its NFA
+ * and appends it to the definitions. Returns NULL on error.
+ */
+static struct scanner_regex_definition *_rules_add_definition(struct scanner_rules * const rules,
+                                                              const char * const name,
+                                                              const char * const regex,
+                                                              struct SCANNER_REGEX_STATUS * const status) {
+    struct cutils_string *rgx = cutils_string_create_from(regex);
+    struct scanner_regex_tree_node *tree;
+
+    *status = scanner_regex_parse_with_definitions(rgx, rules->definitions, rules->n_definitions, &tree);
+
+    if (status->type != SCANNER_REGEX_SUCCESS) {
+        cutils_string_destroy(rgx);
+        return NULL;
+    }
+
+    if (rules->n_definitions == rules->_capacity_definitions) {
+        rules->_capacity_definitions *= 2;
+        struct scanner_regex_definition **new_definitions =
+            realloc(rules->definitions, rules->_capacity_definitions * sizeof(struct scanner_regex_definition *));
+
+        if (new_definitions == NULL) {
+            printf("ERROR: `realloc` failed when adding a definition. (new capacity: %d)\n", rules->_capacity_definitions);
+            exit(EXIT_FAILURE);
+        }
+
+        rules->definitions = new_definitions;
+    }
+
+    // the references point to the definition, it can't move
+    struct scanner_regex_definition *definition = malloc(sizeof(struct scanner_regex_definition));
+    definition->name = cutils_string_create_from(name);
+    definition->regex = rgx;
+    definition->tree = tree;
+    definition->nfa = scanner_fa_thompson_from_regex(tree);
+
+    rules->definitions[rules->n_definitions++] = definition;
+
+    return definition;
+}
+
+struct SCANNER_REGEX_STATUS scanner_rules_define(struct scanner_rules * const rules,
+                                                 const char * const name,
+                                                 const char * const regex) {
+    struct SCANNER_REGEX_STATUS status;
+    _rules_add_definition(rules, name, regex, &status);
+    return status;
+}
+
+struct SCANNER_REGEX_STATUS scanner_rules_add(struct scanner_rules * const rules,
+                                              const char * const name,
+                                              const char * const regex) {
+    struct SCANNER_REGEX_STATUS status;
+    const struct scanner_regex_definition *definition = _rules_add_definition(rules, name, regex, &status);
+
+    if (definition == NULL) {
+        return status;
+    }
+
+    if (rules->n == rules->_capacity) {
+        rules->_capacity *= 2;
+        struct scanner_rule *new_rules = realloc(rules->rules, rules->_capacity * sizeof(struct scanner_rule));
+
+        if (new_rules == NULL) {
+            printf("ERROR: `realloc` failed when adding a rule. (new capacity: %d)\n", rules->_capacity);
+            exit(EXIT_FAILURE);
+        }
+
+        rules->rules = new_rules;
+    }
+
+    struct scanner_rule *rule = rules->rules + rules->n;
+    rule->name = definition->name;
+    rule->regex = definition->regex;
+    rule->tree = definition->tree;
+    scanner_regex_prefix_analyze(rule->tree, &rule->prefix);
+    rule->skip = 0;
+    rule->definition = definition;
+
+    rules->n++;
+
+    return status;
+}
+
+struct SCANNER_REGEX_STATUS scanner_rules_add_skip(struct scanner_rules * const rules,
+                                                   const char * const name,
+                                                   const char * const regex) {
+    struct SCANNER_REGEX_STATUS status = scanner_rules_add(rules, name, regex);
+
+    if (status.type == SCANNER_REGEX_SUCCESS) {
+        rules->rules[rules->n - 1].skip = 1;
+    }
+
+    return status;
+}
+
+/**
+ * Compiles a single rule: NFA (of its definition) -> DFA -> minimal DFA
+ */
+static struct scanner_dfa *_rules_compile_rule(const struct scanner_rule * const rule, const unsigned short token) {
+    struct scanner_fa_128 *fa = scanner_fa_copy(rule->definition->nfa);
+    scanner_fa_nfa_to_dfa(fa);
+
+    struct scanner_dfa *dfa = scanner_dfa_create_from_fa(fa, token);
+    scanner_dfa_minimize(dfa);
+
+    scanner_fa_destroy(fa);
+
+    return dfa;
+}
+
+// ------------------
+// PRODUCT CONSTRUCTION
+//
+// A state of the combined DFA is a pair of states of the two combined DFAs.
+// The pairs are stored as 4-byte tuples one after the other in a byte array,
+// and they are found by an open addressing hash table of state indices.
+// ------------------
+
+struct _rules_product {
+    unsigned int k;                 // tuple size in bytes
+    unsigned int n_states;
+    unsigned int _capacity_states;
+    unsigned char *tuples;          // n_states * k
+    unsigned short *transition;     // n_states * 256
+
+    unsigned int _n_buckets;        // power of 2
+    unsigned int *buckets;          // state index + 1, 0 if empty
+};
+
+static unsigned int _product_hash(const unsigned char * const tuple, const unsigned int k) {
+    unsigned int h = 2166136261u;
+    for (unsigned int i = 0; i < k; i++) {
+        h = (h ^ tuple[i]) * 16777619u;
+    }
+    return h;
+}
+
+static void _product_rehash(struct _rules_product * const p) {
+    free(p->buckets);
+    p->buckets = calloc(p->_n_buckets, sizeof(unsigned int));
+
+    for (unsigned int state = 0; state < p->n_states; state++) {
+        unsigned int b = _product_hash(p->tuples + state * p->k, p->k) & (p->_n_buckets - 1);
+        while (p->buckets[b] != 0) {
+            b = (b + 1) & (p->_n_buckets - 1);
+        }
+        p->buckets[b] = state + 1;
+    }
+}
+
+/**
+ * Returns the state of the tuple, adds it as a new state if it doesn't exist yet.
+ */
+static unsigned int _product_state(struct _rules_product * const p, const unsigned char * const tuple) {
+    unsigned int b = _product_hash(tuple, p->k) & (p->_n_buckets - 1);
+
+    while (p->buckets[b] != 0) {
+        unsigned int state = p->buckets[b] - 1;
+        if (memcmp(p->tuples + state * p->k, tuple, p->k) == 0) {
+            return state;
+        }
+        b = (b + 1) & (p->_n_buckets - 1);
+    }
+
+    if (p->n_states == 0xFFFF) {
+        printf("ERROR: scanner_rules_compile -> resulting DFA is too big. Aborting...\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (p->n_states == p->_capacity_states) {
+        p->_capacity_states *= 2;
+        p->tuples = realloc(p->tuples, p->_capacity_states * p->k);
+        p->transition = realloc(p->transition, p->_capacity_states * 256 * sizeof(unsigned short));
+    }
+
+    unsigned int state = p->n_states++;
+    memcpy(p->tuples + state * p->k, tuple, p->k);
+    p->buckets[b] = state + 1;
+
+    // keeping the load factor at most 1/2
+    if (2 * p->n_states > p->_n_buckets) {
+        p->_n_buckets *= 2;
+        _product_rehash(p);
+    }
+
+    return state;
+}
+
+static unsigned int _product_pair_state(struct _rules_product * const p, const unsigned short a, const unsigned short b) {
+    const unsigned short pair[2] = {a, b};
+    return _product_state(p, (const unsigned char *)pair);
+}
+
+/**
+ * The minimal DFA of the union of `a` and `b`, `a` has the higher priority.
+ * The tokens of `b` come after the `a_tokens` tokens of `a`.
+ */
+static struct scanner_dfa *_rules_combine(const struct scanner_dfa * const a,
+                                          const struct scanner_dfa * const b,
+                                          const unsigned short a_tokens) {
+    struct _rules_product p;
+    p.k = 2 * sizeof(unsigned short);
+    p.n_states = 0;
+    p._capacity_states = 64;
+    p.tuples = malloc(p._capacity_states * p.k);
+    p.transition = malloc(p._capacity_states * 256 * sizeof(unsigned short));
+    p._n_buckets = 128;
+    p.buckets = NULL;
+    _product_rehash(&p);
+
+    // state_0: both DFAs are in their error state
+    _product_pair_state(&p, SCANNER_DFA_STATE_ERROR, SCANNER_DFA_STATE_ERROR);
+    const unsigned int initial_state = _product_pair_state(&p, a->initial_state, b->initial_state);
+
+    // the states that are not processed yet are the worklist
+    for (unsigned int state = 1; state < p.n_states; state++) {
+        unsigned short pair[2];
+        memcpy(pair, p.tuples + state * p.k, p.k);
+
+        const unsigned short *a_row = a->transition + (unsigned int)pair[0] * 256;
+        const unsigned short *b_row = b->transition + (unsigned int)pair[1] * 256;
+
+        for (unsigned int c = 0; c < 256; c++) {
+            // `p.transition` might be reallocated by `_product_state`
+            const unsigned int next_state = _product_pair_state(&p, a_row[c], b_row[c]);
+            p.transition[state * 256 + c] = next_state;
+        }
+    }
+
+    struct scanner_dfa *dfa = scanner_dfa_create(p.n_states);
+    dfa->initial_state = initial_state;
+
+    // the error state's row stays all error
+    memcpy(dfa->transition + 256, p.transition + 256, (p.n_states - 1) * 256 * sizeof(unsigned short));
+
+    for (unsigned int state = 1; state < p.n_states; state++) {
+        unsigned short pair[2];
+        memcpy(pair, p.tuples + state * p.k, p.k);
+
+        if (a->token[pair[0]] != 0) {
+            dfa->token[state] = a->token[pair[0]];
+        } else if (b->token[pair[1]] != 0) {
+            dfa->token[state] = a_tokens + b->token[pair[1]];
+        }
+    }
+
+    scanner_dfa_minimize(dfa);
+
+    free(p.tuples);
+    free(p.transition);
+    free(p.buckets);
+
+    return dfa;
+}
+
+// ------------------
+// COMBINATION TREE
+//
+// The rule DFAs are combined pairwise in a binary tree over the rules (in priority order).
+// The left child of a node has the largest power of 2 rules that is less than all of its rules,
+// so appending a rule only changes the rightmost nodes.
+//
+// The tokens of a node are local: the i-th rule of the node recognizes token i.
+// The DFA of a node only depends on the regexes under it, so with a DFA cache
+// (`dfa_cache` of the rules, see dfa_cache.h) a node is loaded if none of its regexes
+// changed, and a changed rule only recompiles its own DFA and the nodes above it.
+//
+// The nodes are compiled by a pool of `n_threads` workers. A node is ready when the DFAs of
+// its children are there, the workers take the ready nodes from a stack. A node only reads
+// the DFAs of its children (and frees them), so the workers share nothing but the stack,
+// and the shape of the tree doesn't depend on the threads: the DFA is the same with any number of them.
+// ------------------
+
+struct _rules_node {
+    unsigned short from;        // the included rules [from, to)
+    unsigned short to;
+    int parent;                 // -1 for the root
+    int left;                   // -1 for the leaves
+    int right;
+    unsigned char pending;      // the children without DFA
+    unsigned long long key;     // cache key
+    struct scanner_dfa *dfa;
+};
+
+struct _rules_tree {
+    const struct scanner_rules *rules;
+    const unsigned short *rule_index;       // the included rules
+    const unsigned long long *leaf_key;     // the cache keys of their regexes
+
+    struct _rules_node *nodes;
+    unsigned int n_nodes;
+
+    // the work of the pool, guarded by `lock`
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    int *ready;                 // stack of the nodes that can be compiled
+    unsigned int n_ready;
+    unsigned int n_todo;        // the nodes that are not in the cache
+    unsigned int n_done;
+};
+
+static unsigned short _rules_tree_split(const unsigned short n) {
+    unsigned short left = 1;
+    while (2 * left < n) {
+        left *= 2;
+    }
+    return left;
+}
+
+/**
+ * Adds the node of the included rules [from, to) and its subtree, returns its index.
+ */
+static int _rules_tree_build(struct _rules_tree * const tree, const unsigned short from, const unsigned short to, const int parent) {
+    const int index = tree->n_nodes++;
+    struct _rules_node *node = tree->nodes + index;
+
+    node->from = from;
+    node->to = to;
+    node->parent = parent;
+    node->left = -1;
+    node->right = -1;
+    node->pending = 0;
+    node->key = tree->leaf_key[from];
+    node->dfa = NULL;
+
+    if (to - from > 1) {
+        const unsigned short mid = from + _rules_tree_split(to - from);
+        const int left = _rules_tree_build(tree, from, mid, index);
+        const int right = _rules_tree_build(tree, mid, to, index);
+
+        // `tree->nodes + index` is still valid, the array has the room for all nodes
+        node->left = left;
+        node->right = right;
+        node->key = scanner_dfa_cache_combine_key(tree->nodes[left].key, tree->nodes[right].key);
+    }
+
+    return index;
+}
+
+/**
+ * Loads the DFA of the node from the cache, or else the subtree under it:
+ * the nodes that have to be compiled are counted and the ones without pending children are ready.
+ */
+static void _rules_tree_load(struct _rules_tree * const tree, const int index) {
+    struct _rules_node *node = tree->nodes + index;
+
+    if (tree->rules->dfa_cache != NULL) {
+        node->dfa = scanner_dfa_cache_load(tree->rules->dfa_cache, node->key);
+        if (node->dfa != NULL) {
+            return;
+        }
+    }
+
+    if (node->left >= 0) {
+        _rules_tree_load(tree, node->left);
+        _rules_tree_load(tree, node->right);
+        node->pending = (tree->nodes[node->left].dfa == NULL) + (tree->nodes[node->right].dfa == NULL);
+    }
+
+    tree->n_todo++;
+    if (node->pending == 0) {
+        tree->ready[tree->n_ready++] = index;
+    }
+}
+
+/**
+ * The DFA of the node with local tokens from the DFAs of its children (they are destroyed).
+ */
+static void _rules_tree_compile_node(const struct _rules_tree * const tree, struct _rules_node * const node) {
+    if (node->left < 0) {
+        node->dfa = _rules_compile_rule(tree->rules->rules + tree->rule_index[node->from], 1);
+    } else {
+        struct _rules_node *left = tree->nodes + node->left;
+        struct _rules_node *right = tree->nodes + node->right;
+
+        node->dfa = _rules_combine(left->dfa, right->dfa, left->to - left->from);
+
+        scanner_dfa_destroy(left->dfa);
+        scanner_dfa_destroy(right->dfa);
+        left->dfa = NULL;
+        right->dfa = NULL;
+    }
+
+    if (tree->rules->dfa_cache != NULL) {
+        scanner_dfa_cache_store(tree->rules->dfa_cache, node->key, node->dfa);
+    }
+}
+
+/**
+ * A worker of the pool: compiles ready nodes until all of them are done.
+ */
+static void *_rules_tree_worker(void *arg) {
+    struct _rules_tree *tree = arg;
+
+    pthread_mutex_lock(&tree->lock);
+
+    for (;;) {
+        while (tree->n_ready == 0 && tree->n_done < tree->n_todo) {
+            pthread_cond_wait(&tree->changed, &tree->lock);
+        }
+
+        if (tree->n_ready == 0) {
+            break;
+        }
+
+        struct _rules_node *node = tree->nodes + tree->ready[--tree->n_ready];
+        pthread_mutex_unlock(&tree->lock);
+
+        _rules_tree_compile_node(tree, node);
+
+        pthread_mutex_lock(&tree->lock);
+        tree->n_done++;
+
+        // a ready parent is taken by this worker in the next round
+        if (node->parent >= 0 && --tree->nodes[node->parent].pending == 0) {
+            tree->ready[tree->n_ready++] = node->parent;
+        } else if (tree->n_done == tree->n_todo) {
+            pthread_cond_broadcast(&tree->changed);
+        }
+    }
+
+    pthread_mutex_unlock(&tree->lock);
+
+    return NULL;
+}
+
+struct scanner_dfa *scanner_rules_compile_included(const struct scanner_rules * const rules,
+                                                   const unsigned char * const included) {
+    unsigned short *rule_index = malloc((rules->n + 1) * sizeof(unsigned short));
+    unsigned long long *leaf_key = malloc((rules->n + 1) * sizeof(unsigned long long));
+    unsigned short k = 0;
+
+    for (unsigned short i = 0; i < rules->n; i++) {
+        if (included == NULL || included[i]) {
+            rule_index[k] = i;
+            leaf_key[k] = rules->dfa_cache != NULL ? scanner_dfa_cache_regex_key(rules->rules[i].definition) : 0;
+            k++;
+        }
+    }
+
+    if (k == 0) {
+        free(rule_index);
+        free(leaf_key);
+
+        // only the error state
+        return scanner_dfa_create(1);
+    }
+
+    struct _rules_tree tree;
+    tree.rules = rules;
+    tree.rule_index = rule_index;
+    tree.leaf_key = leaf_key;
+    tree.nodes = malloc((2 * k - 1) * sizeof(struct _rules_node));
+    tree.n_nodes = 0;
+    tree.ready = malloc((2 * k - 1) * sizeof(int));
+    tree.n_ready = 0;
+    tree.n_todo = 0;
+    tree.n_done = 0;
+    pthread_mutex_init(&tree.lock, NULL);
+    pthread_cond_init(&tree.changed, NULL);
+
+    _rules_tree_build(&tree, 0, k, -1);
+    _rules_tree_load(&tree, 0);
+
+    // at most as many threads as leaves to compile, the first thread is the calling one
+    unsigned int n_threads = rules->n_threads > 0 ? rules->n_threads : 1;
+    if (n_threads > tree.n_ready) {
+        n_threads = tree.n_ready > 0 ? tree.n_ready : 1;
+    }
+
+    pthread_t handles[n_threads];
+
+    for (unsigned int t = 1; t < n_threads; t++) {
+        if (pthread_create(&handles[t], NULL, _rules_tree_worker, &tree) != 0) {
+            printf("ERROR: `pthread_create` failed when starting a compiler thread.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    _rules_tree_worker(&tree);
+
+    for (unsigned int t = 1; t < n_threads; t++) {
+        pthread_join(handles[t], NULL);
+    }
+
+    struct scanner_dfa *dfa = tree.nodes[0].dfa;
+
+    // the local tokens of the root are the included rules in order
+    for (unsigned short state = 1; state < dfa->n_states; state++) {
+        if (dfa->token[state] != 0) {
+            dfa->token[state] = rule_index[dfa->token[state] - 1] + 1;
+        }
+    }
+
+    pthread_cond_destroy(&tree.changed);
+    pthread_mutex_destroy(&tree.lock);
+    free(tree.ready);
+    free(tree.nodes);
+    free(rule_index);
+    free(leaf_key);
+
+    return dfa;
+}
+
+/**
+ * Runs the DFA on the literal, returns the token that it recognizes (0 if none).
+ */
+static unsigned short _rules_dfa_classify(const struct scanner_dfa * const dfa, const char * const literal, const unsigned int n) {
+    unsigned short state = dfa->initial_state;
+
+    for (unsigned int i = 0; i < n && state != SCANNER_DFA_STATE_ERROR; i++) {
+        state = dfa->transition[state * 256 + (unsigned char)literal[i]];
+    }
+
+    return dfa->token[state];
+}
+
+/**
+ * The first keyword candidate with the same literal as the i-th rule (i itself if there is none).
+ */
+static unsigned short _rules_find_keyword(const struct scanner_rules * const rules,
+                                          const unsigned char * const included,
+                                          const unsigned short i) {
+    const struct scanner_regex_prefix *prefix = &rules->rules[i].prefix;
+
+    for (unsigned short j = 0; j < i; j++) {
+        const struct scanner_regex_prefix *other = &rules->rules[j].prefix;
+
+        if (!included[j] && other->literal_n == prefix->literal_n &&
+            memcmp(other->literal, prefix->literal, prefix->literal_n) == 0) {
+            return j;
+        }
+    }
+
+    return i;
+}
+
+struct scanner_dfa *scanner_rules_compile(const struct scanner_rules * const rules,
+                                          struct scanner_keywords ** const keywords) {
+    if (keywords == NULL) {
+        return scanner_rules_compile_included(rules, NULL);
+    }
+
+    *keywords = NULL;
+
+    // keyword candidates: pure literals
+    unsigned char *included = malloc(rules->n);
+    unsigned short n_candidates = 0;
+
+    for (unsigned short i = 0; i < rules->n; i++) {
+        const struct scanner_regex_prefix *prefix = &rules->rules[i].prefix;
+        included[i] = !(prefix->exact && prefix->literal_n > 0);
+        n_candidates += !included[i];
+    }
+
+    if (n_candidates == 0) {
+        free(included);
+        return scanner_rules_compile_included(rules, NULL);
+    }
+
+    struct scanner_dfa *dfa = scanner_rules_compile_included(rules, included);
+    unsigned char recompile = 0;
+
+    for (unsigned short i = 0; i < rules->n; i++) {
+        if (included[i]) {
+            continue;
+        }
+
+        const struct scanner_regex_prefix *prefix = &rules->rules[i].prefix;
+        unsigned short shadow_token = _rules_dfa_classify(dfa, prefix->literal, prefix->literal_n);
+        unsigned short duplicate;
+
+        // nothing else matches the literal, it has to stay in the DFA
+        if (shadow_token == 0) {
+            included[i] = 1;
+            recompile = 1;
+        }
+        // a higher priority rule matches the literal: it can never be recognized
+        else if (shadow_token < i + 1) {
+            printf("WARNING: token `%s` can never be recognized, `%s` has higher priority and matches it too.\n",
+                   rules->rules[i].name->_s, rules->rules[shadow_token - 1].name->_s);
+        }
+        // an earlier keyword has the same literal, it wins
+        else if ((duplicate = _rules_find_keyword(rules, included, i)) < i) {
+            printf("WARNING: token `%s` can never be recognized, `%s` has higher priority and matches it too.\n",
+                   rules->rules[i].name->_s, rules->rules[duplicate].name->_s);
+        }
+        else {
+            if (*keywords == NULL) {
+                *keywords = scanner_keywords_create();
+            }
+            scanner_keywords_add(*keywords, prefix->literal, prefix->literal_n, i + 1, shadow_token);
+        }
+    }
+
+    if (recompile) {
+        scanner_dfa_destroy(dfa);
+        dfa = scanner_rules_compile_included(rules, included);
+    }
+
+    if (*keywords != NULL) {
+        scanner_keywords_build(*keywords);
+    }
+
+    free(included);
+
+    return dfa;
+}
@@ -0,0 +1,1139 @@
+#include <scanner_utils/runtime.h>
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef UNIT_TESTING
+    #include <cutils/cutils_unittest.h>
+#endif
+
+/**
+ * Derives the candidate positions of search mode from the DFA:
+ * the first bytes are the bytes leaving the initial state, and the required prefix
+ * goes on while there is only a single way forward.
+ */
+static void _scanner_find_prefix(struct scanner * const scanner) {
+    const struct scanner_dfa *dfa = scanner->dfa;
+
+    scanner->required_prefix_n = 0;
+
+    // a token can be empty, it can start anywhere
+    if (dfa->token[dfa->initial_state] != 0) {
+        scanner->first_bytes = cutils_byteset_negate(cutils_byteset_empty());
+        return;
+    }
+
+    scanner->first_bytes = cutils_byteset_empty();
+    for (unsigned int c = 0; c < 256; c++) {
+        if (dfa->transition[dfa->initial_state * 256 + c] != SCANNER_DFA_STATE_ERROR) {
+            scanner->first_bytes._bitvector[c >> 5] |= 1u << (c & 31);
+        }
+    }
+    _cutils_byteset_update_ranges(&scanner->first_bytes);
+
+    unsigned short state = dfa->initial_state;
+    while (dfa->token[state] == 0 && scanner->required_prefix_n < SCANNER_REGEX_PREFIX_MAX_LITERAL) {
+        unsigned short n_next = 0;
+        unsigned int byte = 0;
+
+        for (unsigned int c = 0; c < 256 && n_next < 2; c++) {
+            if (dfa->transition[state * 256 + c] != SCANNER_DFA_STATE_ERROR) {
+                n_next++;
+                byte = c;
+            }
+        }
+
+        if (n_next != 1) {
+            break;
+        }
+
+        scanner->required_prefix[scanner->required_prefix_n++] = (char)byte;
+        state = dfa->transition[state * 256 + byte];
+    }
+}
+
+/**
+ * Finds the bytes where a skip token can be consumed without the DFA: the initial state goes
+ * on them to an accepting state of a skip token, which can only loop on itself
+ * (e.g. `( |\t|\n)+`). The token is then exactly the run of the self-loop bytes.
+ */
+static void _scanner_find_skip_runs(struct scanner * const scanner) {
+    const struct scanner_dfa *dfa = scanner->dfa;
+
+    scanner->skip_run_bytes = cutils_byteset_empty();
+
+    for (unsigned int c = 0; c < 256; c++) {
+        unsigned short state = dfa->transition[dfa->initial_state * 256 + c];
+        unsigned short token = dfa->token[state];
+
+        if (state == SCANNER_DFA_STATE_ERROR || token == 0 || !scanner->skip[token]) {
+            continue;
+        }
+
+        // the keywords could reclassify the lexeme
+        if (scanner->keywords != NULL) {
+            unsigned char shadowing = 0;
+            for (unsigned int slot = 0; slot < scanner->keywords->n_slots; slot++) {
+                shadowing = shadowing || (scanner->keywords->token[slot] != 0 &&
+                                          scanner->keywords->shadow_token[slot] == token);
+            }
+            if (shadowing) {
+                continue;
+            }
+        }
+
+        unsigned short n_transitions = 0;
+        for (unsigned int next = 0; next < 256; next++) {
+            n_transitions += dfa->transition[state * 256 + next] != SCANNER_DFA_STATE_ERROR;
+        }
+
+        if (n_transitions == cutils_byteset_size(dfa->self_loop[state])) {
+            scanner->skip_run_bytes._bitvector[c >> 5] |= 1u << (c & 31);
+        }
+    }
+
+    _cutils_byteset_update_ranges(&scanner->skip_run_bytes);
+}
+
+struct scanner *scanner_create(struct scanner_dfa *dfa,
+                               struct scanner_keywords *keywords,
+                               const char * const * const token_names,
+                               const unsigned char * const skip,
+                               const unsigned short n_tokens) {
+    struct scanner *scanner = malloc(sizeof(struct scanner));
+
+    if (scanner == NULL) {
+        printf("ERROR: `malloc` failed when creating scanner.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    scanner->dfa = dfa;
+    scanner->keywords = keywords;
+
+    scanner->n_tokens = n_tokens + 1;
+    scanner->token_names = malloc(scanner->n_tokens * sizeof(struct cutils_string *));
+
+    // TOKEN[0] will always hold the token category for ERROR
+    // strings with this TOKEN will always contain 1 character!
+    scanner->token_names[0] = cutils_string_create_from("uncategorized");
+    for (unsigned short i = 0; i < n_tokens; i++) {
+        scanner->token_names[i + 1] = cutils_string_create_from(token_names[i]);
+    }
+
+    // the uncategorized token is always emitted
+    scanner->skip = calloc(scanner->n_tokens, sizeof(unsigned char));
+    for (unsigned short i = 0; skip != NULL && i < n_tokens; i++) {
+        scanner->skip[i + 1] = skip[i];
+    }
+
+    _scanner_find_prefix(scanner);
+    _scanner_find_skip_runs(scanner);
+
+    scanner->coalesce_errors = 0;
+
+    return scanner;
+}
+
+struct scanner *scanner_create_from_rules(const struct scanner_rules * const rules) {
+    struct scanner_keywords *keywords;
+    struct scanner_dfa *dfa = scanner_rules_compile(rules, &keywords);
+
+    // the rows of the states close to the initial state are the hottest
+    scanner_dfa_renumber_bfs(dfa);
+
+    const char **token_names = malloc(rules->n * sizeof(const char *));
+    unsigned char *skip = malloc(rules->n * sizeof(unsigned char));
+    for (unsigned short i = 0; i < rules->n; i++) {
+        token_names[i] = rules->rules[i].name->_s;
+        skip[i] = rules->rules[i].skip;
+    }
+
+    struct scanner *scanner = scanner_create(dfa, keywords, token_names, skip, rules->n);
+
+    free(token_names);
+    free(skip);
+
+    return scanner;
+}
+
+void scanner_destroy(struct scanner *scanner) {
+    if (scanner == NULL) {
+        return;
+    }
+
+    scanner_dfa_destroy(scanner->dfa);
+    scanner_keywords_destroy(scanner->keywords);
+
+    for (unsigned short i = 0; i < scanner->n_tokens; i++) {
+        cutils_string_destroy(scanner->token_names[i]);
+    }
+    free(scanner->token_names);
+    free(scanner->skip);
+
+    free(scanner);
+}
+
+// --------------------------------------
+// CURSOR
+// --------------------------------------
+
+struct scanner_cursor *scanner_cursor_create(const struct scanner * const scanner) {
+    struct scanner_cursor *cursor = malloc(sizeof(struct scanner_cursor));
+
+    if (cursor == NULL) {
+        printf("ERROR: `malloc` failed when creating scanner cursor.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    cursor->scanner = scanner;
+
+    cursor->_row_bytes = (scanner->dfa->n_states + 7) / 8;
+    cursor->_failed = calloc(SCANNER_CURSOR_WINDOW, cursor->_row_bytes);
+    cursor->_window = SCANNER_CURSOR_WINDOW;
+    cursor->_window_base = 0;
+    cursor->_marked_end = 0;
+    cursor->_offset = 0;
+    cursor->_text = NULL;
+
+    cursor->_path_capacity = 256;
+    cursor->_path = malloc(cursor->_path_capacity * sizeof(unsigned short));
+
+    if (cursor->_failed == NULL || cursor->_path == NULL) {
+        printf("ERROR: `malloc` failed when creating scanner cursor.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    return cursor;
+}
+
+void scanner_cursor_destroy(struct scanner_cursor *cursor) {
+    if (cursor != NULL) {
+        free(cursor->_failed);
+        free(cursor->_path);
+        free(cursor);
+    }
+}
+
+/**
+ * Starts over on a new text, `offset` is the position of the first char of the text.
+ */
+static void _cursor_reset(struct scanner_cursor * const cursor, const unsigned int offset) {
+    memset(cursor->_failed, 0, cursor->_window * cursor->_row_bytes);
+    cursor->_window_base = offset;
+    cursor->_marked_end = offset;
+    cursor->_offset = offset;
+    cursor->_text = NULL;
+    cursor->_reach = 0;
+}
+
+/**
+ * The text was examined until `reach` (`text_n + 1` if the end of the text was hit).
+ */
+static inline void _cursor_extend_reach(struct scanner_cursor * const cursor, const unsigned int reach) {
+    if (reach > cursor->_reach) {
+        cursor->_reach = reach;
+    }
+}
+
+/**
+ * A token ended at `end` after examining the char there (e.g. the end of a byte-set span).
+ */
+static inline void _cursor_extend_reach_after(struct scanner_cursor * const cursor,
+                                              const unsigned int text_n,
+                                              const unsigned int end) {
+    _cursor_extend_reach(cursor, end < text_n ? end + 1 : text_n + 1);
+}
+
+// The failed memo is indexed by positions that are relative to the whole input
+// (`_offset` + index in the current text), so it stays valid when the text is a window
+// of a longer input (streaming). The positions are modulo 2^32, only their differences matter.
+
+/**
+ * Moves the window of the failed memo to start at `text_i` (the start of the next token).
+ * The rows of the positions that leave the window are cleared for the positions that enter it,
+ * only the rows before `_marked_end` can have marks.
+ */
+static inline void _cursor_advance_window(struct scanner_cursor * const cursor, unsigned int text_i) {
+    text_i += cursor->_offset;
+
+    // nothing is marked, the usual case
+    if (cursor->_marked_end == cursor->_window_base) {
+        cursor->_window_base = text_i;
+        cursor->_marked_end = text_i;
+        return;
+    }
+
+    const unsigned int n_leaving = text_i - cursor->_window_base;
+    const unsigned int n_marked = cursor->_marked_end - cursor->_window_base;
+
+    if (n_marked >= cursor->_window && n_leaving >= cursor->_window) {
+        memset(cursor->_failed, 0, cursor->_window * cursor->_row_bytes);
+    } else {
+        const unsigned int n_cleared = n_leaving < n_marked ? n_leaving : n_marked;
+
+        for (unsigned int k = 0; k < n_cleared; k++) {
+            const unsigned int position = cursor->_window_base + k;
+            memset(cursor->_failed + (position & (cursor->_window - 1)) * cursor->_row_bytes, 0, cursor->_row_bytes);
+        }
+    }
+
+    if (n_marked < n_leaving) {
+        cursor->_marked_end = text_i;
+    }
+
+    cursor->_window_base = text_i;
+}
+
+/**
+ * Grows the window to cover the positions [_window_base, text_end).
+ */
+static void _cursor_reserve_window(struct scanner_cursor * const cursor, const unsigned int text_end) {
+    if (text_end - cursor->_window_base <= cursor->_window) {
+        return;
+    }
+
+    unsigned int window = cursor->_window;
+    while (text_end - cursor->_window_base > window) {
+        window *= 2;
+    }
+
+    unsigned char *failed = calloc(window, cursor->_row_bytes);
+
+    if (failed == NULL) {
+        printf("ERROR: `calloc` failed when growing the failed memo of the scanner cursor.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // rows keep their positions
+    for (unsigned int position = cursor->_window_base; position < cursor->_window_base + cursor->_window; position++) {
+        memcpy(failed + (position & (window - 1)) * cursor->_row_bytes,
+               cursor->_failed + (position & (cursor->_window - 1)) * cursor->_row_bytes,
+               cursor->_row_bytes);
+    }
+
+    free(cursor->_failed);
+    cursor->_failed = failed;
+    cursor->_window = window;
+}
+
+static inline unsigned char _cursor_is_failed(const struct scanner_cursor * const cursor,
+                                              const unsigned short state,
+                                              const unsigned int text_i) {
+    // positions outside of the window are not marked yet
+    if (text_i - cursor->_window_base >= cursor->_window) {
+        return 0;
+    }
+
+    const unsigned char *row = cursor->_failed + (text_i & (cursor->_window - 1)) * cursor->_row_bytes;
+    return (row[state >> 3] >> (state & 7)) & 1;
+}
+
+static inline void _cursor_set_failed(struct scanner_cursor * const cursor,
+                                      const unsigned short state,
+                                      const unsigned int text_i) {
+    unsigned char *row = cursor->_failed + (text_i & (cursor->_window - 1)) * cursor->_row_bytes;
+    row[state >> 3] |= 1 << (state & 7);
+}
+
+static inline void _cursor_path_push(struct scanner_cursor * const cursor, unsigned int * const path_n, const unsigned short state) {
+    if (*path_n == cursor->_path_capacity) {
+        cursor->_path_capacity *= 2;
+        cursor->_path = realloc(cursor->_path, cursor->_path_capacity * sizeof(unsigned short));
+
+        if (cursor->_path == NULL) {
+            printf("ERROR: `realloc` failed when growing the path of the scanner cursor.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    cursor->_path[(*path_n)++] = state;
+}
+
+static void _cursor_match_start(const struct scanner_cursor * const cursor,
+                                struct _scanner_match * const match,
+                                const unsigned int token_start) {
+    match->token_start = token_start;
+    match->token_end = token_start;
+    match->state = cursor->scanner->dfa->initial_state;
+    match->last_token = 0;
+    match->text_i = token_start;
+    match->path_start = token_start;
+    match->path_n = 0;
+}
+
+/**
+ * Runs the match until the longest token that starts at `match->token_start` is found.
+ * 
+ * If the text is not `final` (more text can follow it, e.g. streaming) and the DFA is still
+ * alive at the end of the text, the match is paused and it can be resumed on a longer text.
+ * 
+ * Returns:
+ *  1 if the match is complete:
+ *      `match->last_token` is the token recognized by the DFA (before keyword classification),
+ *      0 if no token starts at `token_start`, and `match->token_end` is the position after the token
+ *  0 if the match is paused
+ */
+static unsigned char _cursor_match_run(struct scanner_cursor * const cursor,
+                                       const char * const text,
+                                       const unsigned int text_n,
+                                       struct _scanner_match * const match,
+                                       const unsigned char final) {
+    const struct scanner_dfa *dfa = cursor->scanner->dfa;
+
+    unsigned short current_state = match->state;
+    unsigned int text_i = match->text_i;
+
+    // a short lookahead after the last accept is walked without the failed memo and the path
+    if (match->path_n == 0) {
+        const unsigned short * const transition = dfa->transition;
+        const unsigned short * const accepting = dfa->token;
+        unsigned short last_token = match->last_token;
+        unsigned int token_end = match->token_end;
+
+        while (current_state != SCANNER_DFA_STATE_ERROR) {
+            if (accepting[current_state] != 0) {
+                last_token = accepting[current_state];
+                token_end = text_i;
+            } else if (text_i - token_end > SCANNER_CURSOR_LOOKAHEAD) {
+                break;
+            }
+
+            if (text_i == text_n) {
+                break;
+            }
+
+            if (dfa->accelerated[current_state]) {
+                const unsigned int run = cutils_byteset_span(&dfa->self_loop[current_state], text + text_i, text_n - text_i);
+
+                if (run > 0) {
+                    text_i += run;
+                    continue;
+                }
+            }
+
+            current_state = transition[(unsigned int)current_state * 256 + (unsigned char)text[text_i]];
+            text_i += 1;
+        }
+
+        match->last_token = last_token;
+        match->token_end = token_end;
+
+        if (current_state == SCANNER_DFA_STATE_ERROR) {
+            _cursor_extend_reach(cursor, text_i);
+            return 1;
+        }
+
+        if (text_i == text_n) {
+            if (!final) {
+                match->state = current_state;
+                match->text_i = text_i;
+                return 0;
+            }
+
+            _cursor_extend_reach(cursor, text_n + 1);
+            return 1;
+        }
+
+        // the long lookahead goes on with the memo, from here
+        match->path_start = text_i;
+    }
+
+    while (current_state != SCANNER_DFA_STATE_ERROR) {
+        // everything before an accepting state is a success, the path starts again
+        if (dfa->token[current_state] != 0) {
+            match->last_token = dfa->token[current_state];
+            match->token_end = text_i;
+            match->path_start = text_i;
+            match->path_n = 0;
+        }
+
+        // we have already been here, no accepting state is reachable
+        if (_cursor_is_failed(cursor, current_state, cursor->_offset + text_i)) {
+            break;
+        }
+
+        if (text_i == text_n) {
+            if (!final) {
+                match->state = current_state;
+                match->text_i = text_i;
+                return 0;
+            }
+
+            _cursor_path_push(cursor, &match->path_n, current_state);
+            _cursor_extend_reach(cursor, text_n + 1);
+            break;
+        }
+
+        _cursor_path_push(cursor, &match->path_n, current_state);
+
+        // consuming the whole run of self-loop bytes at once
+        // (if the pair at the start of the run is not failed, none of the pairs in the run are)
+        if (dfa->accelerated[current_state]) {
+            unsigned int run = cutils_byteset_span(&dfa->self_loop[current_state], text + text_i, text_n - text_i);
+
+            if (run > 0) {
+                if (dfa->token[current_state] == 0) {
+                    for (unsigned int i = 1; i < run; i++) {
+                        _cursor_path_push(cursor, &match->path_n, current_state);
+                    }
+                }
+
+                text_i += run;
+                continue;
+            }
+        }
+
+        current_state = dfa->transition[(unsigned int)current_state * 256 + (unsigned char)text[text_i]];
+        text_i += 1;
+    }
+
+    _cursor_extend_reach(cursor, text_i);
+
+    // no accepting state was reached from the states after the last accept
+    _cursor_reserve_window(cursor, cursor->_offset + match->path_start + match->path_n);
+
+    for (unsigned int k = 0; k < match->path_n; k++) {
+        _cursor_set_failed(cursor, cursor->_path[k], cursor->_offset + match->path_start + k);
+    }
+
+    const unsigned int marked_end = cursor->_offset + match->path_start + match->path_n;
+    if (match->path_n > 0 && marked_end - cursor->_window_base > cursor->_marked_end - cursor->_window_base) {
+        cursor->_marked_end = marked_end;
+    }
+
+    return 1;
+}
+
+/**
+ * End of the uncategorized token that starts at `token_start` and is scanned until `text_i`:
+ * the first position after it where a token can start (see `coalesce_errors`).
+ */
+static inline unsigned int _cursor_error_end(const struct scanner_cursor * const cursor,
+                                             const char * const text,
+                                             const unsigned int text_n,
+                                             const unsigned int token_start,
+                                             unsigned int text_i) {
+    if (!cursor->scanner->coalesce_errors) {
+        return token_start + 1;
+    }
+
+    if (text_i <= token_start) {
+        text_i = token_start + 1;
+    }
+
+    return text_i + cutils_byteset_find(&cursor->scanner->first_bytes, text + text_i, text_n - text_i);
+}
+
+static inline unsigned char _cursor_match_is_error(const struct _scanner_match * const match) {
+    return match->last_token == 0 || match->token_end == match->token_start;
+}
+
+/**
+ * Pushes the token of a complete match, returns the position after it.
+ * A position where no token starts becomes an uncategorized token of length 1,
+ * or of the whole run of such positions with `coalesce_errors`.
+ */
+static unsigned int _cursor_push_token(const struct scanner_cursor * const cursor,
+                                       const char * const text,
+                                       const unsigned int text_n,
+                                       const struct _scanner_match * const match,
+                                       struct scanner_token_stream * const stream) {
+    unsigned int token_start = match->token_start;
+    unsigned int token_end = match->token_end;
+    unsigned short token = match->last_token;
+
+    if (!_cursor_match_is_error(match)) {
+        token = scanner_keywords_classify(cursor->scanner->keywords, token, text + token_start, token_end - token_start);
+    } else {
+        token = 0;
+        token_end = _cursor_error_end(cursor, text, text_n, token_start, token_start + 1);
+    }
+
+    if (!cursor->scanner->skip[token]) {
+        scanner_token_stream_push(stream, token_start, token_end - token_start, token);
+    }
+
+    return token_end;
+}
+
+/**
+ * Fast path of the skip tokens that are a single run of bytes (see `skip_run_bytes`):
+ * consumes the token with a byte-set span, without the DFA and the failed memo.
+ * Returns the position after the token, or `text_i` if no such token starts there.
+ */
+static inline unsigned int _cursor_skip_run(const struct scanner_cursor * const cursor,
+                                            const char * const text,
+                                            const unsigned int text_n,
+                                            const unsigned int text_i) {
+    const struct scanner *scanner = cursor->scanner;
+
+    if (!cutils_byteset_has_element(scanner->skip_run_bytes, text[text_i])) {
+        return text_i;
+    }
+
+    const struct scanner_dfa *dfa = scanner->dfa;
+    unsigned short state = dfa->transition[dfa->initial_state * 256 + (unsigned char)text[text_i]];
+
+    return text_i + 1 + cutils_byteset_span(&dfa->self_loop[state], text + text_i + 1, text_n - text_i - 1);
+}
+
+void scanner_cursor_scan(struct scanner_cursor * const cursor,
+                         const char * const text,
+                         const unsigned int text_n,
+                         struct scanner_token_stream * const stream) {
+    _cursor_reset(cursor, 0);
+    cursor->_text = text;
+
+    scanner_cursor_scan_range(cursor, text, text_n, 0, text_n, stream);
+}
+
+/**
+ * Scans the tokens that start in [from, to) with the failed marks of the cursor as they are.
+ */
+static unsigned int _cursor_scan(struct scanner_cursor * const cursor,
+                                 const char * const text,
+                                 const unsigned int text_n,
+                                 const unsigned int from,
+                                 const unsigned int to,
+                                 struct scanner_token_stream * const stream) {
+    struct _scanner_match match;
+    unsigned int text_i = from;
+
+    while (text_i < to && text_i < text_n) {
+        const unsigned int skipped = _cursor_skip_run(cursor, text, text_n, text_i);
+        if (skipped != text_i) {
+            _cursor_extend_reach_after(cursor, text_n, skipped);
+            text_i = skipped;
+            continue;
+        }
+
+        _cursor_advance_window(cursor, text_i);
+
+        _cursor_match_start(cursor, &match, text_i);
+        _cursor_match_run(cursor, text, text_n, &match, 1);
+
+        const unsigned int n = stream->n;
+        text_i = _cursor_push_token(cursor, text, text_n, &match, stream);
+
+        // the coalesced error run was found by searching the first bytes
+        if (cursor->scanner->coalesce_errors && _cursor_match_is_error(&match)) {
+            _cursor_extend_reach_after(cursor, text_n, text_i);
+        }
+
+        if (stream->track_reach && stream->n != n) {
+            stream->reach[n] = cursor->_reach;
+        }
+    }
+
+    return text_i;
+}
+
+unsigned int scanner_cursor_scan_range(struct scanner_cursor * const cursor,
+                                       const char * const text,
+                                       const unsigned int text_n,
+                                       const unsigned int from,
+                                       const unsigned int to,
+                                       struct scanner_token_stream * const stream) {
+    // the failed marks are facts about the text, they stay valid while the window only moves forward
+    if (text != cursor->_text || cursor->_offset != 0 || from < cursor->_window_base) {
+        _cursor_reset(cursor, 0);
+        cursor->_text = text;
+    }
+
+    return _cursor_scan(cursor, text, text_n, from, to, stream);
+}
+
+unsigned int scanner_cursor_rescan(struct scanner_cursor * const cursor,
+                                   struct scanner_token_stream * const stream,
+                                   const char * const text,
+                                   const unsigned int text_n,
+                                   const unsigned int offset,
+                                   const unsigned int deleted_n,
+                                   const unsigned int inserted_n) {
+    if (!stream->track_reach) {
+        printf("ERROR: scanner_cursor_rescan -> the stream was scanned without `track_reach`.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // the reach is non-decreasing: k = number of tokens that only examined text[0..offset)
+    unsigned int lo = 0;
+    unsigned int hi = stream->n;
+    while (lo < hi) {
+        const unsigned int mid = lo + (hi - lo) / 2;
+        if (stream->reach[mid] <= offset) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    const unsigned int k = lo;
+
+    // old tokens that start after the deleted chars are the candidates of the synchronization
+    hi = stream->n;
+    while (lo < hi) {
+        const unsigned int mid = lo + (hi - lo) / 2;
+        if (stream->start[mid] < offset + deleted_n) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    unsigned int j = lo;
+
+    struct scanner_token_stream *rescanned = scanner_token_stream_create(text, text_n);
+    rescanned->lazy_positions = stream->lazy_positions;
+    rescanned->track_reach = 1;
+
+    unsigned int text_i = 0;
+    _cursor_reset(cursor, 0);
+    cursor->_text = text;
+
+    if (k > 0) {
+        const unsigned long long position = stream->position[k - 1];
+        text_i = stream->start[k - 1] + stream->length[k - 1];
+        cursor->_reach = stream->reach[k - 1];
+        cursor->_window_base = text_i;
+        cursor->_marked_end = text_i;
+
+        if (!stream->lazy_positions) {
+            scanner_token_stream_seek(rescanned, stream->start[k - 1], SCANNER_TOKEN_LINE(position), SCANNER_TOKEN_COL(position));
+        }
+    }
+
+    const long long delta = (long long)inserted_n - deleted_n;
+
+    // token by token, until a new token starts where an old one did
+    while (text_i < text_n) {
+        while (j < stream->n && stream->start[j] + delta < text_i) {
+            j++;
+        }
+
+        if (j < stream->n && stream->start[j] + delta == text_i) {
+            break;
+        }
+
+        text_i = scanner_cursor_scan_range(cursor, text, text_n, text_i, text_i + 1, rescanned);
+    }
+
+    if (text_i >= text_n) {
+        j = stream->n;
+    }
+
+    const unsigned int n_rescanned = rescanned->n;
+    scanner_token_stream_splice(stream, k, j, rescanned, delta);
+    scanner_token_stream_destroy(rescanned);
+
+    return n_rescanned;
+}
+
+void scanner_cursor_search(struct scanner_cursor * const cursor,
+                           const char * const text,
+                           const unsigned int text_n,
+                           struct scanner_token_stream * const stream) {
+    const struct scanner_keywords *keywords = cursor->scanner->keywords;
+    struct _scanner_match match;
+    unsigned int text_i = 0;
+
+    _cursor_reset(cursor, 0);
+
+    // the failed pairs don't depend on where the token started, the memo is valid between candidates
+    while ((text_i = scanner_skip_ahead(cursor->scanner, text, text_n, text_i)) < text_n) {
+        _cursor_advance_window(cursor, text_i);
+
+        _cursor_match_start(cursor, &match, text_i);
+        _cursor_match_run(cursor, text, text_n, &match, 1);
+
+        if (match.last_token == 0 || match.token_end == text_i) {
+            text_i += 1; // false candidate, the token is not complete
+            continue;
+        }
+
+        const unsigned short token = scanner_keywords_classify(keywords, match.last_token,
+                                                               text + text_i, match.token_end - text_i);
+        if (!cursor->scanner->skip[token]) {
+            scanner_token_stream_push(stream, text_i, match.token_end - text_i, token);
+        }
+
+        text_i = match.token_end;
+    }
+}
+
+struct cutils_mapped_file *scanner_cursor_scan_file(struct scanner_cursor * const cursor,
+                                                    const char * const path,
+                                                    struct scanner_token_stream * const stream) {
+    struct cutils_mapped_file *file = cutils_mapped_file_open(path);
+
+    if (file == NULL) {
+        return NULL;
+    }
+
+    // offsets of the token stream are 32-bit
+    if (file->size > UINT_MAX) {
+        printf("ERROR: '%s' is too big to be scanned in one piece (%llu bytes).\n", path, file->size);
+        cutils_mapped_file_close(file);
+        return NULL;
+    }
+
+    scanner_token_stream_reset(stream, file->data, (unsigned int)file->size);
+    scanner_cursor_scan(cursor, file->data, (unsigned int)file->size, stream);
+
+    return file;
+}
+
+unsigned int scanner_skip_ahead(const struct scanner * const scanner,
+                                const char * const text,
+                                const unsigned int text_n,
+                                unsigned int text_i) {
+    while (text_i < text_n) {
+        text_i += cutils_byteset_find(&scanner->first_bytes, text + text_i, text_n - text_i);
+
+        if (text_i + scanner->required_prefix_n > text_n) {
+            break;
+        }
+
+        if (memcmp(text + text_i, scanner->required_prefix, scanner->required_prefix_n) == 0) {
+            return text_i;
+        }
+
+        text_i += 1;
+    }
+
+    return text_n;
+}
+
+// --------------------------------------
+// STREAMING
+// --------------------------------------
+
+// states of `scanner_push._matching`
+#define _SCANNER_PUSH_MATCHING 1    // the DFA is paused
+#define _SCANNER_PUSH_ERROR_RUN 2   // the match is complete, the uncategorized run goes on
+
+struct scanner_push *scanner_push_create(const struct scanner * const scanner,
+                                         void (*on_tokens)(struct scanner_push * const push, void *context),
+                                         void *context) {
+    struct scanner_push *push = malloc(sizeof(struct scanner_push));
+
+    if (push == NULL) {
+        printf("ERROR: `malloc` failed when creating streaming scanner.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    push->cursor = scanner_cursor_create(scanner);
+    push->on_tokens = on_tokens;
+    push->context = context;
+
+    push->_buffer_capacity = 4096;
+    push->_buffer = malloc(push->_buffer_capacity);
+    push->_buffer_n = 0;
+    push->_consumed = 0;
+    push->_matching = 0;
+
+    push->tokens = scanner_token_stream_create(push->_buffer, 0);
+
+    _cursor_reset(push->cursor, 0);
+
+    return push;
+}
+
+void scanner_push_destroy(struct scanner_push *push) {
+    if (push != NULL) {
+        scanner_cursor_destroy(push->cursor);
+        scanner_token_stream_destroy(push->tokens);
+        free(push->_buffer);
+        free(push);
+    }
+}
+
+/**
+ * Drops the tokenized chars from the front of the buffer.
+ */
+static void _push_compact(struct scanner_push * const push) {
+    const unsigned int shift = push->_consumed;
+
+    if (shift == 0) {
+        return;
+    }
+
+    scanner_token_stream_rebase(push->tokens, shift);
+
+    memmove(push->_buffer, push->_buffer + shift, push->_buffer_n - shift);
+    push->_buffer_n -= shift;
+    push->_consumed = 0;
+
+    if (push->_matching) {
+        push->_match.token_start -= shift;
+        push->_match.token_end -= shift;
+        push->_match.text_i -= shift;
+        push->_match.path_start -= shift;
+    }
+}
+
+/**
+ * Tokenizes the buffer from the end of the last complete token.
+ * The match in progress at the end of the buffer is paused, unless the input is `final`.
+ */
+static void _push_scan(struct scanner_push * const push, const unsigned char final) {
+    struct scanner_cursor *cursor = push->cursor;
+    struct scanner_token_stream *tokens = push->tokens;
+
+    tokens->source = push->_buffer;
+    tokens->source_n = push->_buffer_n;
+    scanner_token_stream_clear(tokens);
+
+    // the memo is indexed by positions in the whole input
+    cursor->_offset = (unsigned int)tokens->base_offset;
+
+    unsigned int text_i = push->_consumed;
+
+    while (1) {
+        if (!push->_matching) {
+            if (text_i >= push->_buffer_n) {
+                break;
+            }
+
+            _cursor_advance_window(cursor, text_i);
+            _cursor_match_start(cursor, &push->_match, text_i);
+        }
+
+        if (push->_matching != _SCANNER_PUSH_ERROR_RUN &&
+            !_cursor_match_run(cursor, push->_buffer, push->_buffer_n, &push->_match, final)) {
+            push->_matching = _SCANNER_PUSH_MATCHING;
+            break;
+        }
+
+        // a coalesced error run can go on in the next chunk, only the new chars are searched
+        if (!final && cursor->scanner->coalesce_errors && _cursor_match_is_error(&push->_match)) {
+            const unsigned int from = push->_matching == _SCANNER_PUSH_ERROR_RUN ? push->_match.text_i
+                                                                                 : push->_match.token_start + 1;
+
+            if (_cursor_error_end(cursor, push->_buffer, push->_buffer_n, push->_match.token_start, from) == push->_buffer_n) {
+                push->_match.text_i = push->_buffer_n;
+                push->_matching = _SCANNER_PUSH_ERROR_RUN;
+                break;
+            }
+        }
+
+        push->_matching = 0;
+        text_i = _cursor_push_token(cursor, push->_buffer, push->_buffer_n, &push->_match, tokens);
+    }
+
+    push->_consumed = push->_matching ? push->_match.token_start : text_i;
+
+    if (tokens->n > 0 && push->on_tokens != NULL) {
+        push->on_tokens(push, push->context);
+    }
+}
+
+void scanner_push_feed(struct scanner_push * const push, const char * const chunk, const unsigned int chunk_n) {
+    // the lexemes of the previous chunk are not needed anymore
+    _push_compact(push);
+
+    if (push->_buffer_n + chunk_n > push->_buffer_capacity) {
+        while (push->_buffer_n + chunk_n > push->_buffer_capacity) {
+            push->_buffer_capacity *= 2;
+        }
+
+        push->_buffer = realloc(push->_buffer, push->_buffer_capacity);
+
+        if (push->_buffer == NULL) {
+            printf("ERROR: `realloc` failed when growing the buffer of the streaming scanner. (new capacity: %u)\n",
+                   push->_buffer_capacity);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    memcpy(push->_buffer + push->_buffer_n, chunk, chunk_n);
+    push->_buffer_n += chunk_n;
+
+    _push_scan(push, 0);
+}
+
+void scanner_push_finish(struct scanner_push * const push) {
+    _push_compact(push);
+    _push_scan(push, 1);
+}
+
+// --------------------------------------
+// PULL
+// --------------------------------------
+
+struct scanner_pull *scanner_pull_create(const struct scanner * const scanner,
+                                         const char * const text,
+                                         const unsigned int text_n) {
+    struct scanner_pull *pull = malloc(sizeof(struct scanner_pull));
+
+    if (pull == NULL) {
+        printf("ERROR: `malloc` failed when creating pull scanner.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    pull->cursor = scanner_cursor_create(scanner);
+    pull->text = text;
+    pull->text_n = text_n;
+
+    pull->_text_i = 0;
+    pull->_batch = scanner_token_stream_create(text, text_n);
+    pull->_head = 0;
+    pull->_n = 0;
+
+    _cursor_reset(pull->cursor, 0);
+
+    return pull;
+}
+
+void scanner_pull_destroy(struct scanner_pull *pull) {
+    if (pull != NULL) {
+        scanner_cursor_destroy(pull->cursor);
+        scanner_token_stream_destroy(pull->_batch);
+        free(pull);
+    }
+}
+
+/**
+ * Scans the next batch of tokens into the free slots of the ring.
+ */
+static void _pull_fill(struct scanner_pull * const pull) {
+    struct scanner_cursor *cursor = pull->cursor;
+    struct scanner_token_stream *batch = pull->_batch;
+    struct _scanner_match match;
+
+    unsigned int batch_n = SCANNER_PULL_RING - pull->_n;
+    if (batch_n > SCANNER_PULL_BATCH) {
+        batch_n = SCANNER_PULL_BATCH;
+    }
+
+    scanner_token_stream_clear(batch);
+
+    while (batch->n < batch_n && pull->_text_i < pull->text_n) {
+        const unsigned int skipped = _cursor_skip_run(cursor, pull->text, pull->text_n, pull->_text_i);
+        if (skipped != pull->_text_i) {
+            pull->_text_i = skipped;
+            continue;
+        }
+
+        _cursor_advance_window(cursor, pull->_text_i);
+
+        _cursor_match_start(cursor, &match, pull->_text_i);
+        _cursor_match_run(cursor, pull->text, pull->text_n, &match, 1);
+
+        pull->_text_i = _cursor_push_token(cursor, pull->text, pull->text_n, &match, batch);
+    }
+
+    for (unsigned int i = 0; i < batch->n; i++) {
+        struct scanner_token *record = pull->_ring + ((pull->_head + pull->_n) & (SCANNER_PULL_RING - 1));
+
+        record->start = batch->start[i];
+        record->length = batch->length[i];
+        record->token = batch->token[i];
+        record->position = batch->position[i];
+
+        pull->_n++;
+    }
+}
+
+const struct scanner_token *scanner_peek(struct scanner_pull * const pull, const unsigned int k) {
+    if (k >= SCANNER_PULL_RING) {
+        return NULL;
+    }
+
+    while (pull->_n <= k && pull->_text_i < pull->text_n) {
+        _pull_fill(pull);
+    }
+
+    if (pull->_n <= k) {
+        return NULL;
+    }
+
+    return pull->_ring + ((pull->_head + k) & (SCANNER_PULL_RING - 1));
+}
+
+const struct scanner_token *scanner_next(struct scanner_pull * const pull) {
+    const struct scanner_token *token = scanner_peek(pull, 0);
+
+    if (token != NULL) {
+        pull->_head = (pull->_head + 1) & (SCANNER_PULL_RING - 1);
+        pull->_n--;
+    }
+
+    return token;
+}
+
+// --------------------------------------
+// BATCH
+// --------------------------------------
+
+struct scanner_batch *scanner_batch_create(const struct scanner * const scanner) {
+    struct scanner_batch *batch = malloc(sizeof(struct scanner_batch));
+
+    if (batch == NULL) {
+        printf("ERROR: `malloc` failed when creating batch scanner.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    batch->cursor = scanner_cursor_create(scanner);
+    batch->tokens = scanner_token_stream_create(NULL, 0);
+    batch->tokens->lazy_positions = 1;
+
+    batch->_offsets_capacity = 64;
+    batch->offsets = malloc(batch->_offsets_capacity * sizeof(unsigned int));
+    batch->offsets[0] = 0;
+    batch->n_inputs = 0;
+
+    if (batch->offsets == NULL) {
+        printf("ERROR: `malloc` failed when creating batch scanner.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    _cursor_reset(batch->cursor, 0);
+    batch->_position = 0;
+
+    return batch;
+}
+
+void scanner_batch_destroy(struct scanner_batch *batch) {
+    if (batch != NULL) {
+        scanner_cursor_destroy(batch->cursor);
+        scanner_token_stream_destroy(batch->tokens);
+        free(batch->offsets);
+        free(batch);
+    }
+}
+
+void scanner_batch_scan(struct scanner_batch * const batch,
+                        const struct scanner_string_view * const inputs,
+                        const unsigned int n_inputs) {
+    struct scanner_cursor *cursor = batch->cursor;
+
+    if (n_inputs + 1 > batch->_offsets_capacity) {
+        while (n_inputs + 1 > batch->_offsets_capacity) {
+            batch->_offsets_capacity *= 2;
+        }
+
+        free(batch->offsets);
+        batch->offsets = malloc(batch->_offsets_capacity * sizeof(unsigned int));
+
+        if (batch->offsets == NULL) {
+            printf("ERROR: `malloc` failed when growing the offsets of the batch scanner.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    scanner_token_stream_clear(batch->tokens);
+    batch->n_inputs = n_inputs;
+
+    for (unsigned int i = 0; i < n_inputs; i++) {
+        batch->offsets[i] = batch->tokens->n;
+
+        // the positions after the previous input (and its end of text) are new to the memo
+        cursor->_offset = batch->_position;
+        cursor->_text = NULL;
+        _cursor_scan(cursor, inputs[i].data, inputs[i].n, 0, inputs[i].n, batch->tokens);
+
+        batch->_position += inputs[i].n + 1;
+    }
+
+    batch->offsets[n_inputs] = batch->tokens->n;
+}
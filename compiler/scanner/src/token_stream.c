@@ -0,0 +1,301 @@
+#include <scanner_utils/token_stream.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef UNIT_TESTING
+    #include <cutils/cutils_unittest.h>
+#endif
+
+#define _SCANNER_TOKEN_STREAM_INITIAL_CAP 64
+
+static void _token_stream_realloc(struct scanner_token_stream * const stream, const unsigned int capacity) {
+    unsigned int *start = realloc(stream->start, capacity * sizeof(unsigned int));
+    unsigned int *length = realloc(stream->length, capacity * sizeof(unsigned int));
+    unsigned short *token = realloc(stream->token, capacity * sizeof(unsigned short));
+    unsigned long long *position = realloc(stream->position, capacity * sizeof(unsigned long long));
+    unsigned int *reach = realloc(stream->reach, capacity * sizeof(unsigned int));
+
+    if (start == NULL || length == NULL || token == NULL || position == NULL || reach == NULL) {
+        printf("ERROR: `realloc` failed when growing the token stream. (new capacity: %u)\n", capacity);
+        exit(EXIT_FAILURE);
+    }
+
+    stream->start = start;
+    stream->length = length;
+    stream->token = token;
+    stream->position = position;
+    stream->reach = reach;
+    stream->_capacity = capacity;
+}
+
+struct scanner_token_stream *scanner_token_stream_create(const char * const source, const unsigned int source_n) {
+    struct scanner_token_stream *stream = malloc(sizeof(struct scanner_token_stream));
+
+    if (stream == NULL) {
+        printf("ERROR: `malloc` failed when creating token stream.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    stream->start = NULL;
+    stream->length = NULL;
+    stream->token = NULL;
+    stream->position = NULL;
+    stream->reach = NULL;
+    stream->lazy_positions = 0;
+    stream->track_reach = 0;
+    stream->_newline = cutils_byteset_create('\n');
+    stream->_line_index = NULL;
+    _token_stream_realloc(stream, _SCANNER_TOKEN_STREAM_INITIAL_CAP);
+
+    scanner_token_stream_reset(stream, source, source_n);
+
+    return stream;
+}
+
+void scanner_token_stream_destroy(struct scanner_token_stream *stream) {
+    if (stream != NULL) {
+        free(stream->start);
+        free(stream->length);
+        free(stream->token);
+        free(stream->position);
+        free(stream->reach);
+        scanner_line_index_destroy(stream->_line_index);
+        free(stream);
+    }
+}
+
+void scanner_token_stream_reset(struct scanner_token_stream * const stream,
+                                const char * const source,
+                                const unsigned int source_n) {
+    stream->source = source;
+    stream->source_n = source_n;
+    stream->base_offset = 0;
+    stream->n = 0;
+
+    stream->_counted = 0;
+    stream->_line = 1;
+    stream->_line_start = 0;
+
+    scanner_line_index_destroy(stream->_line_index);
+    stream->_line_index = NULL;
+}
+
+void scanner_token_stream_clear(struct scanner_token_stream * const stream) {
+    stream->n = 0;
+}
+
+/**
+ * Counts the newlines in source[_counted..offset) into the current line.
+ */
+static void _token_stream_count_newlines(struct scanner_token_stream * const stream, const unsigned int offset) {
+    unsigned int n_newlines = cutils_byteset_count(&stream->_newline, stream->source + stream->_counted,
+                                                   offset - stream->_counted);
+
+    if (n_newlines > 0) {
+        stream->_line += n_newlines;
+
+        // the line starts after the last newline, it's at most a col away
+        unsigned int line_start = offset;
+        while (stream->source[line_start - 1] != '\n') {
+            line_start--;
+        }
+        stream->_line_start = line_start;
+    }
+
+    stream->_counted = offset;
+}
+
+void scanner_token_stream_rebase(struct scanner_token_stream * const stream, const unsigned int shift) {
+    _token_stream_count_newlines(stream, shift);
+
+    // the line can start before the new source, the col is still `start - _line_start` (modulo 2^32)
+    stream->_counted -= shift;
+    stream->_line_start -= shift;
+    stream->base_offset += shift;
+}
+
+void scanner_token_stream_seek(struct scanner_token_stream * const stream,
+                               const unsigned int offset,
+                               const unsigned int line,
+                               const unsigned int col) {
+    stream->_counted = offset;
+    stream->_line = line;
+    stream->_line_start = offset - col;
+}
+
+/**
+ * Grows the arrays to hold at least `n` tokens.
+ */
+static void _token_stream_reserve(struct scanner_token_stream * const stream, const unsigned int n) {
+    if (n > stream->_capacity) {
+        unsigned int capacity = stream->_capacity;
+        while (n > capacity) {
+            capacity *= 2;
+        }
+        _token_stream_realloc(stream, capacity);
+    }
+}
+
+/**
+ * The counting goes on from the last token.
+ */
+static void _token_stream_count_from_last(struct scanner_token_stream * const stream) {
+    if (stream->n == 0) {
+        scanner_token_stream_seek(stream, 0, 1, 0);
+        return;
+    }
+
+    const unsigned long long last = stream->position[stream->n - 1];
+    scanner_token_stream_seek(stream, stream->start[stream->n - 1], SCANNER_TOKEN_LINE(last), SCANNER_TOKEN_COL(last));
+}
+
+void scanner_token_stream_append(struct scanner_token_stream * const stream,
+                                 const struct scanner_token_stream * const src,
+                                 const unsigned int from) {
+    if (from >= src->n) {
+        return;
+    }
+
+    const unsigned int n = src->n - from;
+
+    _token_stream_reserve(stream, stream->n + n);
+
+    memcpy(stream->start + stream->n, src->start + from, n * sizeof(unsigned int));
+    memcpy(stream->length + stream->n, src->length + from, n * sizeof(unsigned int));
+    memcpy(stream->token + stream->n, src->token + from, n * sizeof(unsigned short));
+
+    if (!stream->lazy_positions) {
+        // the real position of the first token, the rest is relative to it
+        const unsigned int first_start = src->start[from];
+        _token_stream_count_newlines(stream, first_start);
+
+        const unsigned int first_line = SCANNER_TOKEN_LINE(src->position[from]);
+        const unsigned int line_shift = stream->_line - first_line;
+        const unsigned int col_shift = (first_start - stream->_line_start) - SCANNER_TOKEN_COL(src->position[from]);
+
+        for (unsigned int i = 0; i < n; i++) {
+            const unsigned long long position = src->position[from + i];
+            const unsigned int line = SCANNER_TOKEN_LINE(position);
+            const unsigned int col = SCANNER_TOKEN_COL(position) + (line == first_line ? col_shift : 0);
+
+            stream->position[stream->n + i] = SCANNER_TOKEN_POSITION(line + line_shift, col);
+        }
+    }
+
+    if (stream->track_reach) {
+        memcpy(stream->reach + stream->n, src->reach + from, n * sizeof(unsigned int));
+    }
+
+    stream->n += n;
+
+    if (!stream->lazy_positions) {
+        _token_stream_count_from_last(stream);
+    }
+}
+
+void scanner_token_stream_splice(struct scanner_token_stream * const stream,
+                                 const unsigned int from,
+                                 const unsigned int to,
+                                 struct scanner_token_stream * const src,
+                                 const long long delta) {
+    const unsigned int n_src = src->n;
+    const unsigned int n_tail = stream->n - to;
+    const unsigned int tail = from + n_src;
+
+    // the tail moves by whole lines, except the tokens on its first line
+    unsigned int first_line = 0;
+    unsigned int line_shift = 0;
+    unsigned int col_shift = 0;
+
+    if (!stream->lazy_positions && n_tail > 0) {
+        const unsigned int sync = (unsigned int)(stream->start[to] + delta);
+        _token_stream_count_newlines(src, sync);
+
+        first_line = SCANNER_TOKEN_LINE(stream->position[to]);
+        line_shift = src->_line - first_line;
+        col_shift = (sync - src->_line_start) - SCANNER_TOKEN_COL(stream->position[to]);
+    }
+
+    _token_stream_reserve(stream, tail + n_tail);
+
+    memmove(stream->start + tail, stream->start + to, n_tail * sizeof(unsigned int));
+    memmove(stream->length + tail, stream->length + to, n_tail * sizeof(unsigned int));
+    memmove(stream->token + tail, stream->token + to, n_tail * sizeof(unsigned short));
+    memmove(stream->position + tail, stream->position + to, n_tail * sizeof(unsigned long long));
+    memmove(stream->reach + tail, stream->reach + to, n_tail * sizeof(unsigned int));
+
+    memcpy(stream->start + from, src->start, n_src * sizeof(unsigned int));
+    memcpy(stream->length + from, src->length, n_src * sizeof(unsigned int));
+    memcpy(stream->token + from, src->token, n_src * sizeof(unsigned short));
+    memcpy(stream->position + from, src->position, n_src * sizeof(unsigned long long));
+    memcpy(stream->reach + from, src->reach, n_src * sizeof(unsigned int));
+
+    for (unsigned int i = tail; i < tail + n_tail; i++) {
+        stream->start[i] += delta;
+
+        if (stream->track_reach) {
+            // the reach stays non-decreasing, a token can't reach less than the ones before it
+            stream->reach[i] += delta;
+            if (i > 0 && stream->reach[i] < stream->reach[i - 1]) {
+                stream->reach[i] = stream->reach[i - 1];
+            }
+        }
+
+        if (!stream->lazy_positions) {
+            const unsigned int line = SCANNER_TOKEN_LINE(stream->position[i]);
+            const unsigned int col = SCANNER_TOKEN_COL(stream->position[i]) + (line == first_line ? col_shift : 0);
+            stream->position[i] = SCANNER_TOKEN_POSITION(line + line_shift, col);
+        }
+    }
+
+    stream->n = tail + n_tail;
+    stream->source = src->source;
+    stream->source_n = src->source_n;
+
+    // the line index belongs to the old source
+    scanner_line_index_destroy(stream->_line_index);
+    stream->_line_index = NULL;
+
+    if (!stream->lazy_positions) {
+        _token_stream_count_from_last(stream);
+    }
+}
+
+void scanner_token_stream_push(struct scanner_token_stream * const stream,
+                               const unsigned int start,
+                               const unsigned int length,
+                               const unsigned short token) {
+    if (stream->n == stream->_capacity) {
+        _token_stream_realloc(stream, 2 * stream->_capacity);
+    }
+
+    unsigned int i = stream->n++;
+    stream->start[i] = start;
+    stream->length[i] = length;
+    stream->token[i] = token;
+
+    if (stream->lazy_positions) {
+        return;
+    }
+
+    // counting the newlines between the previous token and this one
+    _token_stream_count_newlines(stream, start);
+
+    stream->position[i] = SCANNER_TOKEN_POSITION(stream->_line, start - stream->_line_start);
+}
+
+unsigned long long scanner_token_stream_position(struct scanner_token_stream * const stream, const unsigned int i) {
+    if (!stream->lazy_positions) {
+        return stream->position[i];
+    }
+
+    if (stream->_line_index == NULL) {
+        stream->_line_index = scanner_line_index_create(stream->source, stream->source_n);
+    }
+
+    unsigned int line = scanner_line_index_line(stream->_line_index, stream->start[i]);
+
+    return SCANNER_TOKEN_POSITION(line, stream->start[i] - stream->_line_index->line_start[line - 1]);
+}
@@ -0,0 +1,159 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <stdio.h>
+
+#include <scanner_utils/comb.h>
+#include <scanner_utils/rules.h>
+
+/**
+ * Every transition of the comb has to be the same as in the dense table.
+ */
+static void assert_same_transitions(const struct scanner_dfa * const dfa, const struct scanner_comb * const comb) {
+    assert_int_equal(comb->n_states, dfa->n_states);
+    assert_int_equal(comb->initial_state, dfa->initial_state);
+
+    for (unsigned short state = 0; state < dfa->n_states; state++) {
+        assert_int_equal(comb->token[state], dfa->token[state]);
+
+        for (unsigned int c = 0; c < 256; c++) {
+            assert_int_equal(scanner_comb_get_transition(comb, state, c), scanner_dfa_get_transition(dfa, state, c));
+        }
+    }
+}
+
+static void test_comb_create_from_dfa(void **state) {
+    struct scanner_dfa *dfa = scanner_dfa_create(4);
+    dfa->initial_state = 1;
+    dfa->token[3] = 1;
+    scanner_dfa_set_transition(dfa, 1, 'a', 2);
+    scanner_dfa_set_transition(dfa, 1, 'b', 3);
+    scanner_dfa_set_transition(dfa, 2, 'a', 3);
+    scanner_dfa_set_transition(dfa, 3, 0xFF, 3);
+
+    struct scanner_comb *comb = scanner_comb_create_from_dfa(dfa);
+
+    assert_same_transitions(dfa, comb);
+
+    // 4 transitions, every row shifted into the same 256 + max base entries
+    assert_true(comb->n_entries < 2 * 256);
+
+    scanner_comb_destroy(comb);
+    scanner_dfa_destroy(dfa);
+}
+
+static void test_comb_default_row(void **state) {
+    // states 1 and 2 have the same transitions on the digits, 2 has an extra `x`
+    struct scanner_dfa *dfa = scanner_dfa_create(4);
+    dfa->initial_state = 1;
+    dfa->token[3] = 1;
+    for (unsigned char c = '0'; c <= '9'; c++) {
+        scanner_dfa_set_transition(dfa, 1, c, 3);
+        scanner_dfa_set_transition(dfa, 2, c, 3);
+    }
+    scanner_dfa_set_transition(dfa, 2, 'x', 1);
+
+    struct scanner_comb *comb = scanner_comb_create_from_dfa(dfa);
+
+    assert_int_equal(comb->default_state[1], SCANNER_COMB_NO_DEFAULT);
+    assert_int_equal(comb->default_state[2], 1);
+    assert_same_transitions(dfa, comb);
+
+    scanner_comb_destroy(comb);
+    scanner_dfa_destroy(dfa);
+}
+
+static void test_comb_rules(void **state) {
+    struct scanner_rules *rules = scanner_rules_create();
+    scanner_rules_add(rules, "REGISTER", "r[0-9]+");
+    scanner_rules_add(rules, "MOV", "mov");
+    scanner_rules_add(rules, "MOVS", "movs");
+    scanner_rules_add(rules, "ADD", "add");
+    scanner_rules_add(rules, "IDENTIFIER", "([a-z]|[A-Z])([a-z]|[A-Z]|[0-9])*");
+    scanner_rules_add(rules, "IMMEDIATE", "#[0-9]+");
+    scanner_rules_add(rules, "COMMENT", "\"//\"([a-z]|[A-Z]|[0-9]|_| |\t|,|#|/|:)*\n");
+
+    struct scanner_dfa *dfa = scanner_rules_compile(rules, NULL);
+    struct scanner_comb *comb = scanner_comb_create_from_dfa(dfa);
+
+    assert_same_transitions(dfa, comb);
+    assert_true(scanner_comb_size(comb) < scanner_dfa_table_size(dfa));
+
+    scanner_comb_destroy(comb);
+    scanner_dfa_destroy(dfa);
+    scanner_rules_destroy(rules);
+}
+
+static void test_comb_big(void **state) {
+    // 96 random keywords spelled out in the DFA next to an identifier: hundreds of sparse rows
+    struct scanner_rules *rules = scanner_rules_create();
+    unsigned int seed = 1;
+    char keyword[12];
+    char name[16];
+
+    for (unsigned int i = 0; i < 96; i++) {
+        seed = seed * 1103515245u + 12345u;
+        const unsigned int n = 4 + (seed >> 16) % 7;
+        for (unsigned int c = 0; c < n; c++) {
+            seed = seed * 1103515245u + 12345u;
+            keyword[c] = 'a' + (seed >> 16) % 26;
+        }
+        keyword[n] = '\0';
+
+        snprintf(name, sizeof(name), "KEYWORD_%u", i);
+        scanner_rules_add(rules, name, keyword);
+    }
+    scanner_rules_add(rules, "IDENTIFIER", "([a-z]|[A-Z])([a-z]|[A-Z]|[0-9])*");
+    scanner_rules_add(rules, "NUMBER", "[0-9]+");
+
+    struct scanner_dfa *dfa = scanner_rules_compile(rules, NULL);
+    struct scanner_comb *comb = scanner_comb_create_from_dfa(dfa);
+
+    assert_true(dfa->n_states > 300);
+    assert_same_transitions(dfa, comb);
+    assert_int_equal(scanner_comb_choose_layout(dfa, comb), SCANNER_TABLE_LAYOUT_COMB);
+
+    scanner_comb_destroy(comb);
+    scanner_dfa_destroy(dfa);
+    scanner_rules_destroy(rules);
+}
+
+static void test_comb_choose_layout(void **state) {
+    // small tables stay dense
+    struct scanner_dfa *small = scanner_dfa_create(4);
+    small->initial_state = 1;
+    scanner_dfa_set_transition(small, 1, 'a', 2);
+    struct scanner_comb *small_comb = scanner_comb_create_from_dfa(small);
+
+    assert_int_equal(scanner_comb_choose_layout(small, small_comb), SCANNER_TABLE_LAYOUT_DENSE);
+
+    // a long chain of single transitions is mostly error transitions
+    struct scanner_dfa *chain = scanner_dfa_create(200);
+    chain->initial_state = 1;
+    for (unsigned short s = 1; s < 199; s++) {
+        scanner_dfa_set_transition(chain, s, 'a' + s % 26, s + 1);
+    }
+    chain->token[199] = 1;
+    struct scanner_comb *chain_comb = scanner_comb_create_from_dfa(chain);
+
+    assert_same_transitions(chain, chain_comb);
+    assert_int_equal(scanner_comb_choose_layout(chain, chain_comb), SCANNER_TABLE_LAYOUT_COMB);
+
+    scanner_comb_destroy(small_comb);
+    scanner_dfa_destroy(small);
+    scanner_comb_destroy(chain_comb);
+    scanner_dfa_destroy(chain);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_comb_create_from_dfa),
+        cmocka_unit_test(test_comb_default_row),
+        cmocka_unit_test(test_comb_rules),
+        cmocka_unit_test(test_comb_big),
+        cmocka_unit_test(test_comb_choose_layout),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
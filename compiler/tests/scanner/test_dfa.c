@@ -0,0 +1,236 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <cutils/string.h>
+#include <scanner_utils/dfa.h>
+#include <scanner_utils/regex_parser.h>
+
+#include "test_utils.h"
+
+/**
+ * Runs the DFA on the string, returns the last state.
+ */
+static unsigned short dfa_run(const struct scanner_dfa * const dfa, const char * const str) {
+    unsigned short current_state = dfa->initial_state;
+
+    for (const char *c = str; *c != '\0'; c++) {
+        current_state = scanner_dfa_get_transition(dfa, current_state, *c);
+    }
+
+    return current_state;
+}
+
+static void test_dfa_create(void **state) {
+    struct scanner_dfa *dfa = scanner_dfa_create(3);
+
+    assert_int_equal(dfa->n_states, 3);
+    assert_int_equal(dfa->initial_state, SCANNER_DFA_STATE_ERROR);
+
+    for (unsigned int i = 0; i < 3 * 256; i++) {
+        assert_int_equal(dfa->transition[i], SCANNER_DFA_STATE_ERROR);
+    }
+
+    scanner_dfa_set_transition(dfa, 1, 'a', 2);
+    scanner_dfa_set_transition(dfa, 2, 0xFF, 2);
+    assert_int_equal(scanner_dfa_get_transition(dfa, 1, 'a'), 2);
+    assert_int_equal(scanner_dfa_get_transition(dfa, 2, 0xFF), 2);
+    assert_int_equal(scanner_dfa_get_transition(dfa, 2, 'a'), 0);
+
+    scanner_dfa_destroy(dfa);
+}
+
+static void test_dfa_create_from_fa(void **state) {
+    struct scanner_dfa *dfa = dfa_from_regex("r[0-9]+");
+
+    assert_int_equal(dfa->token[dfa_run(dfa, "r")], 0);
+    assert_int_equal(dfa->token[dfa_run(dfa, "r0")], 1);
+    assert_int_equal(dfa->token[dfa_run(dfa, "r42")], 1);
+    assert_int_equal(dfa_run(dfa, "x"), SCANNER_DFA_STATE_ERROR);
+    assert_int_equal(dfa_run(dfa, "r4x"), SCANNER_DFA_STATE_ERROR);
+
+    // bytes outside of ASCII never transition
+    assert_int_equal(scanner_dfa_get_transition(dfa, dfa->initial_state, 0xF2), SCANNER_DFA_STATE_ERROR);
+
+    scanner_dfa_destroy(dfa);
+}
+
+static void test_dfa_minimize(void **state) {
+    struct cutils_string *rgx = cutils_string_create_from("([a-z]|[A-Z])([a-z]|[A-Z]|[0-9])*");
+    struct scanner_regex_tree_node *root;
+    scanner_regex_parse(rgx, &root);
+
+    struct scanner_fa_128 *fa = scanner_fa_thompson_from_regex(root);
+    scanner_fa_nfa_to_dfa(fa);
+    struct scanner_dfa *dfa = scanner_dfa_create_from_fa(fa, 1);
+
+    // the subset construction separates lower case, upper case and digit states
+    assert_true(dfa->n_states > 3);
+
+    scanner_dfa_minimize(dfa);
+
+    // error state + initial state + identifier body
+    assert_int_equal(dfa->n_states, 3);
+    assert_int_equal(dfa->initial_state, 1);
+    assert_int_equal(dfa->token[1], 0);
+    assert_int_equal(dfa->token[2], 1);
+    assert_int_equal(scanner_dfa_get_transition(dfa, 1, 'q'), 2);
+    assert_int_equal(scanner_dfa_get_transition(dfa, 1, '1'), SCANNER_DFA_STATE_ERROR);
+    assert_int_equal(scanner_dfa_get_transition(dfa, 2, '1'), 2);
+    assert_int_equal(scanner_dfa_get_transition(dfa, 2, 'Q'), 2);
+
+    for (unsigned int c = 0; c < 256; c++) {
+        assert_int_equal(scanner_dfa_get_transition(dfa, SCANNER_DFA_STATE_ERROR, c), SCANNER_DFA_STATE_ERROR);
+    }
+
+    scanner_dfa_destroy(dfa);
+    scanner_fa_destroy(fa);
+    scanner_regex_tree_destroy(root);
+    cutils_string_destroy(rgx);
+}
+
+static void test_dfa_minimize_dead_states(void **state) {
+    // state 2 can't reach an accepting state -> merged into the error state
+    struct scanner_dfa *dfa = scanner_dfa_create(4);
+    dfa->initial_state = 1;
+    dfa->token[3] = 1;
+
+    scanner_dfa_set_transition(dfa, 1, 'a', 2);
+    scanner_dfa_set_transition(dfa, 1, 'b', 3);
+    scanner_dfa_set_transition(dfa, 2, 'a', 2);
+
+    scanner_dfa_minimize(dfa);
+
+    assert_int_equal(dfa->n_states, 3);
+    assert_int_equal(scanner_dfa_get_transition(dfa, 1, 'a'), SCANNER_DFA_STATE_ERROR);
+    assert_int_equal(scanner_dfa_get_transition(dfa, 1, 'b'), 2);
+    assert_int_equal(dfa->token[2], 1);
+
+    scanner_dfa_destroy(dfa);
+}
+
+static void test_dfa_accelerated_register(void **state) {
+    struct scanner_dfa *dfa = dfa_from_regex("r[0-9]+");
+
+    unsigned short digits = dfa_run(dfa, "r12");
+    assert_true(dfa->accelerated[digits]);
+    assert_int_equal(cutils_byteset_size(dfa->self_loop[digits]), 10);
+    assert_true(cutils_byteset_has_element(dfa->self_loop[digits], '7'));
+
+    // states without self-loops
+    assert_false(dfa->accelerated[SCANNER_DFA_STATE_ERROR]);
+    assert_false(dfa->accelerated[dfa->initial_state]);
+    assert_false(dfa->accelerated[dfa_run(dfa, "r")]);
+
+    scanner_dfa_destroy(dfa);
+}
+
+static void test_dfa_accelerated_identifier(void **state) {
+    struct scanner_dfa *dfa = dfa_from_regex("([a-z]|[A-Z])([a-z]|[A-Z]|[0-9])*");
+
+    unsigned short body = dfa_run(dfa, "ab");
+    assert_true(dfa->accelerated[body]);
+    assert_int_equal(cutils_byteset_size(dfa->self_loop[body]), 62);
+    assert_int_equal(dfa->self_loop[body]._n_ranges, 3);
+
+    scanner_dfa_destroy(dfa);
+}
+
+static void test_dfa_accelerated_comment(void **state) {
+    struct scanner_dfa *dfa = dfa_from_regex("\"//\"(.)*");
+
+    unsigned short body = dfa_run(dfa, "// comment");
+    assert_true(dfa->accelerated[body]);
+    assert_int_equal(cutils_byteset_size(dfa->self_loop[body]), 127);
+
+    scanner_dfa_destroy(dfa);
+}
+
+static void test_dfa_accelerated_not_dominant(void **state) {
+    // the `a` loop is only one out of five transitions
+    struct scanner_dfa *dfa = scanner_dfa_create(3);
+    dfa->initial_state = 1;
+
+    scanner_dfa_set_transition(dfa, 1, 'a', 1);
+    scanner_dfa_set_transition(dfa, 1, 'b', 2);
+    scanner_dfa_set_transition(dfa, 1, 'c', 2);
+    scanner_dfa_set_transition(dfa, 1, 'd', 2);
+    scanner_dfa_set_transition(dfa, 1, 'e', 2);
+    scanner_dfa_find_accelerated(dfa);
+
+    assert_false(dfa->accelerated[1]);
+    assert_int_equal(cutils_byteset_size(dfa->self_loop[1]), 1);
+
+    scanner_dfa_destroy(dfa);
+}
+
+static void test_dfa_renumber(void **state) {
+    struct scanner_dfa *dfa = dfa_from_regex("r[0-9]+");
+    assert_int_equal(dfa->n_states, 4);
+
+    // reversing the order of the non-error states
+    const unsigned short order[] = {0, 3, 2, 1};
+    const unsigned short initial_state = dfa->initial_state;
+    scanner_dfa_renumber(dfa, order);
+
+    assert_int_equal(dfa->initial_state, 4 - initial_state);
+    assert_int_equal(dfa->token[dfa_run(dfa, "r")], 0);
+    assert_int_equal(dfa->token[dfa_run(dfa, "r42")], 1);
+    assert_int_equal(dfa_run(dfa, "r4x"), SCANNER_DFA_STATE_ERROR);
+    assert_true(dfa->accelerated[dfa_run(dfa, "r4")]);
+
+    scanner_dfa_destroy(dfa);
+}
+
+static void test_dfa_renumber_bfs(void **state) {
+    // 1 -a-> 3 -a-> 2 (accepting)
+    struct scanner_dfa *dfa = scanner_dfa_create(4);
+    dfa->initial_state = 1;
+    dfa->token[2] = 1;
+    scanner_dfa_set_transition(dfa, 1, 'a', 3);
+    scanner_dfa_set_transition(dfa, 3, 'a', 2);
+
+    scanner_dfa_renumber_bfs(dfa);
+
+    assert_int_equal(dfa->initial_state, 1);
+    assert_int_equal(scanner_dfa_get_transition(dfa, 1, 'a'), 2);
+    assert_int_equal(scanner_dfa_get_transition(dfa, 2, 'a'), 3);
+    assert_int_equal(dfa->token[3], 1);
+
+    scanner_dfa_destroy(dfa);
+}
+
+static void test_dfa_renumber_profile(void **state) {
+    struct scanner_dfa *dfa = dfa_from_regex("a|bc*");
+
+    unsigned int visits[4];
+    scanner_dfa_profile(dfa, "bcccccc", 7, visits);
+    assert_int_equal(visits[dfa->initial_state], 1);
+    assert_int_equal(visits[dfa_run(dfa, "bc")], 7);
+
+    // the `c` loop is the hottest state
+    scanner_dfa_renumber_profile(dfa, "bccccccbccc", 11);
+    assert_int_equal(dfa_run(dfa, "bc"), 1);
+    assert_int_equal(dfa->token[dfa_run(dfa, "a")], 1);
+    assert_int_equal(dfa->token[dfa_run(dfa, "bcc")], 1);
+
+    scanner_dfa_destroy(dfa);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_dfa_create),
+        cmocka_unit_test(test_dfa_create_from_fa),
+        cmocka_unit_test(test_dfa_minimize),
+        cmocka_unit_test(test_dfa_minimize_dead_states),
+        cmocka_unit_test(test_dfa_accelerated_register),
+        cmocka_unit_test(test_dfa_accelerated_identifier),
+        cmocka_unit_test(test_dfa_accelerated_comment),
+        cmocka_unit_test(test_dfa_accelerated_not_dominant),
+        cmocka_unit_test(test_dfa_renumber),
+        cmocka_unit_test(test_dfa_renumber_bfs),
+        cmocka_unit_test(test_dfa_renumber_profile),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
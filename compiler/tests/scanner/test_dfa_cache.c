@@ -0,0 +1,198 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <scanner_utils/dfa_cache.h>
+
+static struct scanner_rules *create_rules(const char * const register_regex) {
+    struct scanner_rules *rules = scanner_rules_create();
+    scanner_rules_define(rules, "DIGIT", "[0-9]");
+    scanner_rules_add(rules, "REGISTER", register_regex);
+    scanner_rules_add(rules, "IDENTIFIER", "([a-z]|[A-Z])([a-z]|[A-Z]|{DIGIT})*");
+    return rules;
+}
+
+static void test_dfa_cache_key(void **state) {
+    struct scanner_rules *a = create_rules("r{DIGIT}+");
+    struct scanner_rules *b = create_rules("r{DIGIT}+");
+    struct scanner_rules *c = create_rules("r{DIGIT}*");
+
+    assert_true(scanner_dfa_cache_key(a) == scanner_dfa_cache_key(b));
+    assert_true(scanner_dfa_cache_key(a) != scanner_dfa_cache_key(c));
+
+    // the build sets the hash of the sources, so a changed generator doesn't load the old DFAs
+    assert_true(scanner_dfa_cache_build() != 0);
+
+    // skip and the backend don't change the DFA
+    b->rules[1].skip = 1;
+    b->backend = SCANNER_BACKEND_DIRECT;
+    assert_true(scanner_dfa_cache_key(a) == scanner_dfa_cache_key(b));
+
+    // a definition that is not a token is not the same as a token
+    struct scanner_rules *d = scanner_rules_create();
+    scanner_rules_add(d, "DIGIT", "[0-9]");
+    scanner_rules_add(d, "REGISTER", "r{DIGIT}+");
+    scanner_rules_add(d, "IDENTIFIER", "([a-z]|[A-Z])([a-z]|[A-Z]|{DIGIT})*");
+    assert_true(scanner_dfa_cache_key(a) != scanner_dfa_cache_key(d));
+
+    scanner_rules_destroy(a);
+    scanner_rules_destroy(b);
+    scanner_rules_destroy(c);
+    scanner_rules_destroy(d);
+}
+
+static void test_dfa_cache_store_load(void **state) {
+    char directory[] = "/tmp/scanner_dfa_cache_XXXXXX";
+    assert_non_null(mkdtemp(directory));
+
+    struct scanner_rules *rules = create_rules("r{DIGIT}+");
+    struct scanner_dfa *dfa = scanner_rules_compile(rules, NULL);
+    const unsigned long long key = scanner_dfa_cache_key(rules);
+
+    assert_null(scanner_dfa_cache_load(directory, key));
+    assert_true(scanner_dfa_cache_store(directory, key, dfa));
+
+    struct scanner_dfa *cached = scanner_dfa_cache_load(directory, key);
+    assert_non_null(cached);
+    assert_int_equal(cached->n_states, dfa->n_states);
+    assert_int_equal(cached->initial_state, dfa->initial_state);
+    assert_memory_equal(cached->transition, dfa->transition, dfa->n_states * 256 * sizeof(unsigned short));
+    assert_memory_equal(cached->token, dfa->token, dfa->n_states * sizeof(unsigned short));
+    assert_memory_equal(cached->accelerated, dfa->accelerated, dfa->n_states);
+
+    assert_null(scanner_dfa_cache_load(directory, key + 1));
+
+    // a truncated file is a miss
+    char path[sizeof(directory) + 32];
+    snprintf(path, sizeof(path), "%s/%016llx.dfa", directory, key);
+    assert_int_equal(truncate(path, 100), 0);
+    assert_null(scanner_dfa_cache_load(directory, key));
+
+    assert_true(scanner_dfa_cache_store(directory, key, dfa));
+    assert_int_equal(scanner_dfa_cache_prune(directory, 60 * 60), 0);
+    assert_int_equal(scanner_dfa_cache_prune(directory, 0), 1);
+    assert_null(scanner_dfa_cache_load(directory, key));
+
+    assert_int_equal(rmdir(directory), 0);
+
+    scanner_dfa_destroy(cached);
+    scanner_dfa_destroy(dfa);
+    scanner_rules_destroy(rules);
+}
+
+/**
+ * The DFAs are the same up to the numbering of the states.
+ */
+static void assert_dfa_equivalent(const struct scanner_dfa * const a, const struct scanner_dfa * const b) {
+    assert_int_equal(a->n_states, b->n_states);
+
+    unsigned short *b_state = calloc(a->n_states, sizeof(unsigned short));
+    unsigned short *queue = malloc(a->n_states * sizeof(unsigned short));
+    unsigned char *visited = calloc(a->n_states, 1);
+    unsigned int queue_n = 0;
+
+    visited[a->initial_state] = 1;
+    b_state[a->initial_state] = b->initial_state;
+    queue[queue_n++] = a->initial_state;
+
+    for (unsigned int i = 0; i < queue_n; i++) {
+        const unsigned short state = queue[i];
+        assert_int_equal(a->token[state], b->token[b_state[state]]);
+
+        for (unsigned int c = 0; c < 256; c++) {
+            const unsigned short next = a->transition[state * 256 + c];
+            const unsigned short b_next = b->transition[b_state[state] * 256 + c];
+
+            if (!visited[next]) {
+                visited[next] = 1;
+                b_state[next] = b_next;
+                queue[queue_n++] = next;
+            }
+            assert_int_equal(b_state[next], b_next);
+        }
+    }
+
+    free(b_state);
+    free(queue);
+    free(visited);
+}
+
+static unsigned int count_files(const char * const directory) {
+    DIR *dir = opendir(directory);
+    unsigned int n = 0;
+
+    for (struct dirent *entry = readdir(dir); entry != NULL; entry = readdir(dir)) {
+        n += entry->d_name[0] != '.';
+    }
+
+    closedir(dir);
+    return n;
+}
+
+static struct scanner_rules *create_assembly_rules(const char * const register_regex) {
+    const char *mnemonics[] = {"mov", "add", "sub", "bx", "push", "pop", "ldr", "str"};
+
+    struct scanner_rules *rules = create_rules(register_regex);
+    for (unsigned int i = 0; i < 8; i++) {
+        scanner_rules_add(rules, mnemonics[i], mnemonics[i]);
+    }
+
+    return rules;
+}
+
+static void test_dfa_cache_rules(void **state) {
+    char directory[] = "/tmp/scanner_dfa_cache_XXXXXX";
+    assert_non_null(mkdtemp(directory));
+
+    struct scanner_rules *rules = create_assembly_rules("r{DIGIT}+");
+    struct scanner_dfa *expected = scanner_rules_compile(rules, NULL);
+
+    // cold: every rule and combination is stored, warm: the root is loaded
+    rules->dfa_cache = directory;
+    for (unsigned int run = 0; run < 2; run++) {
+        struct scanner_dfa *dfa = scanner_rules_compile(rules, NULL);
+        assert_dfa_equivalent(dfa, expected);
+        scanner_dfa_destroy(dfa);
+    }
+
+    // 10 rule DFAs and 9 combinations
+    assert_int_equal(count_files(directory), 19);
+
+    // a changed and an appended rule: 11 rules, the tree is [[[0 1] [2 3]] [[4 5] [6 7]]] [[8 9] 10]
+    struct scanner_rules *changed = create_assembly_rules("r{DIGIT}*");
+    scanner_rules_add(changed, "NUMBER", "{DIGIT}+");
+
+    scanner_dfa_destroy(expected);
+    expected = scanner_rules_compile(changed, NULL);
+
+    changed->dfa_cache = directory;
+    struct scanner_dfa *dfa = scanner_rules_compile(changed, NULL);
+    assert_dfa_equivalent(dfa, expected);
+
+    // the 2 new rules, the 3 combinations above rule 0, [[8 9] 10] and the root
+    assert_int_equal(count_files(directory), 19 + 7);
+
+    assert_int_equal(scanner_dfa_cache_prune(directory, 0), 26);
+    assert_int_equal(rmdir(directory), 0);
+
+    scanner_dfa_destroy(dfa);
+    scanner_dfa_destroy(expected);
+    scanner_rules_destroy(changed);
+    scanner_rules_destroy(rules);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_dfa_cache_key),
+        cmocka_unit_test(test_dfa_cache_store_load),
+        cmocka_unit_test(test_dfa_cache_rules),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
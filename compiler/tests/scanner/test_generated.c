@@ -0,0 +1,139 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <scanner_utils/lang.h>
+#include <scanner_utils/runtime.h>
+
+// generated at build time from test_syntax_file.lang and test_keywords_file.lang (add_generated_scanner)
+#include "keywords_comb.h"
+#include "keywords_direct.h"
+#include "keywords_table.h"
+#include "syntax_comb.h"
+#include "syntax_direct.h"
+#include "syntax_table.h"
+
+/**
+ * The token structs of the generated scanners have the same layout with different prefixes.
+ */
+struct generated_token {
+    unsigned int start;
+    unsigned int length;
+    unsigned short token;
+};
+
+typedef unsigned int (*generated_scan_fn)(const char *text, unsigned int text_n, unsigned int *text_i,
+                                          struct generated_token *tokens, unsigned int capacity);
+
+#define GENERATED_SCAN(prefix)                                                                          \
+    static unsigned int prefix##_generated_scan(const char *text, unsigned int text_n, unsigned int *text_i, \
+                                                struct generated_token *tokens, unsigned int capacity) { \
+        return prefix##_scan(text, text_n, text_i, (struct prefix##_token *)tokens, capacity);          \
+    }
+
+GENERATED_SCAN(syntax_table)
+GENERATED_SCAN(syntax_direct)
+GENERATED_SCAN(syntax_comb)
+GENERATED_SCAN(keywords_table)
+GENERATED_SCAN(keywords_direct)
+GENERATED_SCAN(keywords_comb)
+
+/**
+ * The tokens of the generated scanners are compared with the runtime cursor on the same text.
+ */
+static void assert_generated(const struct scanner * const scanner,
+                             const generated_scan_fn * const scans,
+                             const unsigned int n_scans,
+                             const char * const text) {
+    const unsigned int text_n = strlen(text);
+
+    struct scanner_cursor *cursor = scanner_cursor_create(scanner);
+    struct scanner_token_stream *expected = scanner_token_stream_create(text, text_n);
+    scanner_cursor_scan(cursor, text, text_n, expected);
+
+    for (unsigned int s = 0; s < n_scans; s++) {
+        struct generated_token tokens[64];
+        unsigned int text_i = 0;
+
+        assert_int_equal(scans[s](text, text_n, &text_i, tokens, 64), expected->n);
+        assert_int_equal(text_i, text_n);
+
+        for (unsigned int i = 0; i < expected->n; i++) {
+            assert_int_equal(tokens[i].start, expected->start[i]);
+            assert_int_equal(tokens[i].length, expected->length[i]);
+            assert_int_equal(tokens[i].token, expected->token[i]);
+        }
+    }
+
+    scanner_token_stream_destroy(expected);
+    scanner_cursor_destroy(cursor);
+}
+
+static void test_generated_scan(void **state) {
+    struct scanner_rules *rules = scanner_lang_load(SCANNER_TEST_LANG_FILE);
+    assert_non_null(rules);
+    struct scanner *scanner = scanner_create_from_rules(rules);
+    scanner_rules_destroy(rules);
+
+    const generated_scan_fn scans[] = {syntax_table_generated_scan, syntax_direct_generated_scan, syntax_comb_generated_scan};
+
+    assert_generated(scanner, scans, 3, "");
+    assert_generated(scanner, scans, 3, "r1 r23 x\tr\n7 abc9 rx2");
+    assert_generated(scanner, scans, 3, "r12!  ?? 4 Zz");
+    assert_generated(scanner, scans, 3, "  \n\t");
+
+    scanner_destroy(scanner);
+}
+
+static void test_generated_keywords(void **state) {
+    struct scanner_rules *rules = scanner_lang_load(SCANNER_TEST_KEYWORDS_LANG_FILE);
+    assert_non_null(rules);
+    struct scanner *scanner = scanner_create_from_rules(rules);
+    scanner_rules_destroy(rules);
+
+    const generated_scan_fn scans[] = {keywords_table_generated_scan, keywords_direct_generated_scan, keywords_comb_generated_scan};
+
+    assert_generated(scanner, scans, 3, "mov r0, r1\nadd r2, r0, #4\nbx lr");
+    assert_generated(scanner, scans, 3, "loop: ldr r00, movs\n  str r3, _b\n  b loop");
+    assert_generated(scanner, scans, 3, "push pop popx pus b bx bxx MOV -> r0r0 #-12");
+    assert_generated(scanner, scans, 3, "sub subb su s ?? r");
+
+    scanner_destroy(scanner);
+}
+
+static void test_generated_names(void **state) {
+    assert_int_equal(SYNTAX_TABLE_N_TOKENS, 5);
+    assert_int_equal(SYNTAX_TABLE_TOKEN_REGISTER, 2);
+    assert_string_equal(syntax_table_token_names[SYNTAX_TABLE_TOKEN_ERROR], "ERROR");
+    assert_string_equal(syntax_direct_token_names[SYNTAX_DIRECT_TOKEN_IDENTIFIER], "IDENTIFIER");
+    assert_true(syntax_direct_token_skip[SYNTAX_DIRECT_TOKEN_WHITESPACE]);
+
+    unsigned short token;
+    assert_int_equal(syntax_table_next_token("r42 ", 4, 0, &token), 3);
+    assert_int_equal(token, SYNTAX_TABLE_TOKEN_REGISTER);
+    assert_int_equal(syntax_direct_next_token("!", 1, 0, &token), 1);
+    assert_int_equal(token, SYNTAX_DIRECT_TOKEN_ERROR);
+    assert_int_equal(syntax_comb_next_token("r42 ", 4, 0, &token), 3);
+    assert_int_equal(token, SYNTAX_COMB_TOKEN_REGISTER);
+
+    // the keywords are reclassified by the emitted keyword table
+    assert_int_equal(keywords_table_next_token("push r1", 7, 0, &token), 4);
+    assert_int_equal(token, KEYWORDS_TABLE_TOKEN_PUSH);
+    assert_int_equal(keywords_direct_next_token("r0,", 3, 0, &token), 2);
+    assert_int_equal(token, KEYWORDS_DIRECT_TOKEN_ZERO);
+    assert_int_equal(keywords_comb_next_token("bxx", 3, 0, &token), 3);
+    assert_int_equal(token, KEYWORDS_COMB_TOKEN_IDENTIFIER);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_generated_scan),
+        cmocka_unit_test(test_generated_keywords),
+        cmocka_unit_test(test_generated_names),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,90 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <string.h>
+
+#include <scanner_utils/keywords.h>
+
+#define TOKEN_IDENTIFIER 1
+
+static const char * const mnemonics[] = {
+    "mov", "add", "sub", "mul", "ldr", "str", "cmp", "b", "bl", "bx", "push", "pop"
+};
+#define N_MNEMONICS (sizeof(mnemonics) / sizeof(mnemonics[0]))
+
+static void test_keywords_empty(void **state) {
+    assert_int_equal(scanner_keywords_classify(NULL, TOKEN_IDENTIFIER, "mov", 3), TOKEN_IDENTIFIER);
+
+    struct scanner_keywords *kw = scanner_keywords_create();
+    scanner_keywords_build(kw);
+    assert_int_equal(scanner_keywords_classify(kw, TOKEN_IDENTIFIER, "mov", 3), TOKEN_IDENTIFIER);
+    scanner_keywords_destroy(kw);
+}
+
+static void test_keywords_classify(void **state) {
+    struct scanner_keywords *kw = scanner_keywords_create();
+
+    for (unsigned int i = 0; i < N_MNEMONICS; i++) {
+        scanner_keywords_add(kw, mnemonics[i], strlen(mnemonics[i]), TOKEN_IDENTIFIER + 1 + i, TOKEN_IDENTIFIER);
+    }
+    scanner_keywords_build(kw);
+
+    assert_int_equal(kw->n_keywords, N_MNEMONICS);
+    assert_true(kw->n_slots >= 2 * N_MNEMONICS);
+    assert_int_equal(kw->min_n, 1);
+    assert_int_equal(kw->max_n, 4);
+
+    for (unsigned int i = 0; i < N_MNEMONICS; i++) {
+        assert_int_equal(scanner_keywords_classify(kw, TOKEN_IDENTIFIER, mnemonics[i], strlen(mnemonics[i])),
+                         TOKEN_IDENTIFIER + 1 + i);
+    }
+
+    // prefixes, extensions and other identifiers stay identifiers
+    assert_int_equal(scanner_keywords_classify(kw, TOKEN_IDENTIFIER, "mo", 2), TOKEN_IDENTIFIER);
+    assert_int_equal(scanner_keywords_classify(kw, TOKEN_IDENTIFIER, "movs", 4), TOKEN_IDENTIFIER);
+    assert_int_equal(scanner_keywords_classify(kw, TOKEN_IDENTIFIER, "label", 5), TOKEN_IDENTIFIER);
+    assert_int_equal(scanner_keywords_classify(kw, TOKEN_IDENTIFIER, "pushes", 6), TOKEN_IDENTIFIER);
+
+    // only the lexemes of the shadowing token are reclassified
+    assert_int_equal(scanner_keywords_classify(kw, TOKEN_IDENTIFIER + 100, "mov", 3), TOKEN_IDENTIFIER + 100);
+
+    scanner_keywords_destroy(kw);
+}
+
+static void test_keywords_perfect(void **state) {
+    struct scanner_keywords *kw = scanner_keywords_create();
+    char literal[4] = {0};
+
+    // every two-letter lowercase word
+    for (unsigned int i = 0; i < 26 * 26; i++) {
+        literal[0] = 'a' + i / 26;
+        literal[1] = 'a' + i % 26;
+        scanner_keywords_add(kw, literal, 2, TOKEN_IDENTIFIER + 1 + i, TOKEN_IDENTIFIER);
+    }
+    scanner_keywords_build(kw);
+
+    unsigned int n_used = 0;
+    for (unsigned int slot = 0; slot < kw->n_slots; slot++) {
+        n_used += kw->token[slot] != 0;
+    }
+    assert_int_equal(n_used, 26 * 26);
+
+    for (unsigned int i = 0; i < 26 * 26; i++) {
+        literal[0] = 'a' + i / 26;
+        literal[1] = 'a' + i % 26;
+        assert_int_equal(scanner_keywords_classify(kw, TOKEN_IDENTIFIER, literal, 2), TOKEN_IDENTIFIER + 1 + i);
+    }
+
+    scanner_keywords_destroy(kw);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_keywords_empty),
+        cmocka_unit_test(test_keywords_classify),
+        cmocka_unit_test(test_keywords_perfect),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,142 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <string.h>
+
+#include <scanner_utils/lang.h>
+
+static void test_lang_parse(void **state) {
+    const char *source =
+        "# comment\n"
+        "\n"
+        "REGISTER : r[0-9]+\n"
+        "  COMMENT:\"//\"(a|b)*\\n  \r\n"
+        "IDENTIFIER : ([a-z]|[A-Z])([a-z]|[A-Z]|[0-9])*\n"
+        "skip  WHITESPACE : ( |\\t|\\n)+\n"
+        "skipped : s";
+
+    struct scanner_rules *rules = scanner_rules_create();
+
+    assert_int_equal(scanner_lang_parse(rules, source, strlen(source)), 0);
+    assert_int_equal(rules->n, 5);
+    assert_string_equal(rules->rules[0].name->_s, "REGISTER");
+    assert_string_equal(rules->rules[0].regex->_s, "r[0-9]+");
+    assert_string_equal(rules->rules[1].name->_s, "COMMENT");
+    assert_string_equal(rules->rules[1].regex->_s, "\"//\"(a|b)*\\n");
+    assert_string_equal(rules->rules[2].name->_s, "IDENTIFIER");
+    assert_false(rules->rules[2].skip);
+    assert_string_equal(rules->rules[3].name->_s, "WHITESPACE");
+    assert_true(rules->rules[3].skip);
+    assert_string_equal(rules->rules[4].name->_s, "skipped");
+    assert_false(rules->rules[4].skip);
+
+    scanner_rules_destroy(rules);
+}
+
+static void test_lang_parse_error(void **state) {
+    struct scanner_rules *rules = scanner_rules_create();
+
+    const char *no_colon = "REGISTER : r[0-9]+\n\nIDENTIFIER [a-z]+\n";
+    assert_int_equal(scanner_lang_parse(rules, no_colon, strlen(no_colon)), 3);
+
+    const char *bad_regex = "# comment\nBROKEN : (ab\n";
+    assert_int_equal(scanner_lang_parse(rules, bad_regex, strlen(bad_regex)), 2);
+
+    const char *empty_name = " : ab\n";
+    assert_int_equal(scanner_lang_parse(rules, empty_name, strlen(empty_name)), 1);
+
+    // the names become C identifiers of the generated scanners
+    const char *not_identifier = "PLUS : \"+\"\na-b : ab\n";
+    assert_int_equal(scanner_lang_parse(rules, not_identifier, strlen(not_identifier)), 2);
+
+    const char *digit_first = "9LIVES : cat\n";
+    assert_int_equal(scanner_lang_parse(rules, digit_first, strlen(digit_first)), 1);
+
+    const char *duplicate = "MINUS : -\nTIMES : x\n\nskip MINUS : m\n";
+    assert_int_equal(scanner_lang_parse(rules, duplicate, strlen(duplicate)), 4);
+
+    const char *duplicate_define = "define DIGIT : [0-9]\ndefine DIGIT : [0-7]\n";
+    assert_int_equal(scanner_lang_parse(rules, duplicate_define, strlen(duplicate_define)), 2);
+
+    scanner_rules_destroy(rules);
+}
+
+static void test_lang_parse_option(void **state) {
+    struct scanner_rules *rules = scanner_rules_create();
+    assert_int_equal(rules->backend, SCANNER_BACKEND_TABLE);
+
+    const char *direct = "%backend direct\nDIGIT : [0-9]\n";
+    assert_int_equal(scanner_lang_parse(rules, direct, strlen(direct)), 0);
+    assert_int_equal(rules->backend, SCANNER_BACKEND_DIRECT);
+    assert_int_equal(rules->n, 1);
+
+    const char *comb = "%backend comb\n";
+    assert_int_equal(scanner_lang_parse(rules, comb, strlen(comb)), 0);
+    assert_int_equal(rules->backend, SCANNER_BACKEND_COMB);
+
+    const char *table = "  %backend   table \n";
+    assert_int_equal(scanner_lang_parse(rules, table, strlen(table)), 0);
+    assert_int_equal(rules->backend, SCANNER_BACKEND_TABLE);
+
+    const char *bad_backend = "\n%backend goto\n";
+    assert_int_equal(scanner_lang_parse(rules, bad_backend, strlen(bad_backend)), 2);
+
+    const char *unknown = "%optimize\n";
+    assert_int_equal(scanner_lang_parse(rules, unknown, strlen(unknown)), 1);
+
+    scanner_rules_destroy(rules);
+}
+
+static void test_lang_parse_define(void **state) {
+    const char *source =
+        "define DIGIT : [0-9]\n"
+        "define  ALNUM:[a-z]|{DIGIT}\n"
+        "NUMBER : {DIGIT}+\n"
+        "skip WORD : {ALNUM}+\n"
+        "define : d\n";
+
+    struct scanner_rules *rules = scanner_rules_create();
+
+    assert_int_equal(scanner_lang_parse(rules, source, strlen(source)), 0);
+    assert_int_equal(rules->n, 3);
+    assert_int_equal(rules->n_definitions, 5);
+    assert_string_equal(rules->definitions[1]->name->_s, "ALNUM");
+    assert_string_equal(rules->rules[0].name->_s, "NUMBER");
+    assert_string_equal(rules->rules[0].regex->_s, "{DIGIT}+");
+    assert_true(rules->rules[1].skip);
+    assert_string_equal(rules->rules[2].name->_s, "define");
+
+    const char *unknown = "INTEGER : {DIGITS}+\n";
+    assert_int_equal(scanner_lang_parse(rules, unknown, strlen(unknown)), 1);
+
+    scanner_rules_destroy(rules);
+}
+
+static void test_lang_load(void **state) {
+    struct scanner_rules *rules = scanner_lang_load(SCANNER_TEST_LANG_FILE);
+
+    assert_non_null(rules);
+    assert_int_equal(rules->n, 4);
+    assert_int_equal(rules->n_definitions, 5);
+    assert_string_equal(rules->rules[0].name->_s, "DIGIT");
+    assert_string_equal(rules->rules[1].name->_s, "REGISTER");
+    assert_string_equal(rules->rules[2].name->_s, "IDENTIFIER");
+    assert_true(rules->rules[3].skip);
+
+    scanner_rules_destroy(rules);
+
+    assert_null(scanner_lang_load("/tmp/scanner_lang_does_not_exist.lang"));
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_lang_parse),
+        cmocka_unit_test(test_lang_parse_error),
+        cmocka_unit_test(test_lang_parse_option),
+        cmocka_unit_test(test_lang_parse_define),
+        cmocka_unit_test(test_lang_load),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,174 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <scanner_utils/parallel.h>
+
+#include "test_utils.h"
+
+/**
+ * Lines of assembly with long comments, so that most chunks start inside of a token
+ * that looks like something else (e.g. a comment that contains instructions).
+ */
+static char *create_text(const unsigned int n) {
+    const char *lines[] = {
+        "mov r1, #42\n",
+        "// mov r2, r3 // comment with instructions in it, mov r4, #7\n",
+        "label12 ?? r\n",
+        "  mov   r123456, r0\n\n",
+    };
+
+    char *text = malloc(n + 1);
+    unsigned int text_n = 0;
+    unsigned int seed = 7;
+
+    while (text_n < n) {
+        seed = seed * 1103515245u + 12345u;
+        const char *line = lines[(seed >> 16) % 4];
+        unsigned int line_n = strlen(line);
+
+        if (text_n + line_n > n) {
+            line_n = n - text_n;
+        }
+
+        memcpy(text + text_n, line, line_n);
+        text_n += line_n;
+    }
+
+    return text;
+}
+
+static void assert_same_tokens(struct scanner_token_stream * const stream,
+                               struct scanner_token_stream * const expected) {
+    assert_int_equal(stream->n, expected->n);
+    assert_memory_equal(stream->start, expected->start, expected->n * sizeof(unsigned int));
+    assert_memory_equal(stream->length, expected->length, expected->n * sizeof(unsigned int));
+    assert_memory_equal(stream->token, expected->token, expected->n * sizeof(unsigned short));
+
+    for (unsigned int i = 0; i < expected->n; i++) {
+        assert_int_equal(scanner_token_stream_position(stream, i), scanner_token_stream_position(expected, i));
+    }
+}
+
+static void test_parallel_scan(void **state) {
+    struct scanner *scanner = create_commented_scanner(0, 0);
+    struct scanner_cursor *cursor = scanner_cursor_create(scanner);
+
+    const unsigned int n = 3 * 1024 * 1024 + 17;
+    char *text = create_text(n);
+
+    struct scanner_token_stream *expected = scanner_token_stream_create(text, n);
+    scanner_cursor_scan(cursor, text, n, expected);
+
+    for (unsigned int n_threads = 1; n_threads <= 8; n_threads++) {
+        struct scanner_parallel *parallel = scanner_parallel_create(scanner, n_threads);
+        struct scanner_token_stream *stream = scanner_token_stream_create(text, n);
+
+        scanner_parallel_scan(parallel, text, n, stream);
+        assert_same_tokens(stream, expected);
+
+        // the chunks are reused
+        scanner_token_stream_reset(stream, text, n);
+        scanner_parallel_scan(parallel, text, n, stream);
+        assert_same_tokens(stream, expected);
+
+        scanner_token_stream_destroy(stream);
+        scanner_parallel_destroy(parallel);
+    }
+
+    scanner_token_stream_destroy(expected);
+    scanner_cursor_destroy(cursor);
+    free(text);
+    scanner_destroy(scanner);
+}
+
+static void test_parallel_scan_lazy_positions(void **state) {
+    struct scanner *scanner = create_commented_scanner(0, 0);
+    struct scanner_cursor *cursor = scanner_cursor_create(scanner);
+
+    const unsigned int n = 2 * 1024 * 1024;
+    char *text = create_text(n);
+
+    struct scanner_token_stream *expected = scanner_token_stream_create(text, n);
+    scanner_cursor_scan(cursor, text, n, expected);
+
+    struct scanner_parallel *parallel = scanner_parallel_create(scanner, 4);
+    struct scanner_token_stream *stream = scanner_token_stream_create(text, n);
+    stream->lazy_positions = 1;
+
+    scanner_parallel_scan(parallel, text, n, stream);
+    assert_same_tokens(stream, expected);
+
+    scanner_token_stream_destroy(stream);
+    scanner_parallel_destroy(parallel);
+    scanner_token_stream_destroy(expected);
+    scanner_cursor_destroy(cursor);
+    free(text);
+    scanner_destroy(scanner);
+}
+
+static void test_parallel_scan_skip(void **state) {
+    // the chunks only have the emitted token starts to meet at,
+    // and the uncategorized runs can start before the chunks
+    struct scanner *scanner = create_commented_scanner(0, 1);
+    scanner->coalesce_errors = 1;
+    struct scanner_cursor *cursor = scanner_cursor_create(scanner);
+
+    const unsigned int n = 2 * 1024 * 1024 + 3;
+    char *text = create_text(n);
+
+    struct scanner_token_stream *expected = scanner_token_stream_create(text, n);
+    scanner_cursor_scan(cursor, text, n, expected);
+
+    struct scanner_parallel *parallel = scanner_parallel_create(scanner, 5);
+    struct scanner_token_stream *stream = scanner_token_stream_create(text, n);
+
+    scanner_parallel_scan(parallel, text, n, stream);
+    assert_same_tokens(stream, expected);
+
+    scanner_token_stream_destroy(stream);
+    scanner_parallel_destroy(parallel);
+    scanner_token_stream_destroy(expected);
+    scanner_cursor_destroy(cursor);
+    free(text);
+    scanner_destroy(scanner);
+}
+
+static void test_parallel_scan_one_token(void **state) {
+    struct scanner *scanner = create_commented_scanner(0, 0);
+    struct scanner_parallel *parallel = scanner_parallel_create(scanner, 4);
+
+    // a single comment over every chunk: every chunk has to re-synchronize until the end
+    const unsigned int n = 2 * 1024 * 1024;
+    char *text = malloc(n);
+    memset(text, 'a', n);
+    text[0] = '/';
+    text[1] = '/';
+    text[n - 1] = '\n';
+
+    struct scanner_token_stream *stream = scanner_token_stream_create(text, n);
+    scanner_parallel_scan(parallel, text, n, stream);
+
+    assert_int_equal(stream->n, 1);
+    assert_int_equal(stream->length[0], n);
+    assert_int_equal(stream->token[0], 6);
+
+    scanner_token_stream_destroy(stream);
+    free(text);
+    scanner_parallel_destroy(parallel);
+    scanner_destroy(scanner);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_parallel_scan),
+        cmocka_unit_test(test_parallel_scan_lazy_positions),
+        cmocka_unit_test(test_parallel_scan_skip),
+        cmocka_unit_test(test_parallel_scan_one_token),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,126 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <string.h>
+
+#include <cutils/string.h>
+#include <scanner_utils/regex_parser.h>
+#include <scanner_utils/regex_prefix.h>
+
+static void analyze(const char * const regex, struct scanner_regex_prefix * const prefix) {
+    struct cutils_string *rgx = cutils_string_create_from(regex);
+    struct scanner_regex_tree_node *root;
+
+    struct SCANNER_REGEX_STATUS status = scanner_regex_parse(rgx, &root);
+    assert_int_equal(status.type, SCANNER_REGEX_SUCCESS);
+
+    scanner_regex_prefix_analyze(root, prefix);
+
+    scanner_regex_tree_destroy(root);
+    cutils_string_destroy(rgx);
+}
+
+static void assert_literal(const struct scanner_regex_prefix * const prefix, const char * const literal) {
+    assert_int_equal(prefix->literal_n, strlen(literal));
+    assert_true(memcmp(prefix->literal, literal, prefix->literal_n) == 0);
+}
+
+static void test_regex_prefix_register(void **state) {
+    struct scanner_regex_prefix prefix;
+    analyze("r[0-9]+", &prefix);
+
+    assert_literal(&prefix, "r");
+    assert_false(prefix.exact);
+    assert_false(prefix.nullable);
+    assert_int_equal(cutils_byteset_size(prefix.first_bytes), 1);
+    assert_true(cutils_byteset_has_element(prefix.first_bytes, 'r'));
+}
+
+static void test_regex_prefix_keyword(void **state) {
+    struct scanner_regex_prefix prefix;
+    analyze("unsigned", &prefix);
+
+    assert_literal(&prefix, "unsigned");
+    assert_true(prefix.exact);
+    assert_false(prefix.nullable);
+
+    analyze("\"while\"", &prefix);
+    assert_literal(&prefix, "while");
+    assert_true(prefix.exact);
+
+    // same literal in every alternative
+    analyze("(if|if)", &prefix);
+    assert_literal(&prefix, "if");
+    assert_true(prefix.exact);
+}
+
+static void test_regex_prefix_identifier(void **state) {
+    struct scanner_regex_prefix prefix;
+    analyze("([a-z]|[A-Z])([a-z]|[A-Z]|[0-9])*", &prefix);
+
+    assert_literal(&prefix, "");
+    assert_false(prefix.exact);
+    assert_false(prefix.nullable);
+    assert_int_equal(cutils_byteset_size(prefix.first_bytes), 52);
+    assert_false(cutils_byteset_has_element(prefix.first_bytes, '0'));
+}
+
+static void test_regex_prefix_alteration(void **state) {
+    struct scanner_regex_prefix prefix;
+    analyze("abc|abd|ab", &prefix);
+
+    assert_literal(&prefix, "ab");
+    assert_false(prefix.exact);
+    assert_int_equal(cutils_byteset_size(prefix.first_bytes), 1);
+
+    analyze("\"//\".*\\n", &prefix);
+    assert_literal(&prefix, "//");
+    assert_false(prefix.exact);
+}
+
+static void test_regex_prefix_nullable(void **state) {
+    struct scanner_regex_prefix prefix;
+
+    // first bytes of `b` are reachable because `a*` can be empty
+    analyze("a*b", &prefix);
+    assert_literal(&prefix, "");
+    assert_false(prefix.nullable);
+    assert_int_equal(cutils_byteset_size(prefix.first_bytes), 2);
+
+    analyze("a?b?", &prefix);
+    assert_true(prefix.nullable);
+
+    analyze("\\e", &prefix);
+    assert_true(prefix.nullable);
+    assert_true(prefix.exact);
+    assert_true(cutils_byteset_isempty(prefix.first_bytes));
+
+    analyze("\\s+", &prefix);
+    assert_int_equal(cutils_byteset_size(prefix.first_bytes), 4);
+    assert_true(cutils_byteset_has_element(prefix.first_bytes, '\n'));
+}
+
+static void test_regex_prefix_rules(void **state) {
+    struct scanner_regex_prefix a, b;
+    analyze("r[0-9]+", &a);
+    analyze("([a-z]|[A-Z])([a-z]|[A-Z]|[0-9])*", &b);
+
+    scanner_regex_prefix_alter(&a, &b);
+
+    assert_literal(&a, "");
+    assert_int_equal(cutils_byteset_size(a.first_bytes), 52);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_regex_prefix_register),
+        cmocka_unit_test(test_regex_prefix_keyword),
+        cmocka_unit_test(test_regex_prefix_identifier),
+        cmocka_unit_test(test_regex_prefix_alteration),
+        cmocka_unit_test(test_regex_prefix_nullable),
+        cmocka_unit_test(test_regex_prefix_rules),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
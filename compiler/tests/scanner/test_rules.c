@@ -0,0 +1,226 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <string.h>
+
+#include <scanner_utils/rules.h>
+
+/**
+ * Runs the DFA on the string, returns the token of the last state.
+ */
+static unsigned short dfa_token(const struct scanner_dfa * const dfa, const char * const str) {
+    unsigned short current_state = dfa->initial_state;
+
+    for (const char *c = str; *c != '\0'; c++) {
+        current_state = scanner_dfa_get_transition(dfa, current_state, *c);
+    }
+
+    return dfa->token[current_state];
+}
+
+static unsigned short classify(const struct scanner_dfa * const dfa,
+                               const struct scanner_keywords * const keywords,
+                               const char * const str) {
+    return scanner_keywords_classify(keywords, dfa_token(dfa, str), str, strlen(str));
+}
+
+static void test_rules_add(void **state) {
+    struct scanner_rules *rules = scanner_rules_create();
+
+    assert_int_equal(scanner_rules_add(rules, "REGISTER", "r[0-9]+").type, SCANNER_REGEX_SUCCESS);
+    assert_int_equal(scanner_rules_add(rules, "MOV", "mov").type, SCANNER_REGEX_SUCCESS);
+    assert_int_not_equal(scanner_rules_add(rules, "BROKEN", "(ab").type, SCANNER_REGEX_SUCCESS);
+
+    assert_int_equal(rules->n, 2);
+    assert_string_equal(rules->rules[0].name->_s, "REGISTER");
+    assert_false(rules->rules[0].prefix.exact);
+    assert_true(rules->rules[1].prefix.exact);
+    assert_int_equal(rules->rules[1].prefix.literal_n, 3);
+
+    scanner_rules_destroy(rules);
+}
+
+static void test_rules_compile_priority(void **state) {
+    struct scanner_rules *rules = scanner_rules_create();
+    scanner_rules_add(rules, "REGISTER", "r[0-9]+");
+    scanner_rules_add(rules, "IDENTIFIER", "([a-z]|[A-Z])([a-z]|[A-Z]|[0-9])*");
+    scanner_rules_add(rules, "NUMBER", "[0-9]+");
+
+    struct scanner_dfa *dfa = scanner_rules_compile(rules, NULL);
+
+    assert_int_equal(dfa_token(dfa, "r1"), 1);
+    assert_int_equal(dfa_token(dfa, "r1234"), 1);
+    assert_int_equal(dfa_token(dfa, "r"), 2);
+    assert_int_equal(dfa_token(dfa, "r1a"), 2);
+    assert_int_equal(dfa_token(dfa, "label0"), 2);
+    assert_int_equal(dfa_token(dfa, "42"), 3);
+    assert_int_equal(dfa_token(dfa, "4a"), 0);
+    assert_int_equal(dfa_token(dfa, ""), 0);
+
+    scanner_dfa_destroy(dfa);
+    scanner_rules_destroy(rules);
+}
+
+static void test_rules_compile_keywords(void **state) {
+    struct scanner_rules *rules = scanner_rules_create();
+    scanner_rules_add(rules, "REGISTER", "r[0-9]+");
+    scanner_rules_add(rules, "MOV", "mov");
+    scanner_rules_add(rules, "ADD", "add");
+    scanner_rules_add(rules, "BX", "bx");
+    scanner_rules_add(rules, "COMMA", ",");
+    scanner_rules_add(rules, "IDENTIFIER", "([a-z]|[A-Z])([a-z]|[A-Z]|[0-9])*");
+
+    struct scanner_dfa *full_dfa = scanner_rules_compile(rules, NULL);
+
+    struct scanner_keywords *keywords;
+    struct scanner_dfa *dfa = scanner_rules_compile(rules, &keywords);
+
+    // the mnemonics went to the hash table, the comma stayed in the DFA
+    assert_non_null(keywords);
+    assert_int_equal(keywords->n_keywords, 3);
+    assert_true(dfa->n_states < full_dfa->n_states);
+
+    const char * const lexemes[] = {"r12", "mov", "add", "bx", ",", "movs", "ad", "b", "x"};
+    for (unsigned int i = 0; i < sizeof(lexemes) / sizeof(lexemes[0]); i++) {
+        assert_int_equal(classify(dfa, keywords, lexemes[i]), dfa_token(full_dfa, lexemes[i]));
+    }
+
+    assert_int_equal(classify(dfa, keywords, "mov"), 2);
+    assert_int_equal(classify(dfa, keywords, ","), 5);
+    assert_int_equal(classify(dfa, keywords, "movs"), 6);
+
+    scanner_keywords_destroy(keywords);
+    scanner_dfa_destroy(dfa);
+    scanner_dfa_destroy(full_dfa);
+    scanner_rules_destroy(rules);
+}
+
+static void test_rules_compile_keywords_shadowed(void **state) {
+    struct scanner_rules *rules = scanner_rules_create();
+    scanner_rules_add(rules, "IDENTIFIER", "([a-z]|[A-Z])([a-z]|[A-Z]|[0-9])*");
+    scanner_rules_add(rules, "MOV", "mov");
+
+    // `mov` can never be recognized, the identifier comes first
+    struct scanner_keywords *keywords;
+    struct scanner_dfa *dfa = scanner_rules_compile(rules, &keywords);
+
+    assert_null(keywords);
+    assert_int_equal(classify(dfa, keywords, "mov"), 1);
+
+    scanner_dfa_destroy(dfa);
+    scanner_rules_destroy(rules);
+}
+
+static void test_rules_compile_keywords_duplicate(void **state) {
+    struct scanner_rules *rules = scanner_rules_create();
+    scanner_rules_add(rules, "ADD", "add");
+    scanner_rules_add(rules, "ADD2", "add");
+    scanner_rules_add(rules, "SUB", "sub");
+    scanner_rules_add(rules, "IDENTIFIER", "([a-z])+");
+
+    // `ADD2` can never be recognized, only `ADD` goes into the keyword table
+    struct scanner_keywords *keywords;
+    struct scanner_dfa *dfa = scanner_rules_compile(rules, &keywords);
+
+    assert_non_null(keywords);
+    assert_int_equal(keywords->n_keywords, 2);
+    assert_int_equal(classify(dfa, keywords, "add"), 1);
+    assert_int_equal(classify(dfa, keywords, "sub"), 3);
+    assert_int_equal(classify(dfa, keywords, "adds"), 4);
+
+    scanner_keywords_destroy(keywords);
+    scanner_dfa_destroy(dfa);
+    scanner_rules_destroy(rules);
+}
+
+static void test_rules_definitions(void **state) {
+    struct scanner_rules *rules = scanner_rules_create();
+
+    assert_int_equal(scanner_rules_define(rules, "DIGIT", "[0-9]").type, SCANNER_REGEX_SUCCESS);
+    assert_int_equal(scanner_rules_define(rules, "LETTER", "[a-z]|[A-Z]|_").type, SCANNER_REGEX_SUCCESS);
+    assert_int_equal(scanner_rules_add(rules, "REGISTER", "r{DIGIT}+").type, SCANNER_REGEX_SUCCESS);
+    assert_int_equal(scanner_rules_add(rules, "IDENTIFIER", "{LETTER}({LETTER}|{DIGIT})*").type, SCANNER_REGEX_SUCCESS);
+    // a rule is a definition as well, quoted and unfinished braces are literals
+    assert_int_equal(scanner_rules_add(rules, "BLOCK", "\"{\"{REGISTER}(,{REGISTER})*}").type, SCANNER_REGEX_SUCCESS);
+    assert_int_equal(scanner_rules_add(rules, "EMPTY", "{}").type, SCANNER_REGEX_SUCCESS);
+    assert_int_equal(scanner_rules_add(rules, "UNKNOWN", "a{NUMBER}").type, SCANNER_REGEX_ERROR_REFERENCE);
+    // references come after the definition
+    assert_int_equal(scanner_rules_add(rules, "LATE", "{LATER}").type, SCANNER_REGEX_ERROR_REFERENCE);
+    assert_int_equal(scanner_rules_define(rules, "LATER", "x").type, SCANNER_REGEX_SUCCESS);
+
+    assert_int_equal(rules->n, 4);
+    assert_int_equal(rules->n_definitions, 7);
+    assert_string_equal(rules->rules[2].name->_s, "BLOCK");
+    assert_true(rules->rules[3].prefix.exact);
+    assert_false(rules->rules[2].prefix.exact);
+    assert_int_equal(rules->rules[2].prefix.literal_n, 2);
+
+    struct scanner_dfa *dfa = scanner_rules_compile(rules, NULL);
+
+    assert_int_equal(dfa_token(dfa, "r1"), 1);
+    assert_int_equal(dfa_token(dfa, "r123"), 1);
+    assert_int_equal(dfa_token(dfa, "r"), 2);
+    assert_int_equal(dfa_token(dfa, "_r1x"), 2);
+    assert_int_equal(dfa_token(dfa, "1x"), 0);
+    assert_int_equal(dfa_token(dfa, "{r1}"), 3);
+    assert_int_equal(dfa_token(dfa, "{r1,r22,r3}"), 3);
+    assert_int_equal(dfa_token(dfa, "{r1,}"), 0);
+    assert_int_equal(dfa_token(dfa, "{}"), 4);
+
+    scanner_dfa_destroy(dfa);
+    scanner_rules_destroy(rules);
+}
+
+static void test_rules_compile_threads(void **state) {
+    struct scanner_rules *rules = scanner_rules_create();
+    scanner_rules_define(rules, "DIGIT", "[0-9]");
+    scanner_rules_add(rules, "REGISTER", "r{DIGIT}+");
+    scanner_rules_add(rules, "MOV", "mov");
+    scanner_rules_add(rules, "ADD", "add");
+    scanner_rules_add(rules, "SUB", "sub");
+    scanner_rules_add(rules, "BX", "bx");
+    scanner_rules_add(rules, "NUMBER", "#?-?{DIGIT}+");
+    scanner_rules_add(rules, "HEX", "0x([0-9]|[a-f])+");
+    scanner_rules_add(rules, "LABEL", "[a-z]+:");
+    scanner_rules_add(rules, "IDENTIFIER", "([a-z]|[A-Z])([a-z]|[A-Z]|{DIGIT})*");
+    scanner_rules_add(rules, "COMMA", ",");
+    scanner_rules_add_skip(rules, "WHITESPACE", "( |\t|\n)+");
+
+    struct scanner_dfa *expected = scanner_rules_compile(rules, NULL);
+
+    // the tree of the combinations doesn't depend on the threads: the same DFA
+    for (unsigned int n_threads = 2; n_threads <= 8; n_threads++) {
+        rules->n_threads = n_threads;
+        struct scanner_dfa *dfa = scanner_rules_compile(rules, NULL);
+
+        assert_int_equal(dfa->n_states, expected->n_states);
+        assert_int_equal(dfa->initial_state, expected->initial_state);
+        assert_memory_equal(dfa->transition, expected->transition, (unsigned int)dfa->n_states * 256 * sizeof(unsigned short));
+        assert_memory_equal(dfa->token, expected->token, dfa->n_states * sizeof(unsigned short));
+
+        scanner_dfa_destroy(dfa);
+    }
+
+    assert_int_equal(dfa_token(expected, "r12"), 1);
+    assert_int_equal(dfa_token(expected, "mov"), 2);
+    assert_int_equal(dfa_token(expected, "loop:"), 8);
+    assert_int_equal(dfa_token(expected, "movs"), 9);
+
+    scanner_dfa_destroy(expected);
+    scanner_rules_destroy(rules);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_rules_add),
+        cmocka_unit_test(test_rules_compile_priority),
+        cmocka_unit_test(test_rules_compile_keywords),
+        cmocka_unit_test(test_rules_compile_keywords_shadowed),
+        cmocka_unit_test(test_rules_compile_keywords_duplicate),
+        cmocka_unit_test(test_rules_definitions),
+        cmocka_unit_test(test_rules_compile_threads),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
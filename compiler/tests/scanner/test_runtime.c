@@ -0,0 +1,776 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <scanner_utils/runtime.h>
+
+#include "test_utils.h"
+
+static void assert_token(struct scanner_token_stream * const stream,
+                         const unsigned int i,
+                         const char * const lexeme,
+                         const unsigned short token) {
+    assert_int_equal(stream->length[i], strlen(lexeme));
+    assert_memory_equal(scanner_token_stream_lexeme(stream, i), lexeme, stream->length[i]);
+    assert_int_equal(stream->token[i], token);
+}
+
+static void test_runtime_create(void **state) {
+    struct scanner *scanner = create_assembly_scanner();
+
+    assert_int_equal(scanner->n_tokens, 8);
+    assert_string_equal(scanner->token_names[0]->_s, "uncategorized");
+    assert_string_equal(scanner->token_names[1]->_s, "REGISTER");
+    assert_non_null(scanner->keywords);
+
+    assert_true(cutils_byteset_has_element(scanner->first_bytes, 'r'));
+    assert_true(cutils_byteset_has_element(scanner->first_bytes, '#'));
+    assert_false(cutils_byteset_has_element(scanner->first_bytes, '1'));
+    assert_int_equal(scanner->required_prefix_n, 0);
+
+    scanner_destroy(scanner);
+}
+
+static void test_runtime_required_prefix(void **state) {
+    struct scanner_rules *rules = scanner_rules_create();
+    scanner_rules_add(rules, "COMMENT", "\"//\"(a|b)*\n");
+    struct scanner *scanner = scanner_create_from_rules(rules);
+    scanner_rules_destroy(rules);
+
+    assert_int_equal(scanner->required_prefix_n, 2);
+    assert_memory_equal(scanner->required_prefix, "//", 2);
+    assert_int_equal(cutils_byteset_size(scanner->first_bytes), 1);
+
+    const char *text = "a / b // ab\n";
+    assert_int_equal(scanner_skip_ahead(scanner, text, strlen(text), 0), 6);
+
+    scanner_destroy(scanner);
+}
+
+static void test_runtime_scan(void **state) {
+    struct scanner *scanner = create_assembly_scanner();
+    struct scanner_cursor *cursor = scanner_cursor_create(scanner);
+
+    const char *text = "mov r1, #42\nadd r12, movs ?";
+    struct scanner_token_stream *stream = scanner_token_stream_create(text, strlen(text));
+
+    scanner_cursor_scan(cursor, text, strlen(text), stream);
+
+    assert_int_equal(stream->n, 15);
+    assert_token(stream, 0, "mov", 2);
+    assert_token(stream, 1, " ", 7);
+    assert_token(stream, 2, "r1", 1);
+    assert_token(stream, 3, ",", 6);
+    assert_token(stream, 5, "#42", 5);
+    assert_token(stream, 6, "\n", 7);
+    assert_token(stream, 7, "add", 3);
+    assert_token(stream, 9, "r12", 1);
+    assert_token(stream, 12, "movs", 4);
+    assert_token(stream, 13, " ", 7);
+    assert_token(stream, 14, "?", 0);
+
+    assert_int_equal(scanner_token_stream_line(stream, 7), 2);
+    assert_int_equal(scanner_token_stream_col(stream, 9), 4);
+
+    scanner_token_stream_destroy(stream);
+    scanner_cursor_destroy(cursor);
+    scanner_destroy(scanner);
+}
+
+static void test_runtime_search(void **state) {
+    struct scanner_rules *rules = scanner_rules_create();
+    scanner_rules_add(rules, "REGISTER", "r[0-9]+");
+    struct scanner *scanner = scanner_create_from_rules(rules);
+    scanner_rules_destroy(rules);
+
+    struct scanner_cursor *cursor = scanner_cursor_create(scanner);
+
+    const char *text = "mov r1, #42 ; add r12, r1, r3 ; bx lr";
+    struct scanner_token_stream *stream = scanner_token_stream_create(text, strlen(text));
+
+    scanner_cursor_search(cursor, text, strlen(text), stream);
+
+    assert_int_equal(stream->n, 4);
+    assert_token(stream, 0, "r1", 1);
+    assert_token(stream, 1, "r12", 1);
+    assert_int_equal(stream->start[1], 18);
+    assert_token(stream, 3, "r3", 1);
+
+    scanner_token_stream_destroy(stream);
+    scanner_cursor_destroy(cursor);
+    scanner_destroy(scanner);
+}
+
+static void test_runtime_quadratic_rollback(void **state) {
+    // every attempt to find `(ab)*c` runs until the end of the text,
+    // without the failed memo this would take ~n^2/4 steps
+    struct scanner_rules *rules = scanner_rules_create();
+    scanner_rules_add(rules, "AB", "ab");
+    scanner_rules_add(rules, "ABC", "(ab)*c");
+    struct scanner *scanner = scanner_create_from_rules(rules);
+    scanner_rules_destroy(rules);
+
+    struct scanner_cursor *cursor = scanner_cursor_create(scanner);
+
+    const unsigned int n = 1000000;
+    char *text = malloc(n);
+    for (unsigned int i = 0; i < n; i++) {
+        text[i] = i % 2 == 0 ? 'a' : 'b';
+    }
+
+    struct scanner_token_stream *stream = scanner_token_stream_create(text, n);
+    stream->lazy_positions = 1;
+
+    scanner_cursor_scan(cursor, text, n, stream);
+
+    assert_int_equal(stream->n, n / 2);
+    for (unsigned int i = 0; i < stream->n; i++) {
+        assert_int_equal(stream->token[i], 1);
+        assert_int_equal(stream->length[i], 2);
+    }
+
+    // the memo doesn't change the longest match
+    text[n - 2] = 'c';
+    scanner_token_stream_reset(stream, text, n - 1);
+    scanner_cursor_scan(cursor, text, n - 1, stream);
+
+    assert_int_equal(stream->n, 1);
+    assert_int_equal(stream->token[0], 2);
+
+    free(text);
+    scanner_token_stream_destroy(stream);
+    scanner_cursor_destroy(cursor);
+    scanner_destroy(scanner);
+}
+
+static void test_runtime_lookahead_memo(void **state) {
+    // lookaheads on both sides of SCANNER_CURSOR_LOOKAHEAD, the memo only starts after it
+    struct scanner_rules *rules = scanner_rules_create();
+    scanner_rules_add(rules, "AB", "ab");
+    scanner_rules_add(rules, "ABC", "(ab)*c");
+    struct scanner *scanner = scanner_create_from_rules(rules);
+    scanner_rules_destroy(rules);
+
+    struct scanner_cursor *cursor = scanner_cursor_create(scanner);
+    char text[4 * SCANNER_CURSOR_LOOKAHEAD + 1];
+
+    for (unsigned int n_pairs = SCANNER_CURSOR_LOOKAHEAD / 2 - 2; n_pairs <= SCANNER_CURSOR_LOOKAHEAD + 2; n_pairs++) {
+        for (unsigned int i = 0; i < n_pairs; i++) {
+            text[2 * i] = 'a';
+            text[2 * i + 1] = 'b';
+        }
+
+        struct scanner_token_stream *stream = scanner_token_stream_create(text, 2 * n_pairs);
+        scanner_cursor_scan(cursor, text, 2 * n_pairs, stream);
+
+        assert_int_equal(stream->n, n_pairs);
+        for (unsigned int i = 0; i < stream->n; i++) {
+            assert_int_equal(stream->token[i], 1);
+            assert_int_equal(stream->start[i], 2 * i);
+        }
+
+        text[2 * n_pairs] = 'c';
+        scanner_token_stream_reset(stream, text, 2 * n_pairs + 1);
+        scanner_cursor_scan(cursor, text, 2 * n_pairs + 1, stream);
+
+        assert_int_equal(stream->n, 1);
+        assert_int_equal(stream->token[0], 2);
+        assert_int_equal(stream->length[0], 2 * n_pairs + 1);
+
+        scanner_token_stream_destroy(stream);
+    }
+
+    scanner_cursor_destroy(cursor);
+    scanner_destroy(scanner);
+}
+
+struct thread_input {
+    const struct scanner *scanner;
+    const char *text;
+    unsigned int text_n;
+    struct scanner_token_stream *stream;
+};
+
+static void *scan_thread(void *arg) {
+    struct thread_input *input = arg;
+    struct scanner_cursor *cursor = scanner_cursor_create(input->scanner);
+
+    for (unsigned int r = 0; r < 20; r++) {
+        scanner_token_stream_reset(input->stream, input->text, input->text_n);
+        scanner_cursor_scan(cursor, input->text, input->text_n, input->stream);
+    }
+
+    scanner_cursor_destroy(cursor);
+    return NULL;
+}
+
+static void test_runtime_threads(void **state) {
+    #define N_THREADS 8
+
+    struct scanner *scanner = create_assembly_scanner();
+
+    const char *lines[] = {"mov r1, #42\n", "add r12, r1, r3\n", "label r\n", "movs ?? add\n"};
+    char *texts[N_THREADS];
+    struct thread_input inputs[N_THREADS];
+    pthread_t threads[N_THREADS];
+
+    // a different text for every thread
+    for (unsigned int t = 0; t < N_THREADS; t++) {
+        texts[t] = malloc(20000);
+        texts[t][0] = '\0';
+        for (unsigned int i = 0; strlen(texts[t]) < 19000; i++) {
+            strcat(texts[t], lines[(i * (t + 1)) % 4]);
+        }
+
+        inputs[t].scanner = scanner;
+        inputs[t].text = texts[t];
+        inputs[t].text_n = strlen(texts[t]);
+        inputs[t].stream = scanner_token_stream_create(texts[t], inputs[t].text_n);
+    }
+
+    for (unsigned int t = 0; t < N_THREADS; t++) {
+        pthread_create(&threads[t], NULL, scan_thread, &inputs[t]);
+    }
+    for (unsigned int t = 0; t < N_THREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+
+    // the same as scanning alone
+    struct scanner_cursor *cursor = scanner_cursor_create(scanner);
+    for (unsigned int t = 0; t < N_THREADS; t++) {
+        struct scanner_token_stream *expected = scanner_token_stream_create(texts[t], inputs[t].text_n);
+        scanner_cursor_scan(cursor, texts[t], inputs[t].text_n, expected);
+
+        assert_int_equal(inputs[t].stream->n, expected->n);
+        assert_memory_equal(inputs[t].stream->start, expected->start, expected->n * sizeof(unsigned int));
+        assert_memory_equal(inputs[t].stream->token, expected->token, expected->n * sizeof(unsigned short));
+
+        scanner_token_stream_destroy(expected);
+        scanner_token_stream_destroy(inputs[t].stream);
+        free(texts[t]);
+    }
+
+    scanner_cursor_destroy(cursor);
+    scanner_destroy(scanner);
+}
+
+static void test_runtime_scan_file(void **state) {
+    struct scanner *scanner = create_assembly_scanner();
+    struct scanner_cursor *cursor = scanner_cursor_create(scanner);
+
+    char path[] = "/tmp/scanner_runtime_XXXXXX";
+    int fd = mkstemp(path);
+    const char *text = "mov r1, #42\nadd r12, movs ?";
+    assert_int_equal(write(fd, text, strlen(text)), strlen(text));
+    close(fd);
+
+    struct scanner_token_stream *stream = scanner_token_stream_create(NULL, 0);
+    struct cutils_mapped_file *file = scanner_cursor_scan_file(cursor, path, stream);
+
+    // scanned in place
+    assert_non_null(file);
+    assert_ptr_equal(stream->source, file->data);
+    assert_int_equal(stream->n, 15);
+    assert_token(stream, 5, "#42", 5);
+    assert_int_equal(scanner_token_stream_line(stream, 7), 2);
+
+    cutils_mapped_file_close(file);
+    unlink(path);
+
+    assert_null(scanner_cursor_scan_file(cursor, path, stream));
+
+    scanner_token_stream_destroy(stream);
+    scanner_cursor_destroy(cursor);
+    scanner_destroy(scanner);
+}
+
+struct collected {
+    unsigned int n;
+    unsigned long long start[256];
+    unsigned int length[256];
+    unsigned short token[256];
+    unsigned long long position[256];
+};
+
+static void collect_tokens(struct scanner_push * const push, void *context) {
+    struct collected *collected = context;
+    struct scanner_token_stream *tokens = push->tokens;
+
+    for (unsigned int i = 0; i < tokens->n; i++) {
+        collected->start[collected->n] = tokens->base_offset + tokens->start[i];
+        collected->length[collected->n] = tokens->length[i];
+        collected->token[collected->n] = tokens->token[i];
+        collected->position[collected->n] = tokens->position[i];
+        collected->n++;
+    }
+}
+
+static void test_runtime_push(void **state) {
+    struct scanner *scanner = create_assembly_scanner();
+    struct scanner_cursor *cursor = scanner_cursor_create(scanner);
+
+    const char *text = "mov r1, #42\nadd r12, movs ?\n  add   r1234567, r1,#7\nlabel\n";
+    const unsigned int text_n = strlen(text);
+
+    struct scanner_token_stream *expected = scanner_token_stream_create(text, text_n);
+    scanner_cursor_scan(cursor, text, text_n, expected);
+
+    // tokens that span the chunks are the same as in one piece
+    const unsigned int chunk_sizes[] = {1, 2, 3, 7, 16, 1000};
+
+    for (unsigned int c = 0; c < sizeof(chunk_sizes) / sizeof(chunk_sizes[0]); c++) {
+        struct collected collected = {0};
+        struct scanner_push *push = scanner_push_create(scanner, collect_tokens, &collected);
+
+        for (unsigned int i = 0; i < text_n; i += chunk_sizes[c]) {
+            const unsigned int n = text_n - i < chunk_sizes[c] ? text_n - i : chunk_sizes[c];
+            scanner_push_feed(push, text + i, n);
+        }
+        scanner_push_finish(push);
+
+        assert_int_equal(collected.n, expected->n);
+        for (unsigned int i = 0; i < expected->n; i++) {
+            assert_int_equal(collected.start[i], expected->start[i]);
+            assert_int_equal(collected.length[i], expected->length[i]);
+            assert_int_equal(collected.token[i], expected->token[i]);
+            assert_int_equal(collected.position[i], expected->position[i]);
+        }
+
+        scanner_push_destroy(push);
+    }
+
+    scanner_token_stream_destroy(expected);
+    scanner_cursor_destroy(cursor);
+    scanner_destroy(scanner);
+}
+
+static void test_runtime_push_bounded_buffer(void **state) {
+    struct scanner *scanner = create_assembly_scanner();
+    struct scanner_push *push = scanner_push_create(scanner, NULL, NULL);
+
+    // only the unfinished token is kept between the chunks
+    const char *chunk = "mov r1, #42\n";
+    unsigned int n_tokens = 0;
+
+    for (unsigned int i = 0; i < 100000; i++) {
+        scanner_push_feed(push, chunk, strlen(chunk));
+        n_tokens += push->tokens->n;
+    }
+    scanner_push_finish(push);
+    n_tokens += push->tokens->n;
+
+    assert_int_equal(n_tokens, 100000 * 7);
+    assert_int_equal(push->_buffer_capacity, 4096);
+    assert_int_equal(SCANNER_TOKEN_LINE(push->tokens->position[push->tokens->n - 1]), 100000);
+
+    scanner_push_destroy(push);
+    scanner_destroy(scanner);
+}
+
+static void test_runtime_pull(void **state) {
+    struct scanner *scanner = create_assembly_scanner();
+    struct scanner_cursor *cursor = scanner_cursor_create(scanner);
+
+    const char *text = "mov r1, #42\nadd r12, movs ?";
+    struct scanner_token_stream *expected = scanner_token_stream_create(text, strlen(text));
+    scanner_cursor_scan(cursor, text, strlen(text), expected);
+
+    struct scanner_pull *pull = scanner_pull_create(scanner, text, strlen(text));
+
+    // lookahead without consuming
+    assert_int_equal(scanner_peek(pull, 0)->token, 2);
+    assert_int_equal(scanner_peek(pull, 2)->token, 1);
+    assert_int_equal(scanner_peek(pull, 14)->token, 0);
+    assert_null(scanner_peek(pull, 15));
+    assert_null(scanner_peek(pull, SCANNER_PULL_RING));
+
+    for (unsigned int i = 0; i < expected->n; i++) {
+        const struct scanner_token *token = scanner_next(pull);
+
+        assert_non_null(token);
+        assert_int_equal(token->start, expected->start[i]);
+        assert_int_equal(token->length, expected->length[i]);
+        assert_int_equal(token->token, expected->token[i]);
+        assert_int_equal(token->position, expected->position[i]);
+    }
+
+    assert_null(scanner_next(pull));
+
+    scanner_pull_destroy(pull);
+    scanner_token_stream_destroy(expected);
+    scanner_cursor_destroy(cursor);
+    scanner_destroy(scanner);
+}
+
+static void test_runtime_pull_ring(void **state) {
+    struct scanner *scanner = create_assembly_scanner();
+    struct scanner_cursor *cursor = scanner_cursor_create(scanner);
+
+    const char *line = "mov r1, #42\nadd r12, r1\n";
+    const unsigned int text_n = 100 * strlen(line);
+    char *text = malloc(text_n + 1);
+    text[0] = '\0';
+    for (unsigned int i = 0; i < 100; i++) {
+        strcat(text, line);
+    }
+
+    struct scanner_token_stream *expected = scanner_token_stream_create(text, text_n);
+    scanner_cursor_scan(cursor, text, text_n, expected);
+
+    // the ring wraps around many times, with the deepest lookahead on every token
+    struct scanner_pull *pull = scanner_pull_create(scanner, text, text_n);
+
+    for (unsigned int i = 0; i < expected->n; i++) {
+        const struct scanner_token *ahead = scanner_peek(pull, SCANNER_PULL_RING - 1);
+
+        if (i + SCANNER_PULL_RING - 1 < expected->n) {
+            assert_non_null(ahead);
+            assert_int_equal(ahead->start, expected->start[i + SCANNER_PULL_RING - 1]);
+        } else {
+            assert_null(ahead);
+        }
+
+        const struct scanner_token *token = scanner_next(pull);
+        assert_int_equal(token->start, expected->start[i]);
+        assert_int_equal(token->position, expected->position[i]);
+        assert_memory_equal(scanner_pull_lexeme(pull, token), scanner_token_stream_lexeme(expected, i), token->length);
+    }
+
+    assert_null(scanner_next(pull));
+
+    scanner_pull_destroy(pull);
+    scanner_token_stream_destroy(expected);
+    free(text);
+    scanner_cursor_destroy(cursor);
+    scanner_destroy(scanner);
+}
+
+static void test_runtime_skip(void **state) {
+    struct scanner *scanner = create_commented_scanner(1, 1);
+    struct scanner *emitting = create_commented_scanner(0, 0);
+
+    // whitespace runs are consumed without the DFA, comments go through it
+    assert_true(scanner->skip[7]);
+    assert_false(scanner->skip[0]);
+    assert_true(cutils_byteset_has_element(scanner->skip_run_bytes, ' '));
+    assert_true(cutils_byteset_has_element(scanner->skip_run_bytes, '\n'));
+    assert_false(cutils_byteset_has_element(scanner->skip_run_bytes, '/'));
+    assert_true(cutils_byteset_isempty(emitting->skip_run_bytes));
+
+    const char *text = "mov r1, #42 // set r one\n  movs r12 ?\n// end\n";
+    const unsigned int text_n = strlen(text);
+
+    struct scanner_cursor *cursor = scanner_cursor_create(scanner);
+    struct scanner_token_stream *stream = scanner_token_stream_create(text, text_n);
+    scanner_cursor_scan(cursor, text, text_n, stream);
+
+    // the same as the emitted tokens without the skipped ones
+    struct scanner_cursor *emitting_cursor = scanner_cursor_create(emitting);
+    struct scanner_token_stream *expected = scanner_token_stream_create(text, text_n);
+    scanner_cursor_scan(emitting_cursor, text, text_n, expected);
+
+    unsigned int n = 0;
+    for (unsigned int i = 0; i < expected->n; i++) {
+        if (expected->token[i] == 6 || expected->token[i] == 7) {
+            continue;
+        }
+
+        assert_int_equal(stream->start[n], expected->start[i]);
+        assert_int_equal(stream->token[n], expected->token[i]);
+        assert_int_equal(stream->position[n], expected->position[i]);
+        n++;
+    }
+    assert_int_equal(stream->n, n);
+    assert_int_equal(n, 7);
+    assert_token(stream, 4, "movs", 3);
+    assert_int_equal(scanner_token_stream_line(stream, 4), 2);
+    assert_int_equal(scanner_token_stream_col(stream, 4), 2);
+    assert_token(stream, 6, "?", 0);
+
+    // search and pull skip them too
+    scanner_token_stream_reset(stream, text, text_n);
+    scanner_cursor_search(cursor, text, text_n, stream);
+    assert_int_equal(stream->n, 6);
+
+    struct scanner_pull *pull = scanner_pull_create(scanner, text, text_n);
+    for (unsigned int i = 0; i < n; i++) {
+        assert_non_null(scanner_next(pull));
+    }
+    assert_null(scanner_next(pull));
+    scanner_pull_destroy(pull);
+
+    scanner_token_stream_destroy(expected);
+    scanner_token_stream_destroy(stream);
+    scanner_cursor_destroy(emitting_cursor);
+    scanner_cursor_destroy(cursor);
+    scanner_destroy(emitting);
+    scanner_destroy(scanner);
+}
+
+static void test_runtime_coalesce_errors(void **state) {
+    struct scanner *scanner = create_assembly_scanner();
+    scanner->coalesce_errors = 1;
+
+    struct scanner_cursor *cursor = scanner_cursor_create(scanner);
+
+    const char text[] = "mov \x01\x02\xff?? r1,\x80#42?";
+    const unsigned int text_n = sizeof(text) - 1;
+
+    struct scanner_token_stream *stream = scanner_token_stream_create(text, text_n);
+    scanner_cursor_scan(cursor, text, text_n, stream);
+
+    assert_int_equal(stream->n, 9);
+    assert_token(stream, 0, "mov", 2);
+    assert_token(stream, 2, "\x01\x02\xff??", 0);
+    assert_token(stream, 4, "r1", 1);
+    assert_token(stream, 6, "\x80", 0);
+    assert_token(stream, 7, "#42", 5);
+    assert_token(stream, 8, "?", 0);
+
+    // a blob is a single token, also when it is fed in chunks
+    const unsigned int blob_n = 1024 * 1024;
+    char *blob = malloc(blob_n);
+    for (unsigned int i = 0; i < blob_n; i++) {
+        blob[i] = (char)(0x80 | (i * 7));
+    }
+    memcpy(blob + blob_n / 2, " r1 ", 4);
+
+    struct collected collected = {0};
+    struct scanner_push *push = scanner_push_create(scanner, collect_tokens, &collected);
+    for (unsigned int i = 0; i < blob_n; i += 1000) {
+        scanner_push_feed(push, blob + i, blob_n - i < 1000 ? blob_n - i : 1000);
+    }
+    scanner_push_finish(push);
+
+    assert_int_equal(collected.n, 5);
+    assert_int_equal(collected.start[0], 0);
+    assert_int_equal(collected.length[0], blob_n / 2);
+    assert_int_equal(collected.token[2], 1);
+    assert_int_equal(collected.start[4], blob_n / 2 + 4);
+    assert_int_equal(collected.length[4], blob_n / 2 - 4);
+    assert_int_equal(collected.token[4], 0);
+
+    scanner_push_destroy(push);
+    free(blob);
+    scanner_token_stream_destroy(stream);
+    scanner_cursor_destroy(cursor);
+    scanner_destroy(scanner);
+}
+
+/**
+ * Applies the edit to `text` and rescans `stream`, then compares it with a full scan of the new text.
+ * Returns the edited text and the number of rescanned tokens.
+ */
+static char *assert_rescan(struct scanner_cursor * const cursor,
+                           struct scanner_token_stream * const stream,
+                           const char * const text,
+                           const unsigned int offset,
+                           const unsigned int deleted_n,
+                           const char * const inserted,
+                           unsigned int * const n_rescanned) {
+    const unsigned int text_n = strlen(text);
+    const unsigned int inserted_n = strlen(inserted);
+    const unsigned int edited_n = text_n - deleted_n + inserted_n;
+
+    char *edited = malloc(edited_n + 1);
+    memcpy(edited, text, offset);
+    memcpy(edited + offset, inserted, inserted_n);
+    memcpy(edited + offset + inserted_n, text + offset + deleted_n, text_n - offset - deleted_n + 1);
+
+    *n_rescanned = scanner_cursor_rescan(cursor, stream, edited, edited_n, offset, deleted_n, inserted_n);
+
+    struct scanner_cursor *full_cursor = scanner_cursor_create(cursor->scanner);
+    struct scanner_token_stream *full = scanner_token_stream_create(edited, edited_n);
+    full->track_reach = 1;
+    scanner_cursor_scan(full_cursor, edited, edited_n, full);
+
+    assert_int_equal(stream->n, full->n);
+    for (unsigned int i = 0; i < full->n; i++) {
+        assert_int_equal(stream->start[i], full->start[i]);
+        assert_int_equal(stream->length[i], full->length[i]);
+        assert_int_equal(stream->token[i], full->token[i]);
+        assert_int_equal(stream->position[i], full->position[i]);
+    }
+
+    scanner_token_stream_destroy(full);
+    scanner_cursor_destroy(full_cursor);
+
+    return edited;
+}
+
+static void test_runtime_rescan(void **state) {
+    const struct {
+        unsigned int offset;
+        unsigned int deleted_n;
+        const char *inserted;
+    } edits[] = {
+        {4, 2, "r12"},          // replacing a token
+        {3, 1, ""},             // joining two tokens
+        {2, 0, " "},            // splitting a token
+        {13, 0, "\nadd "},      // new line in a comment
+        {12, 0, "/"},           // starting a comment
+        {0, 0, "movs"},         // at the start
+        {0, 5, ""},
+        {20, 0, "\n\n"},        // changing the lines of the rest
+        {30, 3, "?"},           // uncategorized chars
+        {0, 0, ""},
+    };
+
+    for (unsigned char skip = 0; skip < 2; skip++) {
+        struct scanner *scanner = create_commented_scanner(skip, skip);
+        struct scanner_cursor *cursor = scanner_cursor_create(scanner);
+
+        char *text = strdup("mov r1, #42 // set r one\n  movs r12 ?\n// end\nadd r2, r1\n");
+        struct scanner_token_stream *stream = scanner_token_stream_create(text, strlen(text));
+        stream->track_reach = 1;
+        scanner_cursor_scan(cursor, text, strlen(text), stream);
+
+        unsigned int n_rescanned;
+        for (unsigned int e = 0; e < sizeof(edits) / sizeof(edits[0]); e++) {
+            char *edited = assert_rescan(cursor, stream, text, edits[e].offset, edits[e].deleted_n,
+                                         edits[e].inserted, &n_rescanned);
+            free(text);
+            text = edited;
+        }
+
+        // at the end of the text, also when the last token grows
+        char *edited = assert_rescan(cursor, stream, text, strlen(text), 0, "add r", &n_rescanned);
+        free(text);
+        text = assert_rescan(cursor, stream, edited, strlen(edited), 0, "3", &n_rescanned);
+        assert_int_equal(n_rescanned, 1);
+        free(edited);
+
+        // random edits with random pieces of the text, also with coalesced errors
+        const char *pieces[] = {"r", "1", " ", "\n", "//", "#", ",", "mov", "?", "\x80", "x9"};
+        unsigned int seed = 42;
+        scanner->coalesce_errors = 1;
+
+        for (unsigned int e = 0; e < 500; e++) {
+            const unsigned int text_n = strlen(text);
+            seed = seed * 1103515245 + 12345;
+            const unsigned int offset = (seed >> 8) % (text_n + 1);
+            seed = seed * 1103515245 + 12345;
+            const unsigned int deleted_n = (seed >> 8) % 3 < text_n - offset ? (seed >> 8) % 3 : text_n - offset;
+            seed = seed * 1103515245 + 12345;
+            const char *inserted = text_n < 200 ? pieces[(seed >> 8) % (sizeof(pieces) / sizeof(pieces[0]))] : "";
+
+            edited = assert_rescan(cursor, stream, text, offset, deleted_n, inserted, &n_rescanned);
+            free(text);
+            text = edited;
+        }
+
+        scanner_token_stream_destroy(stream);
+        free(text);
+        scanner_cursor_destroy(cursor);
+        scanner_destroy(scanner);
+    }
+}
+
+static void test_runtime_rescan_local(void **state) {
+    struct scanner *scanner = create_assembly_scanner();
+    struct scanner_cursor *cursor = scanner_cursor_create(scanner);
+
+    const char *line = "mov r1, #42\n";
+    const unsigned int line_n = strlen(line);
+    const unsigned int n_lines = 10000;
+
+    char *text = malloc(n_lines * line_n + 1);
+    for (unsigned int i = 0; i < n_lines; i++) {
+        memcpy(text + i * line_n, line, line_n);
+    }
+    text[n_lines * line_n] = '\0';
+
+    struct scanner_token_stream *stream = scanner_token_stream_create(text, n_lines * line_n);
+    stream->track_reach = 1;
+    scanner_cursor_scan(cursor, text, n_lines * line_n, stream);
+
+    // only the tokens around the edit are scanned again
+    unsigned int n_rescanned;
+    char *edited = assert_rescan(cursor, stream, text, 5000 * line_n + 5, 0, "0\n", &n_rescanned);
+    assert_true(n_rescanned <= 4);
+    assert_int_equal(scanner_token_stream_line(stream, stream->n - 1), n_lines + 1);
+
+    free(edited);
+    free(text);
+    scanner_token_stream_destroy(stream);
+    scanner_cursor_destroy(cursor);
+    scanner_destroy(scanner);
+}
+
+static void test_runtime_batch(void **state) {
+    struct scanner *scanner = create_assembly_scanner();
+    struct scanner_cursor *cursor = scanner_cursor_create(scanner);
+    struct scanner_batch *batch = scanner_batch_create(scanner);
+
+    const char *strings[] = {"mov r1, #42", "", "r12", "movs?", "add", "#", "x1 x2 x3", "\n\n"};
+    const unsigned int n_strings = sizeof(strings) / sizeof(strings[0]);
+
+    // many inputs, more than the initial offsets, scanned twice with the same scratch
+    const unsigned int n_inputs = 1000;
+    struct scanner_string_view *inputs = malloc(n_inputs * sizeof(struct scanner_string_view));
+    for (unsigned int i = 0; i < n_inputs; i++) {
+        inputs[i].data = strings[(i * 5) % n_strings];
+        inputs[i].n = strlen(inputs[i].data);
+    }
+
+    struct scanner_token_stream *expected = scanner_token_stream_create(NULL, 0);
+
+    for (unsigned int round = 0; round < 2; round++) {
+        scanner_batch_scan(batch, inputs, n_inputs);
+        assert_int_equal(batch->n_inputs, n_inputs);
+        assert_int_equal(batch->offsets[0], 0);
+
+        for (unsigned int i = 0; i < n_inputs; i++) {
+            scanner_token_stream_reset(expected, inputs[i].data, inputs[i].n);
+            scanner_cursor_scan(cursor, inputs[i].data, inputs[i].n, expected);
+
+            const unsigned int offset = batch->offsets[i];
+            assert_int_equal(batch->offsets[i + 1] - offset, expected->n);
+
+            for (unsigned int t = 0; t < expected->n; t++) {
+                assert_int_equal(batch->tokens->start[offset + t], expected->start[t]);
+                assert_int_equal(batch->tokens->length[offset + t], expected->length[t]);
+                assert_int_equal(batch->tokens->token[offset + t], expected->token[t]);
+            }
+        }
+    }
+
+    assert_int_equal(batch->offsets[1] - batch->offsets[0], 6);
+    assert_memory_equal(scanner_batch_lexeme(batch, inputs, 0, 2), "r1", 2);
+
+    scanner_token_stream_destroy(expected);
+    free(inputs);
+    scanner_batch_destroy(batch);
+    scanner_cursor_destroy(cursor);
+    scanner_destroy(scanner);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_runtime_create),
+        cmocka_unit_test(test_runtime_required_prefix),
+        cmocka_unit_test(test_runtime_scan),
+        cmocka_unit_test(test_runtime_search),
+        cmocka_unit_test(test_runtime_quadratic_rollback),
+        cmocka_unit_test(test_runtime_lookahead_memo),
+        cmocka_unit_test(test_runtime_threads),
+        cmocka_unit_test(test_runtime_scan_file),
+        cmocka_unit_test(test_runtime_push),
+        cmocka_unit_test(test_runtime_push_bounded_buffer),
+        cmocka_unit_test(test_runtime_pull),
+        cmocka_unit_test(test_runtime_pull_ring),
+        cmocka_unit_test(test_runtime_skip),
+        cmocka_unit_test(test_runtime_coalesce_errors),
+        cmocka_unit_test(test_runtime_rescan),
+        cmocka_unit_test(test_runtime_rescan_local),
+        cmocka_unit_test(test_runtime_batch),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -4,10 +4,15 @@
 #include <cmocka.h>
 
 #include <stdio.h>
+#include <stdlib.h>
 
 #include <cutils/set.h>
 #include <cutils/arrayi.h>
+#include <cutils/string.h>
 #include <scanner_utils/fa.h>
+#include <scanner_utils/regex_parser.h>
+
+#include "test_utils.h"
 
 void print_is_accepting(unsigned int *accepting) {
     printf("{");
@@ -469,6 +474,122 @@ static void test_fa_thompson_all(void **state) {
     cutils_arrayi_destroy(next_states);
 }
 
+/**
+ * Simulates the DFA on the whole string, returns whether it ends in an accepting state.
+ */
+static unsigned char dfa_accepts(const struct scanner_fa_128 * const dfa, const char * const str) {
+    unsigned char current_state = dfa->initial_state;
+
+    for (const char *c = str; *c != '\0' && current_state != 0; c++) {
+        current_state = scanner_dfa_next_state(dfa, current_state, *c);
+    }
+
+    return scanner_fa_is_accepting(dfa, current_state);
+}
+
+static void test_fa_thompson_create_set(void **state) {
+    const char digits[] = {'0', '1', '2'};
+    struct scanner_fa_128 *fa = scanner_fa_thompson_create_set(cutils_set128_create_fromlist(digits, 3));
+
+    assert_int_equal(fa->initial_state, 1);
+    assert_int_equal(fa->n_states, 3);
+    assert_int_equal(fa->n_transitions, 3);
+    assert_int_equal(scanner_dfa_next_state(fa, 1, '0'), 2);
+    assert_int_equal(scanner_dfa_next_state(fa, 1, '2'), 2);
+    assert_int_equal(scanner_dfa_next_state(fa, 1, '3'), 0);
+
+    scanner_fa_destroy(fa);
+}
+
+static void test_fa_nfa_eclosure(void **state) {
+    // Thompson create: a|b
+    struct scanner_fa_128 *fa0 = scanner_fa_thompson_create_char('a');
+    struct scanner_fa_128 *fa1 = scanner_fa_thompson_create_char('b');
+
+    scanner_fa_thompson_alter(fa0, fa1);
+
+    struct cutils_set128 closure = scanner_fa_nfa_eclosure(fa0, cutils_set128_create(fa0->initial_state));
+    assert_int_equal(cutils_set128_size(closure), 3);
+    assert_true(cutils_set128_has_element(closure, 5));
+    assert_true(cutils_set128_has_element(closure, 1));
+    assert_true(cutils_set128_has_element(closure, 3));
+
+    closure = scanner_fa_nfa_eclosure(fa0, cutils_set128_create(2));
+    assert_int_equal(cutils_set128_size(closure), 2);
+    assert_true(cutils_set128_has_element(closure, 6));
+
+    scanner_fa_destroy(fa0);
+    scanner_fa_destroy(fa1);
+}
+
+static void test_fa_nfa_to_dfa(void **state) {
+    // Thompson create: a(b|c)*
+    struct scanner_fa_128 *fa0 = scanner_fa_thompson_create_char('a');
+    struct scanner_fa_128 *fa1 = scanner_fa_thompson_create_char('b');
+    struct scanner_fa_128 *fa2 = scanner_fa_thompson_create_char('c');
+
+    scanner_fa_thompson_alter(fa1, fa2);
+    scanner_fa_thompson_close(fa1);
+    scanner_fa_thompson_concat(fa0, fa1);
+
+    struct cutils_set128 *subsets;
+    scanner_fa_nfa_to_dfa_subsets(fa0, &subsets);
+
+    // Engineering a compiler, page 51, Figure 2.7: d0, d1, d2, d3 + error state
+    assert_int_equal(fa0->n_states, 5);
+    assert_int_equal(fa0->initial_state, 1);
+    assert_int_equal(fa0->n_transitions, 7);
+    assert_false(scanner_fa_is_accepting(fa0, 1));
+    assert_true(scanner_fa_is_accepting(fa0, 2));
+    assert_true(scanner_fa_is_accepting(fa0, 3));
+    assert_true(scanner_fa_is_accepting(fa0, 4));
+
+    // d0 = {n0}
+    assert_int_equal(cutils_set128_size(subsets[0]), 1);
+    assert_true(cutils_set128_has_element(subsets[0], 1));
+
+    assert_true(dfa_accepts(fa0, "a"));
+    assert_true(dfa_accepts(fa0, "abccb"));
+    assert_false(dfa_accepts(fa0, ""));
+    assert_false(dfa_accepts(fa0, "b"));
+    assert_false(dfa_accepts(fa0, "aba"));
+
+    free(subsets);
+    scanner_fa_destroy(fa0);
+    scanner_fa_destroy(fa1);
+    scanner_fa_destroy(fa2);
+}
+
+static void test_fa_thompson_from_regex(void **state) {
+    struct scanner_fa_128 *reg = fa_from_regex("r[0-9]+");
+
+    assert_true(dfa_accepts(reg, "r0"));
+    assert_true(dfa_accepts(reg, "r1234"));
+    assert_false(dfa_accepts(reg, "r"));
+    assert_false(dfa_accepts(reg, "0"));
+    assert_false(dfa_accepts(reg, "r1a"));
+    scanner_fa_destroy(reg);
+
+    struct scanner_fa_128 *id = fa_from_regex("([a-z]|[A-Z])([a-z]|[A-Z]|[0-9])*");
+
+    assert_true(dfa_accepts(id, "x"));
+    assert_true(dfa_accepts(id, "camelCase42"));
+    assert_false(dfa_accepts(id, "4ever"));
+    assert_false(dfa_accepts(id, ""));
+    scanner_fa_destroy(id);
+
+    struct scanner_fa_128 *misc = fa_from_regex("\"if\"\\s?(.)+|colou?r|\\e");
+
+    assert_true(dfa_accepts(misc, "if x"));
+    assert_true(dfa_accepts(misc, "ifx"));
+    assert_true(dfa_accepts(misc, "color"));
+    assert_true(dfa_accepts(misc, "colour"));
+    assert_true(dfa_accepts(misc, ""));
+    assert_false(dfa_accepts(misc, "if"));
+    assert_false(dfa_accepts(misc, "colouur"));
+    scanner_fa_destroy(misc);
+}
+
 int main(void) {
     const struct CMUnitTest tests[] = {
         cmocka_unit_test(test_fa_create_destroy),
@@ -485,7 +606,11 @@ int main(void) {
         cmocka_unit_test(test_fa_thompson_alter),
         cmocka_unit_test(test_fa_thompson_concat),
         cmocka_unit_test(test_fa_thompson_close),
-        cmocka_unit_test(test_fa_thompson_all)
+        cmocka_unit_test(test_fa_thompson_all),
+        cmocka_unit_test(test_fa_thompson_create_set),
+        cmocka_unit_test(test_fa_nfa_eclosure),
+        cmocka_unit_test(test_fa_nfa_to_dfa),
+        cmocka_unit_test(test_fa_thompson_from_regex)
     };
     return cmocka_run_group_tests(tests, NULL, NULL);
 }
@@ -0,0 +1,158 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <string.h>
+
+#include <scanner_utils/token_stream.h>
+
+static void test_token_stream_create(void **state) {
+    const char *source = "mov r1, r2";
+    struct scanner_token_stream *stream = scanner_token_stream_create(source, strlen(source));
+
+    assert_ptr_equal(stream->source, source);
+    assert_int_equal(stream->source_n, 10);
+    assert_int_equal(stream->n, 0);
+
+    scanner_token_stream_destroy(stream);
+}
+
+static void test_token_stream_push(void **state) {
+    const char *source = "mov r1, r2";
+    struct scanner_token_stream *stream = scanner_token_stream_create(source, strlen(source));
+
+    scanner_token_stream_push(stream, 0, 3, 2);
+    scanner_token_stream_push(stream, 4, 2, 1);
+    scanner_token_stream_push(stream, 8, 2, 1);
+
+    assert_int_equal(stream->n, 3);
+    assert_int_equal(stream->token[1], 1);
+    assert_int_equal(stream->length[1], 2);
+    assert_memory_equal(scanner_token_stream_lexeme(stream, 1), "r1", 2);
+    assert_memory_equal(scanner_token_stream_lexeme(stream, 2), "r2", 2);
+
+    // the lexemes are views into the source
+    assert_ptr_equal(scanner_token_stream_lexeme(stream, 2), source + 8);
+
+    scanner_token_stream_destroy(stream);
+}
+
+static void test_token_stream_position(void **state) {
+    const char *source = "mov r1, r2\n\nloop:\n    bx lr";
+    struct scanner_token_stream *stream = scanner_token_stream_create(source, strlen(source));
+
+    scanner_token_stream_push(stream, 0, 3, 1);   // mov
+    scanner_token_stream_push(stream, 8, 2, 1);   // r2
+    scanner_token_stream_push(stream, 10, 1, 1);  // \n
+    scanner_token_stream_push(stream, 12, 4, 1);  // loop
+    scanner_token_stream_push(stream, 22, 2, 1);  // bx
+
+    assert_int_equal(scanner_token_stream_line(stream, 0), 1);
+    assert_int_equal(scanner_token_stream_col(stream, 0), 0);
+    assert_int_equal(scanner_token_stream_line(stream, 1), 1);
+    assert_int_equal(scanner_token_stream_col(stream, 1), 8);
+    assert_int_equal(scanner_token_stream_line(stream, 2), 1);
+    assert_int_equal(scanner_token_stream_col(stream, 2), 10);
+    assert_int_equal(scanner_token_stream_line(stream, 3), 3);
+    assert_int_equal(scanner_token_stream_col(stream, 3), 0);
+    assert_int_equal(scanner_token_stream_line(stream, 4), 4);
+    assert_int_equal(scanner_token_stream_col(stream, 4), 4);
+
+    scanner_token_stream_destroy(stream);
+}
+
+static void test_token_stream_grow_and_reset(void **state) {
+    char source[1000];
+    memset(source, 'a', sizeof(source));
+    struct scanner_token_stream *stream = scanner_token_stream_create(source, sizeof(source));
+
+    for (unsigned int i = 0; i < 1000; i++) {
+        scanner_token_stream_push(stream, i, 1, i % 7);
+    }
+
+    assert_int_equal(stream->n, 1000);
+    for (unsigned int i = 0; i < 1000; i++) {
+        assert_int_equal(stream->start[i], i);
+        assert_int_equal(stream->token[i], i % 7);
+        assert_int_equal(scanner_token_stream_col(stream, i), i);
+    }
+
+    const char *other = "x\ny";
+    scanner_token_stream_reset(stream, other, 3);
+    assert_int_equal(stream->n, 0);
+
+    scanner_token_stream_push(stream, 2, 1, 1);
+    assert_int_equal(scanner_token_stream_line(stream, 0), 2);
+    assert_int_equal(scanner_token_stream_col(stream, 0), 0);
+
+    scanner_token_stream_destroy(stream);
+}
+
+static void test_line_index(void **state) {
+    const char *source = "a\n\nbc\nd";
+    struct scanner_line_index *index = scanner_line_index_create(source, strlen(source));
+
+    assert_int_equal(index->n_lines, 4);
+    assert_int_equal(index->line_start[1], 2);
+    assert_int_equal(index->line_start[2], 3);
+    assert_int_equal(index->line_start[3], 6);
+
+    assert_int_equal(scanner_line_index_line(index, 0), 1);
+    assert_int_equal(scanner_line_index_line(index, 1), 1); // the newline belongs to its line
+    assert_int_equal(scanner_line_index_line(index, 2), 2);
+    assert_int_equal(scanner_line_index_line(index, 4), 3);
+    assert_int_equal(scanner_line_index_line(index, 6), 4);
+
+    scanner_line_index_destroy(index);
+}
+
+static void test_token_stream_lazy_position(void **state) {
+    // long lines and runs of empty lines, every char is a token
+    char source[3000];
+    for (unsigned int i = 0; i < sizeof(source); i++) {
+        source[i] = (i % 97 == 0 || (i > 1000 && i < 1100)) ? '\n' : 'x';
+    }
+
+    struct scanner_token_stream *eager = scanner_token_stream_create(source, sizeof(source));
+    struct scanner_token_stream *lazy = scanner_token_stream_create(source, sizeof(source));
+    lazy->lazy_positions = 1;
+
+    unsigned int line = 1, col = 0;
+    for (unsigned int i = 0; i < sizeof(source); i += 3) {
+        scanner_token_stream_push(eager, i, 1, 1);
+        scanner_token_stream_push(lazy, i, 1, 1);
+    }
+
+    for (unsigned int i = 0, t = 0; i < sizeof(source); i++) {
+        if (i % 3 == 0) {
+            assert_int_equal(scanner_token_stream_line(eager, t), line);
+            assert_int_equal(scanner_token_stream_col(eager, t), col);
+            assert_int_equal(scanner_token_stream_line(lazy, t), line);
+            assert_int_equal(scanner_token_stream_col(lazy, t), col);
+            t++;
+        }
+
+        if (source[i] == '\n') {
+            line++;
+            col = 0;
+        } else {
+            col++;
+        }
+    }
+
+    scanner_token_stream_destroy(eager);
+    scanner_token_stream_destroy(lazy);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_token_stream_create),
+        cmocka_unit_test(test_token_stream_push),
+        cmocka_unit_test(test_token_stream_position),
+        cmocka_unit_test(test_token_stream_grow_and_reset),
+        cmocka_unit_test(test_line_index),
+        cmocka_unit_test(test_token_stream_lazy_position),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
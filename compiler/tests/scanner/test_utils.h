@@ -0,0 +1,98 @@
+#ifndef SCANNER_TEST_UTILS_H
+#define SCANNER_TEST_UTILS_H
+
+// Fixtures shared by the scanner tests, include it after <cmocka.h>.
+
+#include <cutils/string.h>
+#include <scanner_utils/dfa.h>
+#include <scanner_utils/fa.h>
+#include <scanner_utils/regex_parser.h>
+#include <scanner_utils/runtime.h>
+
+/**
+ * Thompson NFA of the regex after the subset construction.
+ */
+static inline struct scanner_fa_128 *fa_from_regex(const char * const regex) {
+    struct cutils_string *rgx = cutils_string_create_from(regex);
+    struct scanner_regex_tree_node *root;
+
+    struct SCANNER_REGEX_STATUS status = scanner_regex_parse(rgx, &root);
+    assert_int_equal(status.type, SCANNER_REGEX_SUCCESS);
+
+    struct scanner_fa_128 *fa = scanner_fa_thompson_from_regex(root);
+    scanner_fa_nfa_to_dfa(fa);
+
+    scanner_regex_tree_destroy(root);
+    cutils_string_destroy(rgx);
+
+    return fa;
+}
+
+/**
+ * Minimal DFA of the regex, its accepting states have the token 1.
+ */
+static inline struct scanner_dfa *dfa_from_regex(const char * const regex) {
+    struct scanner_fa_128 *fa = fa_from_regex(regex);
+
+    struct scanner_dfa *dfa = scanner_dfa_create_from_fa(fa, 1);
+    scanner_dfa_minimize(dfa);
+
+    scanner_fa_destroy(fa);
+
+    return dfa;
+}
+
+/**
+ * Tokens: REGISTER 1, MOV 2, ADD 3, IDENTIFIER 4, IMMEDIATE 5, COMMA 6, WHITESPACE 7.
+ */
+static inline struct scanner *create_assembly_scanner() {
+    struct scanner_rules *rules = scanner_rules_create();
+    scanner_rules_add(rules, "REGISTER", "r[0-9]+");
+    scanner_rules_add(rules, "MOV", "mov");
+    scanner_rules_add(rules, "ADD", "add");
+    scanner_rules_add(rules, "IDENTIFIER", "([a-z]|[A-Z])([a-z]|[A-Z]|[0-9])*");
+    scanner_rules_add(rules, "IMMEDIATE", "#[0-9]+");
+    scanner_rules_add(rules, "COMMA", ",");
+    scanner_rules_add(rules, "WHITESPACE", "( |\n)+");
+
+    struct scanner *scanner = scanner_create_from_rules(rules);
+    scanner_rules_destroy(rules);
+
+    return scanner;
+}
+
+/**
+ * Tokens: REGISTER 1, MOV 2, IDENTIFIER 3, IMMEDIATE 4, COMMA 5, COMMENT 6, WHITESPACE 7,
+ * the comments and the whitespace are skip rules if asked.
+ */
+static inline struct scanner *create_commented_scanner(const unsigned char skip_comments,
+                                                       const unsigned char skip_whitespace) {
+    const char *comment = "\"//\"([a-z]|[A-Z]|[0-9]|_| |\t|,|#|/|:)*\n";
+    const char *whitespace = "( |\n)+";
+
+    struct scanner_rules *rules = scanner_rules_create();
+    scanner_rules_add(rules, "REGISTER", "r[0-9]+");
+    scanner_rules_add(rules, "MOV", "mov");
+    scanner_rules_add(rules, "IDENTIFIER", "([a-z]|[A-Z])([a-z]|[A-Z]|[0-9])*");
+    scanner_rules_add(rules, "IMMEDIATE", "#[0-9]+");
+    scanner_rules_add(rules, "COMMA", ",");
+
+    if (skip_comments) {
+        scanner_rules_add_skip(rules, "COMMENT", comment);
+    } else {
+        scanner_rules_add(rules, "COMMENT", comment);
+    }
+
+    if (skip_whitespace) {
+        scanner_rules_add_skip(rules, "WHITESPACE", whitespace);
+    } else {
+        scanner_rules_add(rules, "WHITESPACE", whitespace);
+    }
+
+    struct scanner *scanner = scanner_create_from_rules(rules);
+    scanner_rules_destroy(rules);
+
+    return scanner;
+}
+
+#endif // SCANNER_TEST_UTILS_H